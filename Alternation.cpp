@@ -0,0 +1,83 @@
+#include <map>
+#include <utility>
+#include <algorithm>
+#include "Alternation.h"
+#include "Nfa.h"
+#include "Summary.h"
+
+Alternation::Alternation(std::vector<std::vector<std::unique_ptr<Atom>>> branches)
+: branches{std::move(branches)}
+{ }
+
+void Alternation::add_to_nfa(Nfa& nfa, int32_t from, int32_t to) const {
+	// The leading bytes of each branch are added as a trie, so branches with a common prefix (like the keywords in reset|refused|ready) share its
+	// states. Otherwise the NFA would have a state per keyword for each byte of input, and building the DFA would take that much longer.
+	std::map<std::pair<int32_t, char>, int32_t> trie_children;
+	for (const std::vector<std::unique_ptr<Atom>>& branch : branches) {
+		int32_t current = from;
+		size_t index = 0;
+		char byte;
+		for (; index < branch.size() && branch[index]->get_single_byte(byte); index++) {
+			auto existing = trie_children.find({ current, byte });
+			if (existing != trie_children.end()) {
+				current = existing->second;
+				continue;
+			}
+
+			int32_t next = nfa.addState();
+			branch[index]->add_to_nfa(nfa, current, next);
+			trie_children.emplace(std::make_pair(current, byte), next);
+			current = next;
+		}
+
+		// The rest of the branch (e.g. after the abc of abc\d+) is its own
+		for (; index < branch.size(); index++) {
+			int32_t next = nfa.addState();
+			branch[index]->add_to_nfa(nfa, current, next);
+			current = next;
+		}
+		nfa.addEpsilonTransition(current, to, Assertion::None);
+	}
+}
+
+uint64_t Alternation::get_nfa_size(bool expand_repeats) const {
+	// Branches with a common prefix share its states, so this can be more than are added
+	uint64_t size = 0;
+	for (const std::vector<std::unique_ptr<Atom>>& branch : branches) {
+		size = addLengths(size, getNfaSize(branch, expand_repeats));
+	}
+	return size;
+}
+
+bool Alternation::get_positions(std::vector<ByteSet>& positions_out) const {
+	// Only a group with a single branch (like the (ab) of (ab){3}) is a fixed sequence
+	if (branches.size() != 1) {
+		return false;
+	}
+
+	std::vector<ByteSet> branch_positions;
+	for (const std::unique_ptr<Atom>& atom : branches[0]) {
+		if (!atom->get_positions(branch_positions)) {
+			return false;
+		}
+	}
+
+	positions_out.insert(positions_out.end(), branch_positions.begin(), branch_positions.end());
+	return true;
+}
+
+AtomSummary Alternation::get_summary() const {
+	// A match is a match of any one branch, so it only has what they all have in common
+	AtomSummary summary = summarizeSequence(branches[0]);
+	for (size_t i = 1; i < branches.size(); i++) {
+		AtomSummary branch_summary = summarizeSequence(branches[i]);
+		summary.min_length = std::min(summary.min_length, branch_summary.min_length);
+		summary.max_length = std::max(summary.max_length, branch_summary.max_length);
+		// e.g. error|ERROR still needs an r in some case
+		summary.required_letters = getRequiredLetters(summary) & getRequiredLetters(branch_summary);
+		summary.required_bytes &= branch_summary.required_bytes;
+		summary.has_string_start |= branch_summary.has_string_start;
+		summary.has_string_end |= branch_summary.has_string_end;
+	}
+	return summary;
+}
\ No newline at end of file
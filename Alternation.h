@@ -0,0 +1,19 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include "Atom.h"
+
+// Matches any one of several sequences of atoms, e.g. timeout|refused|reset. A group like (ab) is an alternation with one branch.
+class Alternation : public Atom {
+public:
+	explicit Alternation(std::vector<std::vector<std::unique_ptr<Atom>>> branches);
+	void add_to_nfa(Nfa& nfa, int32_t from, int32_t to) const override;
+	AtomSummary get_summary() const override;
+	uint64_t get_nfa_size(bool expand_repeats) const override;
+	bool get_positions(std::vector<ByteSet>& positions_out) const override;
+
+private:
+	std::vector<std::vector<std::unique_ptr<Atom>>> branches;
+};
\ No newline at end of file
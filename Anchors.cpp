@@ -0,0 +1,154 @@
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/GlobalVariable.h>
+#include "Anchors.h"
+#include "ShiftOr.h"
+#include "Matcher.h"
+#include "TypeProvider.h"
+#include "ConstantProvider.h"
+
+namespace {
+	// Builds a private function with the signature i1 (i8* buf, i64 end), which returns whether buf[end - positions.size(), end) matches positions
+	// (and starts at 0, if is_start_anchored)
+	llvm::Function* buildMatchPositionsFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const std::vector<ByteSet>& positions, bool is_start_anchored) {
+		TypeProvider type_provider(context);
+		ConstantProvider constant_provider(type_provider);
+
+		llvm::FunctionType* match_positions_type = llvm::FunctionType::get(
+			type_provider.getBit(),
+			std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64() }, // buf and end
+			false
+		);
+		llvm::Function* match_positions = llvm::Function::Create(match_positions_type, llvm::Function::PrivateLinkage, "rx_match_positions", &module);
+		llvm::Value* buf = match_positions->args().begin();
+		llvm::Value* end = (match_positions->args().begin() + 1);
+
+		llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", match_positions);
+		llvm::BasicBlock* loop = llvm::BasicBlock::Create(context, "loop", match_positions);
+		llvm::BasicBlock* done = llvm::BasicBlock::Create(context, "done", match_positions);
+		llvm::BasicBlock* too_short = llvm::BasicBlock::Create(context, "too_short", match_positions);
+
+		llvm::GlobalVariable* masks = buildShiftOrMasks(context, module, positions);
+		llvm::Value* num_positions = constant_provider.getInt64(static_cast<uint32_t>(positions.size()));
+
+		builder.SetInsertPoint(entry);
+		llvm::Value* start = builder.CreateSub(end, num_positions);
+		builder.CreateCondBr(is_start_anchored ? builder.CreateICmpEQ(end, num_positions) : builder.CreateICmpUGE(end, num_positions), loop, too_short);
+
+		builder.SetInsertPoint(too_short);
+		builder.CreateRet(constant_provider.getBit(0));
+
+		// The bytes are read like Shift-Or would, and match if the last position's bit is clear after the last of them
+		builder.SetInsertPoint(loop);
+		llvm::PHINode* index = builder.CreatePHI(type_provider.getInt64(), 2);
+		llvm::PHINode* word = builder.CreatePHI(type_provider.getInt64(), 2);
+		index->addIncoming(start, entry);
+		word->addIncoming(constant_provider.getInt64(~uint64_t(0)), entry);
+		llvm::Value* next_word = buildShiftOrStep(context, builder, masks, buf, index, word);
+		llvm::Value* next_index = builder.CreateAdd(index, constant_provider.getInt64(1));
+		index->addIncoming(next_index, loop);
+		word->addIncoming(next_word, loop);
+		builder.CreateCondBr(builder.CreateICmpULT(next_index, end), loop, done);
+
+		builder.SetInsertPoint(done);
+		llvm::Value* last_position_bit = constant_provider.getInt64(uint64_t(1) << (positions.size() - 1));
+		builder.CreateRet(builder.CreateICmpEQ(builder.CreateAnd(next_word, last_position_bit), constant_provider.getInt64(0)));
+
+		return match_positions;
+	}
+}
+
+bool getEndAnchoredPositions(const std::vector<std::unique_ptr<Atom>>& atoms, std::vector<ByteSet>& positions_out, bool& is_start_anchored_out) {
+	size_t first = 0;
+	while (first < atoms.size() && atoms[first]->is_string_start()) {
+		first++;
+	}
+	size_t last = atoms.size();
+	while (last > first && atoms[last - 1]->is_string_end()) {
+		last--;
+	}
+	if (last == atoms.size()) {
+		return false;
+	}
+
+	std::vector<ByteSet> positions;
+	for (size_t i = first; i < last; i++) {
+		if (!atoms[i]->get_positions(positions) || positions.size() > max_shift_or_positions) {
+			return false;
+		}
+	}
+	if (positions.empty()) {
+		return false;
+	}
+
+	positions_out = positions;
+	is_start_anchored_out = first > 0;
+	return true;
+}
+
+llvm::Function* buildEndAnchoredScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const std::vector<ByteSet>& positions, bool is_start_anchored, llvm::Function* scan_function) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::Function* match_positions = buildMatchPositionsFunction(context, builder, module, positions, is_start_anchored);
+
+	llvm::Function* anchored_scan_function = llvm::Function::Create(scan_function->getFunctionType(), llvm::Function::PrivateLinkage, "rx_scan_end_anchored", &module);
+	llvm::Value* buf = anchored_scan_function->args().begin();
+	llvm::Value* len = (anchored_scan_function->args().begin() + 1);
+	llvm::Value* state = (anchored_scan_function->args().begin() + 2);
+	llvm::Value* is_final = (anchored_scan_function->args().begin() + 3);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", anchored_scan_function);
+	llvm::BasicBlock* resume = llvm::BasicBlock::Create(context, "resume", anchored_scan_function);
+	llvm::BasicBlock* whole_input = llvm::BasicBlock::Create(context, "whole_input", anchored_scan_function);
+	llvm::BasicBlock* check_last_byte = llvm::BasicBlock::Create(context, "check_last_byte", anchored_scan_function);
+	llvm::BasicBlock* check_before_newline = llvm::BasicBlock::Create(context, "check_before_newline", anchored_scan_function);
+	llvm::BasicBlock* matched = llvm::BasicBlock::Create(context, "matched", anchored_scan_function);
+	llvm::BasicBlock* failed = llvm::BasicBlock::Create(context, "failed", anchored_scan_function);
+
+	// A scan from the initial state that's told it has the rest of the input gives the same answer as matching buf on its own, even if it's the
+	// last block of a longer input (the DFA can only be back in its initial state if nothing before it can make a difference)
+	builder.SetInsertPoint(entry);
+	builder.CreateCondBr(builder.CreateAnd(is_final, builder.CreateICmpEQ(state, constant_provider.getInt64(scan_initial_state))), whole_input, resume);
+
+	builder.SetInsertPoint(resume);
+	std::vector<llvm::Value*> scan_args;
+	for (llvm::Argument& arg : anchored_scan_function->args()) {
+		scan_args.push_back(&arg);
+	}
+	llvm::CallInst* result = builder.CreateCall(scan_function->getFunctionType(), scan_function, scan_args);
+	result->setTailCall();
+	builder.CreateRet(result);
+
+	// Like $, the match can end at the end of the input or before a newline that ends it
+	builder.SetInsertPoint(whole_input);
+	llvm::Value* at_end = builder.CreateCall(match_positions->getFunctionType(), match_positions, std::vector<llvm::Value*> { buf, len });
+	builder.CreateCondBr(at_end, matched, check_last_byte);
+
+	builder.SetInsertPoint(check_last_byte);
+	llvm::Value* last_index = builder.CreateSub(len, constant_provider.getInt64(1));
+	builder.CreateCondBr(builder.CreateICmpUGT(len, constant_provider.getInt64(0)), check_before_newline, failed);
+
+	builder.SetInsertPoint(check_before_newline);
+	llvm::Value* last_byte = builder.CreateLoad(type_provider.getByte(), builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { last_index }));
+	llvm::Value* before_newline = builder.CreateSelect(
+		builder.CreateICmpEQ(last_byte, constant_provider.getByte('\n')),
+		builder.CreateCall(match_positions->getFunctionType(), match_positions, std::vector<llvm::Value*> { buf, last_index }),
+		constant_provider.getBit(0)
+	);
+	builder.CreateCondBr(before_newline, matched, failed);
+
+	builder.SetInsertPoint(matched);
+	builder.CreateRet(constant_provider.getInt64(scan_matched, true));
+
+	builder.SetInsertPoint(failed);
+	builder.CreateRet(constant_provider.getInt64(scan_failed, true));
+
+	return anchored_scan_function;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include "Atom.h"
+
+// Regexes anchored to the end of the input like abc$ or ^\d{4}$ can only match in one place, so when the whole input is in memory there's no need
+// to read all of it. (Those anchored to the start already stop as soon as their first bytes don't match.)
+
+// Returns whether atoms are a fixed sequence of classes (see getShiftOrPositions) followed by $, with or without ^ before them, and sets
+// positions_out to the classes and is_start_anchored_out to whether there's a ^ if so
+bool getEndAnchoredPositions(const std::vector<std::unique_ptr<Atom>>& atoms, std::vector<ByteSet>& positions_out, bool& is_start_anchored_out);
+
+// Builds a scan function (see scan_function_name) that checks positions only against the bytes just before the end of buf (or before the newline
+// that ends it) when it's given all of the input at once, i.e. from scan_initial_state with is_final set. Otherwise (when reading the input in
+// blocks) it passes its arguments on to scan_function.
+llvm::Function* buildEndAnchoredScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const std::vector<ByteSet>& positions, bool is_start_anchored, llvm::Function* scan_function);
@@ -1,7 +1,58 @@
 #pragma once
-#include <llvm/IR/Function.h>
+#include <bitset>
+#include <vector>
+#include <cstdint>
+
+class Nfa;
+
+// A set of bytes, indexed by their unsigned value
+using ByteSet = std::bitset<256>;
+
+// Lengths too long to track (like that of a+) are capped at this
+const uint64_t unbounded_length = UINT64_MAX;
+
+// What every match of an atom has in common, which lets inputs that can't match be rejected without scanning them (see Summary.h)
+struct AtomSummary {
+	// The fewest and the most bytes a match can be
+	uint64_t min_length;
+	uint64_t max_length;
+	// The bytes that are in every match
+	ByteSet required_bytes;
+	// The ASCII letters (by their lowercase byte) that are in every match, in either case
+	ByteSet required_letters;
+	// Whether the atom has a ^ anywhere in it
+	bool has_string_start;
+	// Whether the atom has a $ anywhere in it
+	bool has_string_end;
+};
 
 class Atom {
 public:
-	virtual llvm::Function* codegen() = 0;
-};
\ No newline at end of file
+	virtual ~Atom() = default;
+	// Adds the transitions that match this atom to nfa, going from state from to state to
+	virtual void add_to_nfa(Nfa& nfa, int32_t from, int32_t to) const = 0;
+	// Returns what every match of this atom has in common
+	virtual AtomSummary get_summary() const = 0;
+	// Returns how many states add_to_nfa adds to the NFA (at most), or UINT64_MAX if that's more than can be counted. Unless expand_repeats, each
+	// repeat is counted as a single copy of its atom, as it's written in the regex.
+	virtual uint64_t get_nfa_size(bool /* expand_repeats */) const {
+		return 0;
+	}
+	// Returns whether this atom matches exactly one given byte, and sets byte_out to it if so. A case-insensitive letter gives its lowercase byte,
+	// which can't be confused with a case-sensitive one since the literals of a group are all one or the other.
+	virtual bool get_single_byte(char& /* byte_out */) const {
+		return false;
+	}
+	// Returns whether this atom always matches a fixed number of bytes, each from a class of its own (e.g. a literal, [a-f] or \d{4}), and appends
+	// those classes to positions_out if so
+	virtual bool get_positions(std::vector<ByteSet>& /* positions_out */) const {
+		return false;
+	}
+	// Returns whether this atom is ^ or $, which anchor the regex to the start or end of the input
+	virtual bool is_string_start() const {
+		return false;
+	}
+	virtual bool is_string_end() const {
+		return false;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include <map>
+#include <string>
+#include <memory>
+#include <vector>
+#include <llvm/ADT/Optional.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Target/TargetMachine.h>
+#include "Batch.h"
+#include "Matcher.h"
+#include "Emitter.h"
+
+namespace {
+	// What each worker reuses from one regex to the next. None of them can be used by two threads at once, so each worker has its own.
+	struct BatchWorker {
+		std::unique_ptr<llvm::LLVMContext> context;
+		std::unique_ptr<llvm::TargetMachine> target_machine;
+		// A regex compiled with the batch's options and prefix, whose entry points the ones of each regex copy the signatures of. It's in the worker's
+		// context, like the modules it's used for.
+		std::unique_ptr<llvm::Module> entry_template;
+	};
+
+	// How many hex digits of a matcher's cache key go into the names of its entry points
+	const size_t matcher_key_digits = 16;
+
+	std::string getMatcherPrefix(const std::string& key) {
+		return std::string(default_symbol_prefix) + "_" + key.substr(0, matcher_key_digits);
+	}
+
+	// Adds to module an entry point named prefix followed by the suffix of each of entry_template's (which are named template_prefix followed by it),
+	// which tail calls the one named matcher_prefix followed by the same suffix, so it's just a jump to it
+	void buildEntryPoints(llvm::LLVMContext& context, const llvm::Module& entry_template, const std::string& template_prefix, const std::string& matcher_prefix, const std::string& prefix, llvm::Module& module) {
+		llvm::IRBuilder<> builder(context);
+		for (const llvm::Function& function : entry_template) {
+			if (function.isDeclaration() || !function.hasExternalLinkage()) {
+				continue;
+			}
+
+			std::string suffix = function.getName().substr(template_prefix.size()).str();
+			llvm::FunctionType* type = function.getFunctionType();
+			llvm::Function* entry_point = llvm::Function::Create(type, llvm::Function::ExternalLinkage, prefix + suffix, module);
+			llvm::FunctionCallee matcher = module.getOrInsertFunction(matcher_prefix + suffix, type);
+
+			builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", entry_point));
+			std::vector<llvm::Value*> arguments;
+			for (llvm::Argument& argument : entry_point->args()) {
+				arguments.push_back(&argument);
+			}
+			llvm::CallInst* call = builder.CreateCall(matcher, arguments);
+			call->setTailCallKind(llvm::CallInst::TCK_MustTail);
+			if (type->getReturnType()->isVoidTy()) {
+				builder.CreateRetVoid();
+			} else {
+				builder.CreateRet(call);
+			}
+		}
+	}
+}
+
+bool compileBatch(ThreadPool& pool, const std::vector<std::string>& regexes, const CompileOptions& options, const TargetSelection& target, const ObjectCache* cache, BatchObjects& objects_out, std::string& error_out) {
+	std::vector<BatchWorker> workers(pool.getNumThreads());
+	for (BatchWorker& worker : workers) {
+		worker.context = std::make_unique<llvm::LLVMContext>();
+		worker.target_machine = createTargetMachine(target, error_out);
+		if (!worker.target_machine) {
+			return false;
+		}
+	}
+
+	CompileOptions batch_options = options;
+	batch_options.has_byte_shuffle = hasByteShuffle(*workers[0].target_machine);
+	for (BatchWorker& worker : workers) {
+		// This also checks the prefix, which the matchers aren't compiled with
+		worker.entry_template = std::make_unique<llvm::Module>(options.symbol_prefix, *worker.context);
+		if (!compileRegex("", *worker.context, *worker.entry_template, batch_options, error_out)) {
+			return false;
+		}
+	}
+
+	// Matchers are keyed by the regex and the options, but not the batch's prefix or where the regex is in it, so a regex that's in the batch twice
+	// (or in another batch) has the same one
+	CompileOptions matcher_options = batch_options;
+	matcher_options.symbol_prefix = default_symbol_prefix;
+	std::map<std::string, size_t> matcher_ids;
+	std::vector<std::string> matcher_keys;
+	// The first regex with each matcher, which it's compiled from, and the matcher of each regex
+	std::vector<size_t> matcher_regexes;
+	std::vector<size_t> regex_matchers;
+	for (size_t i = 0; i < regexes.size(); i++) {
+		std::string key = getCacheKey(CachedObjectKind::BatchMatcher, { regexes[i] }, false, matcher_options, *workers[0].target_machine, target.opt_level);
+		auto inserted = matcher_ids.emplace(key, matcher_keys.size());
+		if (inserted.second) {
+			matcher_keys.push_back(key);
+			matcher_regexes.push_back(i);
+		}
+		regex_matchers.push_back(inserted.first->second);
+	}
+
+	objects_out.matcher_prefixes.clear();
+	for (const std::string& key : matcher_keys) {
+		objects_out.matcher_prefixes.push_back(getMatcherPrefix(key));
+	}
+
+	// Each task only writes to its own matcher's or regex's entries, so these need no locking
+	objects_out.matchers.assign(matcher_keys.size(), {});
+	objects_out.entry_points.assign(regexes.size(), {});
+	std::vector<llvm::Optional<std::string>> matcher_errors(matcher_keys.size());
+	std::vector<llvm::Optional<std::string>> entry_point_errors(regexes.size());
+	for (size_t i = 0; i < matcher_keys.size(); i++) {
+		pool.submit([&, i]() {
+			std::unique_ptr<llvm::MemoryBuffer> cached_object = cache ? cache->load(matcher_keys[i]) : nullptr;
+			if (cached_object) {
+				objects_out.matchers[i].assign(cached_object->getBufferStart(), cached_object->getBufferEnd());
+				return;
+			}
+
+			BatchWorker& worker = workers[ThreadPool::getCurrentWorker()];
+			CompileOptions regex_options = matcher_options;
+			regex_options.symbol_prefix = objects_out.matcher_prefixes[i];
+
+			// The module goes before the next regex is compiled, but the context keeps the types and constants that they share
+			llvm::Module module(regex_options.symbol_prefix, *worker.context);
+			std::string error;
+			if (!compileRegex(regexes[matcher_regexes[i]], *worker.context, module, regex_options, error)) {
+				matcher_errors[i] = error;
+				return;
+			}
+
+			// Only the batch's entry points are called from outside the library (or the shared library it's linked into), so a matcher from another
+			// one with the same regex can't take the place of this one's
+			for (llvm::Function& function : module) {
+				if (!function.isDeclaration() && function.hasExternalLinkage()) {
+					function.setVisibility(llvm::GlobalValue::HiddenVisibility);
+				}
+			}
+
+			if (!emitObjectBuffer(module, *worker.target_machine, target.opt_level, objects_out.matchers[i], error)) {
+				matcher_errors[i] = error;
+			} else if (cache) {
+				// A cache that can't be written to only means that the next batch compiles the regex again
+				cache->store(matcher_keys[i], objects_out.matchers[i], error);
+			}
+		});
+	}
+	for (size_t i = 0; i < regexes.size(); i++) {
+		pool.submit([&, i]() {
+			BatchWorker& worker = workers[ThreadPool::getCurrentWorker()];
+			std::string prefix = getBatchSymbolPrefix(options.symbol_prefix, i);
+			llvm::Module module(prefix, *worker.context);
+			buildEntryPoints(*worker.context, *worker.entry_template, options.symbol_prefix, objects_out.matcher_prefixes[regex_matchers[i]], prefix, module);
+
+			std::string error;
+			if (!emitObjectBuffer(module, *worker.target_machine, target.opt_level, objects_out.entry_points[i], error)) {
+				entry_point_errors[i] = error;
+			}
+		});
+	}
+	pool.wait();
+
+	for (size_t i = 0; i < regexes.size(); i++) {
+		const llvm::Optional<std::string>& error = matcher_errors[regex_matchers[i]] ? matcher_errors[regex_matchers[i]] : entry_point_errors[i];
+		if (error) {
+			error_out = "Could not compile regex " + std::to_string(i + 1) + ": " + *error;
+			return false;
+		}
+	}
+
+	return true;
+}
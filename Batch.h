@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <llvm/ADT/SmallVector.h>
+#include "Compiler.h"
+#include "Target.h"
+#include "ThreadPool.h"
+#include "Cache.h"
+
+// What compileBatch builds for a batch of regexes. Each distinct regex is compiled once into a matcher object whose entry points are named by its
+// cache key (see getCacheKey), which only depends on the regex and how it's compiled, so the same object serves it wherever it is in any batch. Each
+// regex then gets a small object defining its entry points under getBatchSymbolPrefix, which just jump to its matcher's.
+struct BatchObjects {
+	// The prefix of each matcher's entry points (e.g. rx_3f0c9a...), which is also its name in a library
+	std::vector<std::string> matcher_prefixes;
+	std::vector<llvm::SmallVector<char, 0>> matchers;
+	// The entry points of each regex
+	std::vector<llvm::SmallVector<char, 0>> entry_points;
+};
+
+// Compiles each of regexes into objects_out (see BatchObjects), in parallel on pool, so that they can all be linked into one program (see
+// emitBatchLibrary). Each worker compiles all of its regexes in one LLVMContext with one target machine, rather than setting them up again for each
+// regex. If cache isn't null, matchers that are in it aren't compiled again, and the others are added to it. Returns false and sets error_out if the
+// target can't be created, the prefix isn't valid or any of the regexes can't be compiled, in which case error_out names the first of them by its
+// number (from 1).
+bool compileBatch(ThreadPool& pool, const std::vector<std::string>& regexes, const CompileOptions& options, const TargetSelection& target, const ObjectCache* cache, BatchObjects& objects_out, std::string& error_out);
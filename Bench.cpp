@@ -0,0 +1,485 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <memory>
+#include <vector>
+#include <regex>
+#include <chrono>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/thread.h>
+#include "Compiler.h"
+#include "Matcher.h"
+#include "Jit.h"
+#include "Target.h"
+#include "Optimizer.h"
+#include "Corpus.h"
+
+#if __has_include(<regex.h>)
+#include <regex.h>
+#define HAS_POSIX_REGEX 1
+#endif
+
+// Benchmarks the matchers this project generates (compiled with the JIT, which gives the same code as an emitted object for the host CPU) against
+// std::regex and POSIX regcomp/regexec, on generated corpora of several sizes. Run it with `cmake --build <dir> --target bench`, or run RegexBench
+// directly to pass options.
+
+namespace {
+	// A regex that's benchmarked, written so that it means the same to every engine: no `.`, `$` or class escapes, which they disagree on
+	struct BenchPattern {
+		const char* name;
+		const char* regex;
+		bool is_case_insensitive;
+	};
+
+	const BenchPattern bench_patterns[] = {
+		{ "literal", "needle", false },
+		{ "keywords", "timeout|refused|reset", false },
+		{ "server-error", "status=5[0-9][0-9]", false },
+		{ "email", "[a-z]+@[a-z]+\\.com", false },
+		{ "request-id", "[a-f0-9]{32}", false },
+		{ "date-start", "^[0-9]{4}-[0-9]{2}-[0-9]{2}", false },
+		{ "ignore-case", "error", true },
+		{ "long-literal", "abcdefghijklmnop", false },
+		// Longer than any repeat may expand to, which regexes that are written out in full aren't limited by
+		{ "keyword-list", "timeout|refused|reset|denied|expired|invalid|missing|corrupt|overflow|underflow|deadlock|rejected|aborted|unreachable|unavailable|forbidden|unauthorized|conflict|throttled|cancelled|interrupted|truncated|malformed|mismatch|exhausted|disconnected|unresponsive|segfault|panic|fatal", false }
+	};
+
+	const CorpusKind corpus_kinds[] = { CorpusKind::Log, CorpusKind::RandomBytes, CorpusKind::NearMiss };
+
+	// From 64 B to 1 GiB, each 64 times the last
+	const uint64_t corpus_sizes[] = { 64, 4 << 10, 256 << 10, 16 << 20, uint64_t(1) << 30 };
+
+	// An implementation of regexes that can compile a pattern and then match buffers against it
+	class Engine {
+	public:
+		virtual ~Engine() = default;
+		virtual const char* getName() const = 0;
+		// Whether this is one of the engines being compared against, which are only run on inputs up to --baseline-max-size
+		virtual bool isBaseline() const = 0;
+		// Returns false and sets error_out if the engine can't compile pattern
+		virtual bool compile(const BenchPattern& pattern, std::string& error_out) = 0;
+		// Returns whether the compiled pattern matches anywhere in buf
+		virtual bool match(const char* buf, size_t len) = 0;
+	};
+
+	// Each pattern gets its own prefix, so that they can all be added to the same JIT
+	class GeneratedEngine : public Engine {
+	public:
+		GeneratedEngine(Jit& jit, bool has_byte_shuffle)
+		: jit{jit}, has_byte_shuffle{has_byte_shuffle}, match_function{nullptr}
+		{ }
+
+		const char* getName() const override {
+			return "generated";
+		}
+
+		bool isBaseline() const override {
+			return false;
+		}
+
+		bool compile(const BenchPattern& pattern, std::string& error_out) override {
+			std::string prefix = std::string("bench_") + pattern.name;
+			std::replace(prefix.begin(), prefix.end(), '-', '_');
+			CompileOptions options { prefix, false, pattern.is_case_insensitive, false, { false, false }, false, { false }, has_byte_shuffle };
+
+			std::unique_ptr<llvm::LLVMContext> context = std::make_unique<llvm::LLVMContext>();
+			std::unique_ptr<llvm::Module> module = std::make_unique<llvm::Module>("RegexBench", *context);
+			if (!compileRegex(pattern.regex, *context, *module, options, error_out) || !jit.addModule(std::move(module), std::move(context), error_out)) {
+				return false;
+			}
+
+			// Looking it up is what makes the JIT generate machine code, so that's part of compiling too
+			match_function = jit.lookupFunction<MatchFunction>(getSymbolName(prefix, match_function_suffix).c_str(), error_out);
+			return match_function != nullptr;
+		}
+
+		bool match(const char* buf, size_t len) override {
+			return match_function(buf, len) > 0;
+		}
+
+	private:
+		Jit& jit;
+		bool has_byte_shuffle;
+		MatchFunction match_function;
+	};
+
+	class StdRegexEngine : public Engine {
+	public:
+		const char* getName() const override {
+			return "std::regex";
+		}
+
+		bool isBaseline() const override {
+			return true;
+		}
+
+		bool compile(const BenchPattern& pattern, std::string& error_out) override {
+			try {
+				regex.assign(pattern.regex, pattern.is_case_insensitive ? std::regex::ECMAScript | std::regex::icase : std::regex::ECMAScript);
+			} catch (const std::regex_error& error) {
+				error_out = error.what();
+				return false;
+			}
+			return true;
+		}
+
+		bool match(const char* buf, size_t len) override {
+			return std::regex_search(buf, buf + len, regex);
+		}
+
+	private:
+		std::regex regex;
+	};
+
+#ifdef HAS_POSIX_REGEX
+	// Uses REG_STARTEND where it's available (e.g. glibc and the BSDs) so that buffers needn't be null terminated, otherwise matching stops at the
+	// first NUL
+	class PosixRegexEngine : public Engine {
+	public:
+		PosixRegexEngine()
+		: is_compiled{false}
+		{ }
+
+		~PosixRegexEngine() override {
+			if (is_compiled) {
+				regfree(&regex);
+			}
+		}
+
+		const char* getName() const override {
+			return "regexec";
+		}
+
+		bool isBaseline() const override {
+			return true;
+		}
+
+		bool compile(const BenchPattern& pattern, std::string& error_out) override {
+			if (is_compiled) {
+				regfree(&regex);
+				is_compiled = false;
+			}
+
+			int flags = REG_EXTENDED | REG_NOSUB | (pattern.is_case_insensitive ? REG_ICASE : 0);
+			int error = regcomp(&regex, pattern.regex, flags);
+			if (error != 0) {
+				char message[256];
+				regerror(error, &regex, message, sizeof(message));
+				error_out = message;
+				return false;
+			}
+
+			is_compiled = true;
+			return true;
+		}
+
+		bool match(const char* buf, size_t len) override {
+#ifdef REG_STARTEND
+			regmatch_t range[1];
+			range[0].rm_so = 0;
+			range[0].rm_eo = static_cast<regoff_t>(len);
+			return regexec(&regex, buf, 1, range, REG_STARTEND) == 0;
+#else
+			terminated.assign(buf, len);
+			return regexec(&regex, terminated.c_str(), 0, nullptr, 0) == 0;
+#endif
+		}
+
+	private:
+		regex_t regex;
+		bool is_compiled;
+#ifndef REG_STARTEND
+		std::string terminated;
+#endif
+	};
+#endif
+
+	struct BenchOptions {
+		// Corpora larger than this are skipped
+		uint64_t max_size;
+		// Inputs larger than this aren't given to the baseline engines, which would take minutes on the largest
+		uint64_t baseline_max_size;
+		// Each engine is called on each input until this much time has passed (or it's been called max_calls times)
+		std::chrono::nanoseconds min_time;
+		// Only the patterns whose names contain this are run
+		std::string filter;
+	};
+
+	const size_t max_calls = 1000000;
+
+	// The times of every call to an engine on one input
+	struct Measurement {
+		bool is_matched;
+		std::vector<std::chrono::nanoseconds> call_times;
+		std::chrono::nanoseconds total_time;
+	};
+
+	// Times each call separately, so the latencies include the cost of reading the clock (tens of nanoseconds), which matters for the smallest inputs.
+	// There's always at least one timed call, even with no minimum time.
+	Measurement measure(Engine& engine, const char* buf, size_t len, std::chrono::nanoseconds min_time) {
+		Measurement measurement { engine.match(buf, len), {}, std::chrono::nanoseconds::zero() };
+		while (measurement.call_times.empty() || (measurement.total_time < min_time && measurement.call_times.size() < max_calls)) {
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			engine.match(buf, len);
+			std::chrono::nanoseconds call_time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+			measurement.call_times.push_back(call_time);
+			measurement.total_time += call_time;
+		}
+
+		std::sort(measurement.call_times.begin(), measurement.call_times.end());
+		return measurement;
+	}
+
+	std::chrono::nanoseconds getPercentile(const Measurement& measurement, size_t percent) {
+		size_t index = std::min(measurement.call_times.size() * percent / 100, measurement.call_times.size() - 1);
+		return measurement.call_times[index];
+	}
+
+	std::string formatSize(uint64_t size) {
+		const char* units[] = { "B", "KiB", "MiB", "GiB" };
+		size_t unit = 0;
+		while (unit < 3 && size >= 1024 && size % 1024 == 0) {
+			size /= 1024;
+			unit++;
+		}
+		return std::to_string(size) + " " + units[unit];
+	}
+
+	std::string formatDuration(std::chrono::nanoseconds duration) {
+		const char* units[] = { "ns", "us", "ms", "s" };
+		double value = static_cast<double>(duration.count());
+		size_t unit = 0;
+		while (unit < 3 && value >= 1000) {
+			value /= 1000;
+			unit++;
+		}
+
+		std::ostringstream text;
+		text << std::fixed << std::setprecision(unit == 0 ? 0 : 2) << value << " " << units[unit];
+		return text.str();
+	}
+
+	// Parses a decimal number given as an option
+	bool parseNumber(const std::string& text, uint64_t& number_out) {
+		if (text.empty() || text.size() > 12) {
+			return false;
+		}
+
+		uint64_t number = 0;
+		for (char c : text) {
+			if (c < '0' || c > '9') {
+				return false;
+			}
+			number = number * 10 + static_cast<uint64_t>(c - '0');
+		}
+
+		number_out = number;
+		return true;
+	}
+
+	// Parses a size like 4096, 64K, 16M or 1G (in powers of 1024)
+	bool parseSize(const std::string& text, uint64_t& size_out) {
+		if (text.empty()) {
+			return false;
+		}
+
+		std::string digits = text;
+		uint64_t multiplier = 1;
+		switch (digits.back()) {
+			case 'K':
+				multiplier = uint64_t(1) << 10;
+				break;
+			case 'M':
+				multiplier = uint64_t(1) << 20;
+				break;
+			case 'G':
+				multiplier = uint64_t(1) << 30;
+				break;
+		}
+		if (multiplier != 1) {
+			digits.pop_back();
+		}
+
+		uint64_t size;
+		if (!parseNumber(digits, size) || size > UINT64_MAX / multiplier) {
+			return false;
+		}
+
+		size_out = size * multiplier;
+		return true;
+	}
+
+	void printUsage() {
+		std::cout << "Usage: RegexBench [options]\n";
+		std::cout << "  Compiles each benchmark pattern with every engine and prints how long that took, then matches generated corpora of sizes from 64 B\n";
+		std::cout << "  up to --max-size against them and prints the throughput and per-call latency percentiles.\n";
+		std::cout << "  --max-size <size>  The largest corpus, from 64 to 1G (K, M and G are powers of 1024), by default 16M.\n";
+		std::cout << "  --baseline-max-size <size> The largest corpus to give std::regex and regexec, by default 256K.\n";
+		std::cout << "  --min-time <ms>    How long to keep calling each engine on each corpus, by default 100.\n";
+		std::cout << "  --filter <text>    Only run the patterns whose names contain text.\n";
+	}
+
+	// Compiles pattern with each engine, printing how long it took. Engines that can't compile it are left out of pattern_engines.
+	void compilePattern(const BenchPattern& pattern, std::vector<std::unique_ptr<Engine>>& engines, std::vector<Engine*>& pattern_engines) {
+		for (std::unique_ptr<Engine>& engine : engines) {
+			std::string error;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			bool is_compiled = engine->compile(pattern, error);
+			std::chrono::nanoseconds compile_time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+			std::cout << std::left << std::setw(14) << pattern.name << std::setw(12) << engine->getName();
+			if (is_compiled) {
+				std::cout << formatDuration(compile_time) << "\n";
+				pattern_engines.push_back(engine.get());
+			} else {
+				std::cout << "failed: " << error << "\n";
+			}
+		}
+	}
+
+	void runCorpus(CorpusKind kind, const std::vector<const BenchPattern*>& patterns, const std::vector<std::vector<Engine*>>& pattern_engines, const BenchOptions& options) {
+		uint64_t largest_size = 0;
+		for (uint64_t size : corpus_sizes) {
+			if (size <= options.max_size) {
+				largest_size = size;
+			}
+		}
+		std::string corpus = generateCorpus(kind, static_cast<size_t>(largest_size));
+
+		for (uint64_t size : corpus_sizes) {
+			if (size > largest_size) {
+				break;
+			}
+
+			for (size_t i = 0; i < patterns.size(); i++) {
+				std::vector<bool> results;
+				for (Engine* engine : pattern_engines[i]) {
+					if (engine->isBaseline() && size > options.baseline_max_size) {
+						continue;
+					}
+
+					Measurement measurement = measure(*engine, corpus.data(), static_cast<size_t>(size), options.min_time);
+					results.push_back(measurement.is_matched);
+
+					// A byte per nanosecond is a GB/s. Calls can be quicker than the clock's resolution, so the time is taken to be at least a nanosecond.
+					double total_time = static_cast<double>(std::max<int64_t>(measurement.total_time.count(), 1));
+					double throughput = static_cast<double>(size) * static_cast<double>(measurement.call_times.size()) / total_time;
+					std::cout << std::left << std::setw(11) << getCorpusName(kind) << std::setw(9) << formatSize(size) << std::setw(14) << patterns[i]->name
+						<< std::setw(12) << engine->getName() << std::setw(7) << (measurement.is_matched ? "yes" : "no")
+						<< std::right << std::fixed << std::setprecision(3) << std::setw(9) << throughput
+						<< std::setw(12) << formatDuration(getPercentile(measurement, 50))
+						<< std::setw(12) << formatDuration(getPercentile(measurement, 90))
+						<< std::setw(12) << formatDuration(getPercentile(measurement, 99)) << "\n";
+				}
+
+				// The patterns mean the same to every engine, so this is a bug in one of them
+				if (!results.empty() && std::find(results.begin(), results.end(), !results.front()) != results.end()) {
+					std::cout << "  engines disagree on whether " << patterns[i]->name << " matches\n";
+				}
+			}
+		}
+	}
+
+	int runBench(const BenchOptions& options) {
+		std::string error;
+		TargetSelection target { "", native_cpu_name, default_opt_level };
+		std::unique_ptr<Jit> jit = Jit::create(target, error);
+		if (!jit) {
+			std::cout << "Could not create JIT: " << error << "\n";
+			return 2;
+		}
+
+		std::vector<const BenchPattern*> patterns;
+		for (const BenchPattern& pattern : bench_patterns) {
+			if (std::string(pattern.name).find(options.filter) != std::string::npos) {
+				patterns.push_back(&pattern);
+			}
+		}
+		if (patterns.empty()) {
+			std::cout << "No patterns match the filter\n";
+			return 1;
+		}
+
+		std::vector<std::unique_ptr<Engine>> engines;
+		std::vector<std::vector<Engine*>> pattern_engines;
+		std::cout << std::left << std::setw(14) << "pattern" << std::setw(12) << "engine" << "compile time\n";
+		for (const BenchPattern* pattern : patterns) {
+			// Every engine has its own instance per pattern, so they can all be compiled before any are run
+			std::vector<std::unique_ptr<Engine>> instances;
+			instances.push_back(std::make_unique<GeneratedEngine>(*jit, hasByteShuffle(jit->getTargetMachine())));
+			instances.push_back(std::make_unique<StdRegexEngine>());
+#ifdef HAS_POSIX_REGEX
+			instances.push_back(std::make_unique<PosixRegexEngine>());
+#endif
+
+			pattern_engines.emplace_back();
+			compilePattern(*pattern, instances, pattern_engines.back());
+			for (std::unique_ptr<Engine>& instance : instances) {
+				engines.push_back(std::move(instance));
+			}
+		}
+
+		std::cout << "\n" << std::left << std::setw(11) << "corpus" << std::setw(9) << "size" << std::setw(14) << "pattern" << std::setw(12) << "engine"
+			<< std::setw(7) << "match" << std::right << std::setw(9) << "GB/s" << std::setw(12) << "p50" << std::setw(12) << "p90" << std::setw(12) << "p99" << "\n";
+		for (CorpusKind kind : corpus_kinds) {
+			runCorpus(kind, patterns, pattern_engines, options);
+		}
+
+		return 0;
+	}
+
+	int run(int argc, char* argv[]) {
+		BenchOptions options { 16 << 20, 256 << 10, std::chrono::milliseconds(100), "" };
+		for (int i = 1; i < argc; i++) {
+			std::string arg = argv[i];
+			if ((arg == "--max-size" || arg == "--baseline-max-size" || arg == "--min-time" || arg == "--filter") && i + 1 >= argc) {
+				std::cout << "Missing value for " << arg << "\n";
+				return 1;
+			} else if (arg == "--max-size" || arg == "--baseline-max-size") {
+				std::string size = argv[++i];
+				uint64_t& size_out = arg == "--max-size" ? options.max_size : options.baseline_max_size;
+				if (!parseSize(size, size_out) || size_out > corpus_sizes[std::size(corpus_sizes) - 1] || (arg == "--max-size" && size_out < corpus_sizes[0])) {
+					std::cout << "Invalid size " << size << "\n";
+					return 1;
+				}
+			} else if (arg == "--min-time") {
+				std::string time = argv[++i];
+				uint64_t milliseconds;
+				if (!parseNumber(time, milliseconds)) {
+					std::cout << "Invalid time " << time << "\n";
+					return 1;
+				}
+				options.min_time = std::chrono::milliseconds(milliseconds);
+			} else if (arg == "--filter") {
+				options.filter = argv[++i];
+			} else if (arg == "--help") {
+				printUsage();
+				return 0;
+			} else {
+				std::cout << "Unknown option " << arg << "\n";
+				return 1;
+			}
+		}
+
+		return runBench(options);
+	}
+}
+
+// Compiling needs a large stack for the same reason as in main.cpp, and so does std::regex, which recurses as it matches
+const unsigned bench_stack_size = 512 << 20;
+
+int main(int argc, char* argv[]) {
+	int result = 0;
+	llvm::thread bench_thread(llvm::Optional<unsigned>(bench_stack_size), [&]() {
+		result = run(argc, argv);
+	});
+	bench_thread.join();
+
+	return result;
+}
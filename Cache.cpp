@@ -0,0 +1,153 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/Chrono.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+#include "Cache.h"
+
+namespace {
+	const char* const entry_extension = ".o";
+	const char* const temporary_extension = ".tmp";
+	// Temporary files older than this were left by processes that died while storing, and are removed by prune
+	const std::chrono::hours max_temporary_age(1);
+
+	struct CacheEntry {
+		std::string path;
+		uint64_t size;
+		llvm::sys::TimePoint<> last_used;
+	};
+}
+
+std::string getCacheKey(CachedObjectKind kind, const std::vector<std::string>& regexes, bool is_set, const CompileOptions& options, const llvm::TargetMachine& target_machine, unsigned opt_level) {
+	// Strings are prefixed with their length, so that no two descriptions run together into the same text. Every field of CompileOptions has to be
+	// here, since they all change the generated code.
+	std::string description;
+	llvm::raw_string_ostream output(description);
+	auto write_string = [&output](llvm::StringRef text) {
+		output << text.size() << ":" << text << "\n";
+	};
+
+	write_string(compiler_version);
+	write_string(LLVM_VERSION_STRING);
+	write_string(target_machine.getTargetTriple().str());
+	write_string(target_machine.getTargetCPU());
+	write_string(target_machine.getTargetFeatureString());
+	output << opt_level << "\n";
+	output << static_cast<int>(kind) << "\n";
+
+	write_string(options.symbol_prefix);
+	output << options.emit_main << options.is_case_insensitive << options.line_mode << options.line_options.count_only << options.line_options.print_line_numbers
+		<< options.find_mode << options.find_options.count_only << options.has_byte_shuffle << "\n";
+
+	output << is_set << regexes.size() << "\n";
+	for (const std::string& regex : regexes) {
+		write_string(regex);
+	}
+	output.flush();
+
+	return llvm::toHex(llvm::SHA1::hash(llvm::arrayRefFromStringRef(description)), true);
+}
+
+ObjectCache::ObjectCache(std::string directory, uint64_t max_size)
+: directory{std::move(directory)}, max_size{max_size}
+{ }
+
+std::unique_ptr<llvm::MemoryBuffer> ObjectCache::load(const std::string& key) const {
+	std::string path = getEntryPath(key);
+
+	// The modification time is when the entry was last used, which is what prune goes by. A cache that can only be read still has hits.
+	int fd;
+	if (!llvm::sys::fs::openFileForReadWrite(path, fd, llvm::sys::fs::CD_OpenExisting, llvm::sys::fs::OF_None)) {
+		llvm::sys::fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+		llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+	}
+
+	llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(path, false, false);
+	if (!buffer) {
+		return nullptr;
+	}
+
+	return std::move(*buffer);
+}
+
+bool ObjectCache::store(const std::string& key, llvm::ArrayRef<char> object, std::string& error_out) const {
+	std::error_code ec = llvm::sys::fs::create_directories(directory);
+	if (ec) {
+		error_out = ec.message();
+		return false;
+	}
+
+	// The temporary file is in the same directory so that renaming it is atomic, and has another extension so that prune never sees it
+	int fd;
+	llvm::SmallString<128> temporary_path;
+	ec = llvm::sys::fs::createUniqueFile(directory + "/" + key + "-%%%%%%%%" + temporary_extension, fd, temporary_path);
+	if (ec) {
+		error_out = ec.message();
+		return false;
+	}
+
+	{
+		llvm::raw_fd_ostream output(fd, true);
+		output.write(object.data(), object.size());
+		output.close();
+		if (output.has_error()) {
+			error_out = output.error().message();
+			output.clear_error();
+			llvm::sys::fs::remove(temporary_path);
+			return false;
+		}
+	}
+
+	ec = llvm::sys::fs::rename(temporary_path, getEntryPath(key));
+	if (ec) {
+		error_out = ec.message();
+		llvm::sys::fs::remove(temporary_path);
+		return false;
+	}
+
+	return true;
+}
+
+void ObjectCache::prune() const {
+	std::vector<CacheEntry> entries;
+	uint64_t total_size = 0;
+	std::error_code ec;
+	llvm::sys::TimePoint<> now = std::chrono::system_clock::now();
+	for (llvm::sys::fs::directory_iterator it(directory, ec), end; it != end && !ec; it.increment(ec)) {
+		// Another process may have removed the file since it was listed
+		llvm::ErrorOr<llvm::sys::fs::basic_file_status> status = it->status();
+		llvm::StringRef extension = llvm::sys::path::extension(it->path());
+		if (status && extension == temporary_extension && now - status->getLastModificationTime() > max_temporary_age) {
+			llvm::sys::fs::remove(it->path());
+		} else if (status && extension == entry_extension) {
+			entries.push_back(CacheEntry { it->path(), status->getSize(), status->getLastModificationTime() });
+			total_size += status->getSize();
+		}
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const CacheEntry& a, const CacheEntry& b) {
+		return a.last_used < b.last_used;
+	});
+	for (const CacheEntry& entry : entries) {
+		if (total_size <= max_size) {
+			break;
+		}
+
+		llvm::sys::fs::remove(entry.path);
+		total_size -= entry.size;
+	}
+}
+
+std::string ObjectCache::getEntryPath(const std::string& key) const {
+	return directory + "/" + key + entry_extension;
+}
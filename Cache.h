@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Target/TargetMachine.h>
+#include "Compiler.h"
+
+// The version of the code generator, which is part of every cache key so that objects cached by older builds aren't used. It's a hash of the
+// sources that the build generates (see cmake/CompilerVersion.cmake), so it changes whenever they do.
+extern const char* const compiler_version;
+
+// Cached objects are evicted once the cache is larger than this, unless another size is given
+const uint64_t default_cache_max_size = uint64_t(1) << 30;
+
+// What an object was compiled for. The same regex and options give a different object for each, since a batch's matchers are named from their key
+// (see compileBatch) and hidden, while the JIT's are named by the options' prefix and exported.
+enum class CachedObjectKind {
+	Jit,
+	BatchMatcher,
+};
+
+// Returns the key for the kind of object compiled from regexes (a set if is_set, otherwise a single regex) with options for target_machine at
+// opt_level. It's a hash of all of them along with the compiler and LLVM versions, so any change to what would be generated gives a different key.
+std::string getCacheKey(CachedObjectKind kind, const std::vector<std::string>& regexes, bool is_set, const CompileOptions& options, const llvm::TargetMachine& target_machine, unsigned opt_level);
+
+// A directory of compiled objects named by their keys, which any number of processes (and threads) can share. Entries are written to a temporary file
+// and renamed into place, so an entry is either missing or complete. Since the key covers everything that goes into an object, an entry never
+// changes once it's written, and processes that compile the same object at once just replace it with the same bytes.
+class ObjectCache {
+public:
+	ObjectCache(std::string directory, uint64_t max_size);
+
+	// Returns the object cached under key, or null if there isn't one. A hit marks the entry as recently used.
+	std::unique_ptr<llvm::MemoryBuffer> load(const std::string& key) const;
+	// Caches object under key, creating the directory if needed. Returns false and sets error_out if it can't be written, in which case the cache is
+	// left as it was.
+	bool store(const std::string& key, llvm::ArrayRef<char> object, std::string& error_out) const;
+	// Evicts the least recently used entries until the cache is no larger than its maximum size. This lists the whole directory, so it's done once
+	// after compiling rather than after every store.
+	void prune() const;
+
+private:
+	std::string getEntryPath(const std::string& key) const;
+
+	std::string directory;
+	uint64_t max_size;
+};
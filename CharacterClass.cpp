@@ -0,0 +1,66 @@
+#include "CharacterClass.h"
+
+namespace {
+	void setRange(ByteSet& bytes, char first, char last) {
+		for (int c = first; c <= last; c++) {
+			bytes.set(static_cast<uint8_t>(c));
+		}
+	}
+}
+
+CharacterClass::CharacterClass(const ByteSet& bytes)
+: bytes{bytes}
+{ }
+
+void CharacterClass::add_to_nfa(Nfa& nfa, int32_t from, int32_t to) const {
+	nfa.addByteTransition(from, to, bytes);
+}
+
+bool CharacterClass::get_positions(std::vector<ByteSet>& positions_out) const {
+	positions_out.push_back(bytes);
+	return true;
+}
+
+ByteSet CharacterClass::digits() {
+	ByteSet bytes;
+	setRange(bytes, '0', '9');
+	return bytes;
+}
+
+ByteSet CharacterClass::word_characters() {
+	ByteSet bytes = digits();
+	setRange(bytes, 'a', 'z');
+	setRange(bytes, 'A', 'Z');
+	bytes.set('_');
+	return bytes;
+}
+
+ByteSet CharacterClass::whitespace() {
+	ByteSet bytes;
+	for (char c : { ' ', '\t', '\n', '\r', '\f', '\v' }) {
+		bytes.set(static_cast<uint8_t>(c));
+	}
+	return bytes;
+}
+
+ByteSet CharacterClass::case_folded(const ByteSet& bytes) {
+	ByteSet folded = bytes;
+	for (int c = 'A'; c <= 'Z'; c++) {
+		if (bytes[c] || bytes[c | 0x20]) {
+			folded.set(static_cast<uint8_t>(c));
+			folded.set(static_cast<uint8_t>(c | 0x20));
+		}
+	}
+	return folded;
+}
+
+AtomSummary CharacterClass::get_summary() const {
+	// A class of one byte (like [x]) always matches that byte, and one of a letter in both cases (like [xX]) always matches that letter
+	AtomSummary summary { 1, 1, bytes.count() == 1 ? bytes : ByteSet(), ByteSet(), false, false };
+	for (int c = 'a'; c <= 'z'; c++) {
+		if (bytes.count() == 2 && bytes[c] && bytes[c & ~0x20]) {
+			summary.required_letters.set(static_cast<uint8_t>(c));
+		}
+	}
+	return summary;
+}
\ No newline at end of file
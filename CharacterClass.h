@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Atom.h"
+#include "Nfa.h"
+
+// Matches any one byte in a set, e.g. [a-z], [^,] or \d
+class CharacterClass : public Atom {
+public:
+	explicit CharacterClass(const ByteSet& bytes);
+	void add_to_nfa(Nfa& nfa, int32_t from, int32_t to) const override;
+	AtomSummary get_summary() const override;
+	bool get_positions(std::vector<ByteSet>& positions_out) const override;
+
+	// The bytes matched by \d, \w and \s
+	static ByteSet digits();
+	static ByteSet word_characters();
+	static ByteSet whitespace();
+	// Returns bytes along with the other case of each ASCII letter in it, for case-insensitive classes
+	static ByteSet case_folded(const ByteSet& bytes);
+
+private:
+	ByteSet bytes;
+};
\ No newline at end of file
@@ -0,0 +1,281 @@
+#include <string>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include "Compiler.h"
+#include "Atom.h"
+#include "Parser.h"
+#include "Matcher.h"
+#include "Nfa.h"
+#include "Dfa.h"
+#include "Runtime.h"
+#include "Lines.h"
+#include "Sets.h"
+#include "ShiftOr.h"
+#include "Anchors.h"
+#include "Summary.h"
+#include "Prefilter.h"
+#include "Find.h"
+#include "Records.h"
+
+namespace {
+	// The prefix ends up in C symbol names, so it has to be a valid identifier
+	bool isValidPrefix(const std::string& prefix) {
+		if (prefix.empty() || std::isdigit(static_cast<unsigned char>(prefix[0]))) {
+			return false;
+		}
+
+		for (char c : prefix) {
+			if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Patterns are only grouped while their DFA stays this small, since the states of a group can multiply and each one is emitted as code. A single
+	// pattern can still have up to max_dfa_states.
+	const size_t max_group_dfa_states = 1 << 12;
+	// A group's DFA can have at most this many times as many states as its patterns' own DFAs put together. Patterns whose states multiply when
+	// they're grouped (like ones with .*) would otherwise fill groups up to max_group_dfa_states, which takes far longer to build and emit than the
+	// scans it saves.
+	const size_t max_group_growth = 2;
+
+	using AtomsList = std::vector<std::unique_ptr<Atom>>;
+
+	// Builds the DFA for the patterns from first to last (not including last) as one group. Returns false and sets error_out if it would have more
+	// than max_states states.
+	bool buildGroupDfa(const std::vector<AtomsList>& patterns, size_t first, size_t last, size_t max_states, Dfa& dfa_out, std::string& error_out) {
+		std::vector<const AtomsList*> group_patterns;
+		for (size_t i = first; i < last; i++) {
+			group_patterns.push_back(&patterns[i]);
+		}
+		return buildDfa(buildNfaSet(group_patterns), dfa_out, error_out, max_states);
+	}
+
+	// Splits patterns into groups of consecutive ones, and adds each group's DFA to dfas_out along with the ids of its patterns. Patterns are added
+	// to a group in chunks that double while the group's DFA stays within max_group_growth of what its patterns need on their own, and then halve
+	// until one more doesn't fit. So each group's DFA is built about twice the logarithm of its number of patterns times, and an attempt that
+	// fails stops as soon as it's too big rather than once it has max_group_dfa_states.
+	bool buildGroupDfas(const std::vector<AtomsList>& patterns, std::vector<Dfa>& dfas_out, std::vector<std::vector<uint32_t>>& pattern_ids_out, std::string& error_out) {
+		std::vector<size_t> pattern_sizes;
+		for (size_t i = 0; i < patterns.size(); i++) {
+			Dfa dfa;
+			std::string dfa_error;
+			if (!buildGroupDfa(patterns, i, i + 1, max_dfa_states, dfa, dfa_error)) {
+				error_out = "Pattern " + std::to_string(i + 1) + ": " + dfa_error;
+				return false;
+			}
+			pattern_sizes.push_back(dfa.states.size());
+		}
+
+		size_t first = 0;
+		while (first < patterns.size()) {
+			// Each pattern's own DFA was built above, so this can't fail. They're built again rather than kept, since most of them end up in a group.
+			Dfa group_dfa;
+			std::string group_error;
+			buildGroupDfa(patterns, first, first + 1, max_dfa_states, group_dfa, group_error);
+			size_t last = first + 1;
+			size_t group_size = pattern_sizes[first];
+
+			size_t chunk_length = 1;
+			bool has_failed = false;
+			while (last < patterns.size() && chunk_length > 0) {
+				size_t chunk_last = std::min(last + chunk_length, patterns.size());
+				size_t chunk_size = group_size;
+				for (size_t i = last; i < chunk_last; i++) {
+					chunk_size += pattern_sizes[i];
+				}
+
+				Dfa dfa;
+				std::string dfa_error;
+				if (buildGroupDfa(patterns, first, chunk_last, std::min(max_group_dfa_states, max_group_growth * chunk_size), dfa, dfa_error)) {
+					group_dfa = std::move(dfa);
+					group_size = chunk_size;
+					last = chunk_last;
+					if (!has_failed) {
+						chunk_length *= 2;
+					}
+				} else {
+					has_failed = true;
+					chunk_length /= 2;
+				}
+			}
+
+			dfas_out.push_back(minimizeDfa(group_dfa));
+			pattern_ids_out.emplace_back();
+			for (size_t i = first; i < last; i++) {
+				pattern_ids_out.back().push_back(static_cast<uint32_t>(i));
+			}
+			first = last;
+		}
+
+		return true;
+	}
+}
+
+bool compileRegex(const std::string& regex, llvm::LLVMContext& context, llvm::Module& module, const CompileOptions& options, std::string& error_out) {
+	if (!isValidPrefix(options.symbol_prefix)) {
+		error_out = "Symbol prefix must be a C identifier";
+		return false;
+	}
+
+	if (options.line_mode && options.find_mode) {
+		error_out = "Line mode and find mode can't be used together";
+		return false;
+	}
+
+	std::vector<std::unique_ptr<Atom>> atoms;
+	if (!parseRegex(regex, atoms, error_out, options.is_case_insensitive)) {
+		return false;
+	}
+
+	// Offsets need the DFA that tracks where matches start, so build it first to fail before emitting anything if it's too large
+	FindDfa find_dfa;
+	if (options.find_mode && !buildFindDfa(buildNfa(atoms), find_dfa, error_out)) {
+		return false;
+	}
+
+	llvm::IRBuilder builder(context);
+	llvm::Function* scan_function;
+	std::vector<ByteSet> positions;
+	if (getShiftOrPositions(atoms, positions)) {
+		scan_function = buildShiftOrScanFunction(context, builder, module, positions, options.has_byte_shuffle);
+	} else {
+		Dfa dfa;
+		if (!buildDfa(buildNfa(atoms), dfa, error_out)) {
+			return false;
+		}
+		scan_function = buildScanFunction(context, builder, module, minimizeDfa(dfa), options.has_byte_shuffle);
+	}
+
+	// Regexes like abc$ only need to look at the end of the input when it's all in memory, and keep scanning for it when it's read in blocks. Others
+	// can still rule out inputs that are too short or don't have a byte that every match needs.
+	std::vector<ByteSet> anchored_positions;
+	bool is_start_anchored;
+	if (getEndAnchoredPositions(atoms, anchored_positions, is_start_anchored)) {
+		scan_function = buildEndAnchoredScanFunction(context, builder, module, anchored_positions, is_start_anchored, scan_function);
+	} else {
+		bool is_end_anchored = !atoms.empty() && atoms.back()->is_string_end();
+		scan_function = buildPrefilteredScanFunction(context, builder, module, summarizeSequence(atoms), is_end_anchored, scan_function);
+	}
+	llvm::Function* match_function = buildMatchFunction(context, builder, module, scan_function, options.symbol_prefix);
+	// Records that only need their first few bytes compared (like ^\d{4}$) are compared several at a time, and the rest are each matched in turn
+	std::vector<ByteSet> record_positions;
+	bool is_record_end_anchored = false;
+	getRecordPositions(atoms, record_positions, is_record_end_anchored);
+	buildMatchBatchFunction(context, builder, module, match_function, record_positions, is_record_end_anchored, options.symbol_prefix);
+	llvm::Function* match_fd_function = buildMatchFdFunction(context, builder, module, scan_function, options.symbol_prefix);
+	llvm::Function* match_file_function = buildMatchFileFunction(context, builder, module, match_fd_function, options.symbol_prefix);
+
+	if (options.line_mode) {
+		llvm::Function* grep_block = buildGrepBlockFunction(context, builder, module, scan_function, options.line_options);
+		// Counting the lines of a large input in parallel needs a version of grep_block that doesn't print them
+		llvm::Function* count_block = options.line_options.count_only
+			? grep_block
+			: buildGrepBlockFunction(context, builder, module, scan_function, LineModeOptions { true, false });
+		llvm::Function* grep_fd_function = buildGrepFdFunction(context, builder, module, grep_block, options.line_options, options.symbol_prefix);
+		buildGrepLinesFunction(context, builder, module, grep_block, options.symbol_prefix);
+		buildCountLinesFunction(context, builder, module, count_block, options.symbol_prefix);
+		llvm::Function* grep_file_function = buildGrepFileFunction(context, builder, module, grep_fd_function, options.symbol_prefix);
+		if (options.emit_main) {
+			buildGrepMain(context, builder, module, grep_fd_function, grep_file_function);
+		}
+	} else if (options.find_mode) {
+		llvm::Function* find_next_function = buildFindNextFunction(context, builder, module, find_dfa, options.has_byte_shuffle);
+		buildFindFunction(context, builder, module, find_next_function, options.symbol_prefix);
+		buildCountFunction(context, builder, module, find_next_function, options.symbol_prefix);
+		llvm::Function* find_fd_function = buildFindFdFunction(context, builder, module, find_next_function, options.find_options, options.symbol_prefix);
+		llvm::Function* find_file_function = buildFindFileFunction(context, builder, module, find_fd_function, options.symbol_prefix);
+		if (options.emit_main) {
+			buildGrepMain(context, builder, module, find_fd_function, find_file_function);
+		}
+	} else if (options.emit_main) {
+		buildMain(context, builder, module, match_fd_function, match_file_function);
+	}
+
+	return true;
+}
+
+bool getChunkOverlap(const std::string& regex, const CompileOptions& options, uint64_t& overlap_out) {
+	std::vector<std::unique_ptr<Atom>> atoms;
+	std::string error;
+	if (!parseRegex(regex, atoms, error, options.is_case_insensitive)) {
+		return false;
+	}
+
+	AtomSummary summary = summarizeSequence(atoms);
+	if (summary.has_string_start || summary.has_string_end || summary.max_length == unbounded_length) {
+		return false;
+	}
+
+	overlap_out = summary.max_length > 0 ? summary.max_length - 1 : 0;
+	return true;
+}
+
+bool compileRegexSet(const std::vector<std::string>& regexes, llvm::LLVMContext& context, llvm::Module& module, const CompileOptions& options, std::string& error_out) {
+	if (!isValidPrefix(options.symbol_prefix)) {
+		error_out = "Symbol prefix must be a C identifier";
+		return false;
+	}
+	if (options.line_mode) {
+		error_out = "Line mode isn't supported for pattern sets";
+		return false;
+	}
+	if (options.find_mode) {
+		error_out = "Find mode isn't supported for pattern sets";
+		return false;
+	}
+	if (regexes.empty()) {
+		error_out = "Pattern set is empty";
+		return false;
+	}
+
+	std::vector<AtomsList> patterns(regexes.size());
+	for (size_t i = 0; i < regexes.size(); i++) {
+		std::string parse_error;
+		if (!parseRegex(regexes[i], patterns[i], parse_error, options.is_case_insensitive)) {
+			error_out = "Pattern " + std::to_string(i + 1) + ": " + parse_error;
+			return false;
+		}
+	}
+
+	// One DFA for the whole set reads the input once, but the number of states can grow with the product of the patterns' sizes
+	std::vector<Dfa> dfas;
+	std::vector<std::vector<uint32_t>> group_pattern_ids;
+	if (!buildGroupDfas(patterns, dfas, group_pattern_ids, error_out)) {
+		return false;
+	}
+
+	llvm::IRBuilder builder(context);
+	// The time LLVM takes grows with every coded state, so a set of many small groups would take as long as one large one. The groups share
+	// max_coded_dfa_states between them, and the ones after that's used up are table-driven.
+	std::vector<llvm::Function*> group_scan_functions;
+	size_t coded_states_left = max_coded_dfa_states;
+	for (size_t i = 0; i < dfas.size(); i++) {
+		group_scan_functions.push_back(buildSetScanFunction(context, builder, module, dfas[i], options.has_byte_shuffle, group_pattern_ids[i], coded_states_left));
+		if (dfas[i].states.size() <= coded_states_left) {
+			coded_states_left -= dfas[i].states.size();
+		}
+	}
+
+	uint32_t num_groups = static_cast<uint32_t>(dfas.size());
+	uint32_t num_patterns = static_cast<uint32_t>(regexes.size());
+	llvm::Function* grouped_scan_function = buildGroupedScanFunction(context, builder, module, group_scan_functions);
+	llvm::Function* match_set_function = buildMatchSetFunction(context, builder, module, grouped_scan_function, num_groups, num_patterns, options.symbol_prefix);
+	llvm::Function* match_set_fd_function = buildMatchSetFdFunction(
+		context, builder, module, grouped_scan_function, match_set_function, num_groups, num_patterns, options.symbol_prefix
+	);
+	llvm::Function* match_set_file_function = buildMatchSetFileFunction(context, builder, module, match_set_fd_function, options.symbol_prefix);
+
+	if (options.emit_main) {
+		buildSetMain(context, builder, module, match_set_fd_function, match_set_file_function, num_patterns);
+	}
+
+	return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include "Lines.h"
+#include "Find.h"
+
+struct CompileOptions {
+	// Prefix for the names of the generated entry points, see Matcher.h
+	std::string symbol_prefix;
+	// Emit a main function that matches stdin or the files it's given
+	bool emit_main;
+	// Letters match in either case, as if the regex (or each one in a set) started with (?i)
+	bool is_case_insensitive;
+	// Match each line separately like grep, printing the ones that match (see LineModeOptions)
+	bool line_mode;
+	LineModeOptions line_options;
+	// Print where each match is instead of whether there is one (see FindModeOptions)
+	bool find_mode;
+	FindModeOptions find_options;
+	// The target can look up 16 bytes in a table at once, see hasByteShuffle
+	bool has_byte_shuffle;
+};
+
+// Compiles a regex into module, emitting the matcher functions and, if requested, a main function
+bool compileRegex(const std::string& regex, llvm::LLVMContext& context, llvm::Module& module, const CompileOptions& options, std::string& error_out);
+// Returns whether the input can be matched against regex in chunks that are scanned separately, which needs a longest possible match and no ^ or $
+// (since they'd match at the edges of each chunk). Sets overlap_out to how many bytes each chunk has to share with the next so that every match is
+// wholly inside one of them.
+bool getChunkOverlap(const std::string& regex, const CompileOptions& options, uint64_t& overlap_out);
+// Compiles a set of regexes into module, emitting the set matcher functions (see match_set_function_suffix) and, if requested, a main function.
+// Line mode and find mode aren't supported for sets.
+bool compileRegexSet(const std::vector<std::string>& regexes, llvm::LLVMContext& context, llvm::Module& module, const CompileOptions& options, std::string& error_out);
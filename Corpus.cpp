@@ -0,0 +1,134 @@
+#include <string>
+#include <random>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include "Corpus.h"
+
+namespace {
+	// mt19937_64's output is fixed by the standard, unlike the distributions built on it, so this is used to pick numbers instead of them
+	uint64_t below(std::mt19937_64& rng, uint64_t bound) {
+		return rng() % bound;
+	}
+
+	void appendLetters(std::string& out, std::mt19937_64& rng, uint64_t min_length, uint64_t max_length) {
+		uint64_t length = min_length + below(rng, max_length - min_length + 1);
+		for (uint64_t i = 0; i < length; i++) {
+			out.push_back(static_cast<char>('a' + below(rng, 26)));
+		}
+	}
+
+	void appendHex(std::string& out, std::mt19937_64& rng, uint64_t length) {
+		const char* digits = "0123456789abcdef";
+		for (uint64_t i = 0; i < length; i++) {
+			out.push_back(digits[below(rng, 16)]);
+		}
+	}
+
+	void appendFormatted(std::string& out, const char* format, unsigned a, unsigned b, unsigned c, unsigned d) {
+		char buffer[128];
+		int length = std::snprintf(buffer, sizeof(buffer), format, a, b, c, d);
+		out.append(buffer, static_cast<size_t>(length));
+	}
+
+	// Appends a line like "2024-03-07 12:34:56 INFO [worker-3] GET /api/v1/items/4821 from 10.0.3.17 status=200 in 12ms". Out of every 20000 lines,
+	// about 100 have a server error, 40 an email address, 20 a timeout or a refused or reset connection, 10 a request ID of 32 hex digits, 70 are at
+	// the ERROR level and one has a needle in it.
+	void appendLogLine(std::string& out, std::mt19937_64& rng, uint64_t line) {
+		unsigned seconds = static_cast<unsigned>(line % 86400);
+		appendFormatted(out, "2024-03-07 %02u:%02u:%02u", seconds / 3600, seconds / 60 % 60, seconds % 60, 0);
+
+		uint64_t level = below(rng, 20000);
+		out += level < 70 ? " ERROR" : level < 470 ? " WARN" : level < 4470 ? " DEBUG" : " INFO";
+		appendFormatted(out, " [worker-%u] ", static_cast<unsigned>(below(rng, 16)), 0, 0, 0);
+
+		uint64_t kind = below(rng, 20000);
+		unsigned a = static_cast<unsigned>(below(rng, 256));
+		unsigned b = static_cast<unsigned>(below(rng, 256));
+		unsigned c = static_cast<unsigned>(below(rng, 256));
+		unsigned duration = static_cast<unsigned>(below(rng, 2000));
+		if (kind < 1) {
+			appendFormatted(out, "found a needle in item %u", a * 256 + b, 0, 0, 0);
+		} else if (kind < 11) {
+			out += "request id=";
+			appendHex(out, rng, 32);
+		} else if (kind < 31) {
+			const char* errors[] = { "upstream timeout after %ums", "connection refused after %ums", "connection reset after %ums" };
+			appendFormatted(out, errors[below(rng, 3)], duration, 0, 0, 0);
+		} else if (kind < 71) {
+			out += "login user=";
+			appendLetters(out, rng, 3, 8);
+			out += "@";
+			appendLetters(out, rng, 4, 10);
+			out += ".com";
+		} else if (kind < 171) {
+			appendFormatted(out, "POST /api/v1/orders from 10.0.%u.%u status=5%02u in %ums", a, b, c % 4, duration);
+		} else if (kind < 1171) {
+			// Addresses on other domains are near misses for the email pattern
+			out += "login user=";
+			appendLetters(out, rng, 3, 8);
+			out += "@";
+			appendLetters(out, rng, 4, 10);
+			out += ".org";
+		} else {
+			appendFormatted(out, "GET /api/v1/items/%u from 10.0.%u.%u status=200 in %ums", a * 256 + b, b, c, duration);
+		}
+		out.push_back('\n');
+	}
+
+	void appendNearMiss(std::string& out, std::mt19937_64& rng) {
+		const char* fragments[] = {
+			"needl", "eedle", "needlf", "timeou", "refuse", "rese", "status=4", "status=5x", "bob@example.co", "bob@.com", "2024-03-0",
+			"abcdefghijklmno", "abcdefghijklmnoq", "erro", "eror"
+		};
+		const size_t num_fragments = sizeof(fragments) / sizeof(fragments[0]);
+
+		// The hex digits are one short of a request ID, so they count as another fragment
+		uint64_t fragment = below(rng, num_fragments + 1);
+		if (fragment == num_fragments) {
+			appendHex(out, rng, 31);
+			out.push_back('g');
+		} else {
+			out += fragments[fragment];
+		}
+		out.push_back(below(rng, 8) == 0 ? '\n' : ' ');
+	}
+}
+
+const char* getCorpusName(CorpusKind kind) {
+	switch (kind) {
+		case CorpusKind::Log:
+			return "log";
+		case CorpusKind::RandomBytes:
+			return "random";
+		case CorpusKind::NearMiss:
+			return "near-miss";
+	}
+	return "";
+}
+
+std::string generateCorpus(CorpusKind kind, size_t size) {
+	std::mt19937_64 rng(static_cast<uint64_t>(kind) + 1);
+	std::string corpus;
+	corpus.reserve(size + 256);
+
+	if (kind == CorpusKind::RandomBytes) {
+		while (corpus.size() < size) {
+			uint64_t bytes = rng();
+			for (int i = 0; i < 8; i++) {
+				corpus.push_back(static_cast<char>(bytes >> (i * 8)));
+			}
+		}
+	} else {
+		for (uint64_t line = 0; corpus.size() < size; line++) {
+			if (kind == CorpusKind::Log) {
+				appendLogLine(corpus, rng, line);
+			} else {
+				appendNearMiss(corpus, rng);
+			}
+		}
+	}
+
+	corpus.resize(size);
+	return corpus;
+}
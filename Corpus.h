@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Inputs for the benchmarks in Bench.cpp. Each kind is generated from a fixed seed, so the same size always gives the same bytes (on any platform), and
+// a shorter corpus is a prefix of a longer one.
+enum class CorpusKind {
+	// Lines like a web server's log, with the things the benchmark patterns look for scattered through them at realistic rates
+	Log,
+	// Uniformly random bytes, including newlines and NULs
+	RandomBytes,
+	// Fragments that almost match the benchmark patterns but don't, e.g. "needl" and "timeou", to keep matchers busy partway into a match
+	NearMiss
+};
+
+const char* getCorpusName(CorpusKind kind);
+
+// Generates size bytes of the given kind
+std::string generateCorpus(CorpusKind kind, size_t size);
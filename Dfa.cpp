@@ -0,0 +1,557 @@
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <cstdint>
+#include "Dfa.h"
+
+const size_t max_dfa_states = 1 << 16;
+
+namespace {
+	using NfaStateSet = std::vector<int32_t>;
+
+	// The indices of a set of patterns, in order
+	using PatternSet = std::vector<uint32_t>;
+
+	// A DFA state is a set of NFA states, along with whether we're at the start of the input (where ^ can match) and the patterns that the byte that
+	// led to it would let match if it was a newline that ended the input (since $ can match before it)
+	using SubsetKey = std::tuple<NfaStateSet, bool, PatternSet>;
+
+	// is_included has a flag for each NFA state, which must all be clear. The ones the closure sets are cleared again before it returns, so that it
+	// takes as long as the closure is big rather than as the NFA is, which matters for the long chains of states of repeats like x{500}.
+	NfaStateSet getClosure(const Nfa& nfa, const NfaStateSet& states, bool is_at_start, bool is_at_end, std::vector<bool>& is_included) {
+		std::vector<int32_t> pending(states.begin(), states.end());
+		NfaStateSet closure;
+
+		while (!pending.empty()) {
+			int32_t state = pending.back();
+			pending.pop_back();
+			if (is_included[state]) {
+				continue;
+			}
+			is_included[state] = true;
+			closure.push_back(state);
+
+			for (const NfaEpsilonTransition& transition : nfa.getStates()[state].epsilon_transitions) {
+				bool is_allowed = transition.assertion == Assertion::None
+					|| (transition.assertion == Assertion::StringStart && is_at_start)
+					|| (transition.assertion == Assertion::StringEnd && is_at_end);
+				if (is_allowed) {
+					pending.push_back(transition.to);
+				}
+			}
+		}
+
+		for (int32_t state : closure) {
+			is_included[state] = false;
+		}
+		std::sort(closure.begin(), closure.end());
+		return closure;
+	}
+
+	// Drops the states that the same state of an earlier copy in states subsumes (see Nfa::addOptionalCopies). A Dfa only says whether there's a
+	// match, which this doesn't change, but otherwise a.{0,300}b would need a DFA state for each set of the last 300 bytes that were an a.
+	NfaStateSet dropSubsumedCopies(const Nfa& nfa, NfaStateSet states) {
+		std::map<std::pair<int32_t, uint32_t>, uint32_t> first_copies;
+		for (int32_t state : states) {
+			const NfaState& nfa_state = nfa.getStates()[state];
+			if (nfa_state.copies != -1) {
+				auto inserted = first_copies.emplace(std::make_pair(nfa_state.copies, nfa_state.copy_offset), nfa_state.copy_index);
+				inserted.first->second = std::min(inserted.first->second, nfa_state.copy_index);
+			}
+		}
+		if (first_copies.empty()) {
+			return states;
+		}
+
+		states.erase(std::remove_if(states.begin(), states.end(), [&](int32_t state) {
+			const NfaState& nfa_state = nfa.getStates()[state];
+			return nfa_state.copies != -1 && first_copies[std::make_pair(nfa_state.copies, nfa_state.copy_offset)] != nfa_state.copy_index;
+		}), states.end());
+		return states;
+	}
+
+	NfaStateSet getNext(const Nfa& nfa, const NfaStateSet& states, uint8_t byte) {
+		NfaStateSet next;
+		for (int32_t state : states) {
+			for (const NfaByteTransition& transition : nfa.getStates()[state].byte_transitions) {
+				if (transition.bytes[byte]) {
+					next.push_back(transition.to);
+				}
+			}
+		}
+
+		return next;
+	}
+
+	PatternSet getAcceptedPatterns(const Nfa& nfa, const NfaStateSet& states) {
+		PatternSet patterns;
+		for (int32_t state : states) {
+			int32_t pattern = nfa.getStates()[state].pattern;
+			if (pattern != -1 && nfa.getAccepts()[pattern] == state) {
+				patterns.push_back(static_cast<uint32_t>(pattern));
+			}
+		}
+
+		std::sort(patterns.begin(), patterns.end());
+		return patterns;
+	}
+
+	PatternSet mergePatterns(const PatternSet& a, const PatternSet& b) {
+		PatternSet merged;
+		std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(merged));
+		return merged;
+	}
+
+	// Splits the bytes into classes that every byte transition of nfa treats alike, so that the DFA only has to follow one byte of each class.
+	// Newlines are always in a class of their own, since $ can match before them.
+	std::vector<ByteSet> getByteClasses(const Nfa& nfa) {
+		ByteSet newline;
+		newline.set('\n');
+		std::vector<ByteSet> classes { newline, ~newline };
+
+		for (const NfaState& state : nfa.getStates()) {
+			for (const NfaByteTransition& transition : state.byte_transitions) {
+				std::vector<ByteSet> split_classes;
+				for (const ByteSet& byte_class : classes) {
+					ByteSet inside = byte_class & transition.bytes;
+					ByteSet outside = byte_class & ~transition.bytes;
+					if (inside.any()) {
+						split_classes.push_back(inside);
+					}
+					if (outside.any()) {
+						split_classes.push_back(outside);
+					}
+				}
+				classes = std::move(split_classes);
+			}
+		}
+
+		return classes;
+	}
+
+	uint8_t getFirstByte(const ByteSet& bytes) {
+		uint8_t byte = 0;
+		while (!bytes[byte]) {
+			byte++;
+		}
+
+		return byte;
+	}
+
+	// The patterns that would match if the input ended with a newline after states, which has to be checked before reading the newline since that's
+	// where $ can match
+	PatternSet getPatternsAcceptedBeforeFinalNewline(const Nfa& nfa, const NfaStateSet& states, bool is_at_start, std::vector<bool>& is_included) {
+		NfaStateSet before_newline = getClosure(nfa, states, is_at_start, true, is_included);
+		return mergePatterns(
+			getAcceptedPatterns(nfa, before_newline),
+			getAcceptedPatterns(nfa, getClosure(nfa, getNext(nfa, before_newline, '\n'), false, true, is_included))
+		);
+	}
+
+	// Whether an NFA state can still make a difference to a match, i.e. it can read another byte, it accepts, or it can accept at the end. (Once the
+	// closure has been taken, the rest only lead to these ones or need ^.)
+	bool isLive(const Nfa& nfa, int32_t state) {
+		const NfaState& nfa_state = nfa.getStates()[state];
+		if (!nfa_state.byte_transitions.empty() || std::find(nfa.getAccepts().begin(), nfa.getAccepts().end(), state) != nfa.getAccepts().end()) {
+			return true;
+		}
+
+		return std::any_of(nfa_state.epsilon_transitions.begin(), nfa_state.epsilon_transitions.end(), [](const NfaEpsilonTransition& transition) {
+			return transition.assertion == Assertion::StringEnd;
+		});
+	}
+
+	// A state of a FindDfa is the NFA states of each of its groups, along with whether we're at the start of the input, whether a match has been
+	// found, and how many of its groups come before the one that matched before the newline that led to it (or -1 if none did)
+	using FindKey = std::tuple<std::vector<NfaStateSet>, bool, bool, int32_t>;
+
+	// The first of groups that would have a match if the input ended after it, or -1
+	int32_t getGroupMatchedAtEnd(const Nfa& nfa, const std::vector<NfaStateSet>& groups, bool is_at_start, std::vector<bool>& is_included) {
+		for (size_t i = 0; i < groups.size(); i++) {
+			if (!getAcceptedPatterns(nfa, getClosure(nfa, groups[i], is_at_start, true, is_included)).empty()) {
+				return static_cast<int32_t>(i);
+			}
+		}
+
+		return -1;
+	}
+}
+
+bool buildDfa(const Nfa& nfa, Dfa& dfa_out, std::string& error_out, size_t max_states) {
+	std::map<SubsetKey, int32_t> state_ids;
+	std::vector<SubsetKey> pending;
+
+	auto getStateId = [&](SubsetKey key) {
+		auto existing = state_ids.find(key);
+		if (existing != state_ids.end()) {
+			return existing->second;
+		}
+
+		int32_t id = static_cast<int32_t>(state_ids.size());
+		state_ids.emplace(key, id);
+		pending.push_back(std::move(key));
+		return id;
+	};
+
+	// Shared by all the closures (see getClosure)
+	std::vector<bool> is_included(nfa.getStates().size(), false);
+	getStateId(SubsetKey { getClosure(nfa, NfaStateSet { nfa.getStart() }, true, false, is_included), true, false });
+	std::vector<ByteSet> byte_classes = getByteClasses(nfa);
+
+	// States are numbered in the order they're created, so they're also processed in that order
+	dfa_out.states.clear();
+	dfa_out.num_patterns = static_cast<uint32_t>(nfa.getAccepts().size());
+	for (size_t i = 0; i < pending.size(); i++) {
+		if (pending.size() > max_states) {
+			error_out = "Regex is too complex, it needs more than " + std::to_string(max_states) + " states";
+			return false;
+		}
+
+		const SubsetKey key = pending[i];
+		NfaStateSet states = std::get<0>(key);
+		bool is_at_start = std::get<1>(key);
+		const PatternSet& follows_accepted_newline = std::get<2>(key);
+
+		DfaState dfa_state;
+		dfa_state.accepted_patterns = getAcceptedPatterns(nfa, states);
+		dfa_state.is_accepting = dfa_state.accepted_patterns.size() == nfa.getAccepts().size();
+		dfa_state.patterns_accepted_at_end = mergePatterns(follows_accepted_newline, getAcceptedPatterns(nfa, getClosure(nfa, states, is_at_start, true, is_included)));
+		dfa_state.is_dead = false;
+
+		if (dfa_state.is_accepting) {
+			// Matching stops here, so there's nowhere to go
+			dfa_state.transitions.fill(static_cast<int32_t>(i));
+		} else {
+			// Patterns that have just matched don't need to be followed any further, which keeps them (e.g. a.*) from multiplying the states of the others
+			if (!dfa_state.accepted_patterns.empty()) {
+				states.erase(std::remove_if(states.begin(), states.end(), [&](int32_t state) {
+					int32_t pattern = nfa.getStates()[state].pattern;
+					return pattern != -1 && std::binary_search(dfa_state.accepted_patterns.begin(), dfa_state.accepted_patterns.end(), static_cast<uint32_t>(pattern));
+				}), states.end());
+			}
+
+			PatternSet accepted_before_newline = getPatternsAcceptedBeforeFinalNewline(nfa, states, is_at_start, is_included);
+			for (const ByteSet& byte_class : byte_classes) {
+				// Searching means a match can also begin after any byte
+				uint8_t first_byte = getFirstByte(byte_class);
+				NfaStateSet next = getNext(nfa, states, first_byte);
+				next.push_back(nfa.getStart());
+
+				NfaStateSet closure = dropSubsumedCopies(nfa, getClosure(nfa, next, false, false, is_included));
+				int32_t to = getStateId(SubsetKey { std::move(closure), false, first_byte == '\n' ? accepted_before_newline : PatternSet {} });
+				for (int byte = 0; byte < 256; byte++) {
+					if (byte_class[byte]) {
+						dfa_state.transitions[byte] = to;
+					}
+				}
+			}
+		}
+
+		dfa_out.states.push_back(dfa_state);
+	}
+
+	return true;
+}
+
+Dfa minimizeDfa(const Dfa& dfa) {
+	const size_t num_states = dfa.states.size();
+
+	// Moore's algorithm: start by splitting the states by what they accept, then split them by which group each byte leads to until that's stable
+	std::vector<int32_t> groups(num_states);
+	std::map<std::pair<PatternSet, PatternSet>, int32_t> acceptances;
+	for (size_t i = 0; i < num_states; i++) {
+		auto acceptance = std::make_pair(dfa.states[i].accepted_patterns, dfa.states[i].patterns_accepted_at_end);
+		groups[i] = acceptances.emplace(acceptance, static_cast<int32_t>(acceptances.size())).first->second;
+	}
+
+	// Bytes that lead to the same state from every state (like the bytes of a class) always lead to the same group, so only the first of them has to be
+	// compared. A chain like x{1000} takes as many rounds as it has states, so this keeps each round short.
+	std::vector<int> distinct_bytes;
+	std::map<std::vector<int32_t>, int> columns;
+	for (int byte = 0; byte < 256; byte++) {
+		std::vector<int32_t> column;
+		for (const DfaState& state : dfa.states) {
+			column.push_back(state.transitions[byte]);
+		}
+		if (columns.emplace(std::move(column), byte).second) {
+			distinct_bytes.push_back(byte);
+		}
+	}
+
+	size_t num_groups = 0;
+	while (true) {
+		std::map<std::vector<int32_t>, int32_t> signatures;
+		std::vector<int32_t> next_groups(num_states);
+		for (size_t i = 0; i < num_states; i++) {
+			std::vector<int32_t> signature { groups[i] };
+			for (int byte : distinct_bytes) {
+				signature.push_back(groups[dfa.states[i].transitions[byte]]);
+			}
+
+			auto inserted = signatures.emplace(std::move(signature), static_cast<int32_t>(signatures.size()));
+			next_groups[i] = inserted.first->second;
+		}
+
+		groups = std::move(next_groups);
+		if (signatures.size() == num_groups) {
+			break;
+		}
+		num_groups = signatures.size();
+	}
+
+	// Renumber the groups so that the start state stays at 0
+	std::vector<int32_t> group_ids(num_groups, -1);
+	Dfa minimized;
+	minimized.num_patterns = dfa.num_patterns;
+	for (size_t i = 0; i < num_states; i++) {
+		if (group_ids[groups[i]] != -1) {
+			continue;
+		}
+
+		group_ids[groups[i]] = static_cast<int32_t>(minimized.states.size());
+		minimized.states.push_back(dfa.states[i]);
+	}
+	for (DfaState& state : minimized.states) {
+		for (int32_t& target : state.transitions) {
+			target = group_ids[groups[target]];
+		}
+	}
+
+	// Dead states are the ones that can't reach a state that accepts
+	std::vector<std::vector<int32_t>> predecessors(minimized.states.size());
+	std::vector<int32_t> pending;
+	for (size_t i = 0; i < minimized.states.size(); i++) {
+		DfaState& state = minimized.states[i];
+		state.is_dead = state.accepted_patterns.empty() && state.patterns_accepted_at_end.empty();
+		if (!state.is_dead) {
+			pending.push_back(static_cast<int32_t>(i));
+		}
+
+		for (int32_t target : state.transitions) {
+			predecessors[target].push_back(static_cast<int32_t>(i));
+		}
+	}
+	while (!pending.empty()) {
+		int32_t state = pending.back();
+		pending.pop_back();
+		for (int32_t predecessor : predecessors[state]) {
+			if (minimized.states[predecessor].is_dead) {
+				minimized.states[predecessor].is_dead = false;
+				pending.push_back(predecessor);
+			}
+		}
+	}
+
+	return minimized;
+}
+
+bool buildFindDfa(const Nfa& nfa, FindDfa& dfa_out, std::string& error_out, size_t max_states) {
+	std::map<FindKey, int32_t> state_ids;
+	std::vector<FindKey> pending;
+	// Shared by the closures (see getClosure) and getTransition, which both leave it clear
+	std::vector<bool> is_included(nfa.getStates().size(), false);
+
+	auto getStateId = [&](FindKey key) {
+		// With no groups left, and no match before a newline that might end the input, the search is over
+		if (std::get<0>(key).empty() && std::get<3>(key) == -1) {
+			return -1;
+		}
+
+		auto existing = state_ids.find(key);
+		if (existing != state_ids.end()) {
+			return existing->second;
+		}
+
+		int32_t id = static_cast<int32_t>(state_ids.size());
+		state_ids.emplace(key, id);
+		pending.push_back(std::move(key));
+		return id;
+	};
+
+	// Each group continues from the one it came from (minus the states an earlier group already has, since a match that started earlier would be
+	// preferred from there on), and then a new group starts unless there's already a match. The groups after the first one to match are dropped.
+	auto getTransition = [&](const std::vector<NfaStateSet>& continued, const NfaStateSet& started, bool is_at_start, bool has_match, int32_t group_matched_before_newline) {
+		FindTransition transition { -1, {}, -1, group_matched_before_newline };
+		std::vector<NfaStateSet> groups;
+		auto addGroup = [&](const NfaStateSet& states, int32_t source) {
+			NfaStateSet group;
+			for (int32_t state : states) {
+				if (!is_included[state] && isLive(nfa, state)) {
+					is_included[state] = true;
+					group.push_back(state);
+				}
+			}
+			if (!group.empty()) {
+				groups.push_back(std::move(group));
+				transition.group_sources.push_back(source);
+			}
+		};
+
+		for (size_t i = 0; i < continued.size(); i++) {
+			addGroup(continued[i], static_cast<int32_t>(i));
+		}
+		if (!has_match) {
+			addGroup(started, -1);
+		}
+
+		for (const NfaStateSet& group : groups) {
+			for (int32_t state : group) {
+				is_included[state] = false;
+			}
+		}
+
+		for (size_t i = 0; i < groups.size(); i++) {
+			if (!getAcceptedPatterns(nfa, groups[i]).empty()) {
+				transition.matched_group = static_cast<int32_t>(i);
+				groups.resize(i + 1);
+				transition.group_sources.resize(i + 1);
+				has_match = true;
+				break;
+			}
+		}
+
+		// The match before the newline beats the groups that started after it
+		int32_t newline_match_rank = -1;
+		if (group_matched_before_newline != -1) {
+			newline_match_rank = static_cast<int32_t>(std::count_if(transition.group_sources.begin(), transition.group_sources.end(), [&](int32_t source) {
+				return source != -1 && source <= group_matched_before_newline;
+			}));
+		}
+
+		transition.to = getStateId(FindKey { groups, is_at_start, has_match, newline_match_rank });
+		return transition;
+	};
+
+	NfaStateSet start_closure = getClosure(nfa, NfaStateSet { nfa.getStart() }, false, false, is_included);
+	dfa_out.states.clear();
+	dfa_out.input_start = getTransition({}, getClosure(nfa, NfaStateSet { nfa.getStart() }, true, false, is_included), true, false, -1);
+	dfa_out.start = getTransition({}, start_closure, false, false, -1);
+	std::vector<ByteSet> byte_classes = getByteClasses(nfa);
+
+	for (size_t i = 0; i < pending.size(); i++) {
+		if (pending.size() > max_states) {
+			error_out = "Regex is too complex to find matches with, it needs more than " + std::to_string(max_states) + " states";
+			return false;
+		}
+
+		const FindKey key = pending[i];
+		const std::vector<NfaStateSet>& groups = std::get<0>(key);
+		bool is_at_start = std::get<1>(key);
+		bool has_match = std::get<2>(key);
+		int32_t newline_match_rank = std::get<3>(key);
+
+		FindDfaState state;
+		state.num_groups = groups.size();
+		state.has_match = has_match;
+		// Where the input ending here would leave a match is also where a newline that ends it would
+		int32_t group_matched_at_end = getGroupMatchedAtEnd(nfa, groups, is_at_start, is_included);
+		state.is_matched_before_newline = newline_match_rank != -1 && (group_matched_at_end == -1 || group_matched_at_end >= newline_match_rank);
+		state.group_matched_at_end = state.is_matched_before_newline ? -1 : group_matched_at_end;
+
+		for (const ByteSet& byte_class : byte_classes) {
+			uint8_t first_byte = getFirstByte(byte_class);
+			std::vector<NfaStateSet> continued;
+			for (const NfaStateSet& group : groups) {
+				continued.push_back(getClosure(nfa, getNext(nfa, group, first_byte), false, false, is_included));
+			}
+
+			FindTransition transition = getTransition(continued, start_closure, false, has_match, first_byte == '\n' ? group_matched_at_end : -1);
+			auto existing = std::find_if(state.transitions.begin(), state.transitions.end(), [&](const FindTransition& other) {
+				return other.to == transition.to
+					&& other.group_sources == transition.group_sources
+					&& other.matched_group == transition.matched_group
+					&& other.group_matched_before_newline == transition.group_matched_before_newline;
+			});
+			if (existing == state.transitions.end()) {
+				existing = state.transitions.insert(state.transitions.end(), transition);
+			}
+
+			uint32_t transition_index = static_cast<uint32_t>(existing - state.transitions.begin());
+			for (int byte = 0; byte < 256; byte++) {
+				if (byte_class[byte]) {
+					state.byte_transitions[byte] = transition_index;
+				}
+			}
+		}
+
+		dfa_out.states.push_back(std::move(state));
+	}
+
+	return true;
+}
+
+std::vector<std::vector<ByteSet>> findRuns(const Dfa& dfa, size_t max_length, const std::function<bool(const ByteSet&)>& can_compare) {
+	const size_t num_states = dfa.states.size();
+
+	// The length of the shortest input that leads to each state
+	std::vector<int32_t> depths(num_states, -1);
+	std::vector<int32_t> pending { 0 };
+	depths[0] = 0;
+	for (size_t i = 0; i < pending.size(); i++) {
+		for (int32_t target : dfa.states[pending[i]].transitions) {
+			if (depths[target] == -1) {
+				depths[target] = depths[pending[i]] + 1;
+				pending.push_back(target);
+			}
+		}
+	}
+
+	std::vector<ByteSet> forward_bytes(num_states);
+	std::vector<int32_t> forward_targets(num_states, -1);
+	for (size_t i = 0; i < num_states; i++) {
+		const DfaState& state = dfa.states[i];
+		if (!state.accepted_patterns.empty() || state.is_dead) {
+			continue;
+		}
+
+		for (int byte = 0; byte < 256; byte++) {
+			int32_t target = state.transitions[byte];
+			if (depths[target] != depths[i] + 1) {
+				continue;
+			}
+
+			if (forward_targets[i] == -1) {
+				forward_targets[i] = target;
+			} else if (forward_targets[i] != target) {
+				forward_targets[i] = -2;
+				break;
+			}
+			forward_bytes[i].set(static_cast<uint8_t>(byte));
+		}
+
+		if (forward_targets[i] >= 0 && !can_compare(forward_bytes[i])) {
+			forward_targets[i] = -2;
+		}
+	}
+
+	// How far each state is into its chain, modulo max_length. The states are visited in order of depth, so each one that continues a chain is
+	// reached from the state before it first.
+	std::vector<size_t> chain_offsets(num_states, 0);
+	std::vector<bool> is_chained(num_states, false);
+	for (int32_t state : pending) {
+		int32_t target = forward_targets[state];
+		if (target >= 0 && !is_chained[target]) {
+			is_chained[target] = true;
+			chain_offsets[target] = (chain_offsets[state] + 1) % max_length;
+		}
+	}
+
+	std::vector<std::vector<ByteSet>> runs(num_states);
+	for (size_t i = 0; i < num_states; i++) {
+		if (chain_offsets[i] != 0) {
+			continue;
+		}
+
+		int32_t state = static_cast<int32_t>(i);
+		while (runs[i].size() < max_length && forward_targets[state] >= 0) {
+			runs[i].push_back(forward_bytes[state]);
+			state = forward_targets[state];
+		}
+	}
+
+	return runs;
+}
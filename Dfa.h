@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Nfa.h"
+
+struct DfaState {
+	// The next state for each byte
+	std::array<int32_t, 256> transitions;
+	// A match has been found (of every pattern, for a set of them), so the rest of the input doesn't need to be read
+	bool is_accepting;
+	// The patterns that have matched once this state is reached
+	std::vector<uint32_t> accepted_patterns;
+	// The patterns that match if the input ends in this state (i.e. ones that need $)
+	std::vector<uint32_t> patterns_accepted_at_end;
+	// No input can lead to a match from this state
+	bool is_dead;
+};
+
+// A DFA that searches for a pattern (or each of a set of them) anywhere in its input, starting in state 0
+struct Dfa {
+	std::vector<DfaState> states;
+	uint32_t num_patterns;
+};
+
+// Subset construction can blow up exponentially, so the DFA is limited to this many states
+extern const size_t max_dfa_states;
+
+// Builds the DFA that searches for matches of nfa starting anywhere in the input, using subset construction. Returns false and sets error_out if it
+// would have more than max_states states. Once a pattern has matched, the DFA stops following it until it can start again.
+bool buildDfa(const Nfa& nfa, Dfa& dfa_out, std::string& error_out, size_t max_states=max_dfa_states);
+
+// Merges the states that can't be told apart by any input (including all of the dead states), and marks the dead state if there is one
+Dfa minimizeDfa(const Dfa& dfa);
+
+// A transition of a FindDfa, which also says how the positions that its groups started at carry over
+struct FindTransition {
+	// The next state, or -1 if there's nothing left to follow
+	int32_t to;
+	// For each group of the next state, the group of this one that it continues, or -1 if it's a new one that starts after this byte
+	std::vector<int32_t> group_sources;
+	// The group of the next state with a match that ends after this byte, or -1 if there isn't one
+	int32_t matched_group;
+	// The group of this state with a match that ends before this byte if it's a newline that ends the input (where $ can match), or -1
+	int32_t group_matched_before_newline;
+};
+
+struct FindDfaState {
+	// The distinct transitions, and which one each byte takes
+	std::vector<FindTransition> transitions;
+	std::array<uint32_t, 256> byte_transitions;
+	size_t num_groups;
+	// A match has been found, so no more groups are started
+	bool has_match;
+	// If the input ends in this state, the group with a match that ends there (or -1), or whether the match is the one that ended before the newline
+	// that led here instead
+	int32_t group_matched_at_end;
+	bool is_matched_before_newline;
+};
+
+// A DFA that finds where the leftmost-longest match of a pattern is, searching from a given position. Each state is a list of groups of NFA states,
+// one for each position that a match could still start at, earliest first. The code that runs it keeps the position each group started at, which
+// the transitions carry over to the next state's groups. Once a group has a match the ones after it are dropped and no more are started, so it stops
+// once the leftmost match can't get any longer.
+struct FindDfa {
+	std::vector<FindDfaState> states;
+	// The transitions that start the first group, at the start of the input or anywhere else
+	FindTransition input_start;
+	FindTransition start;
+};
+
+// Builds the FindDfa for the single pattern of nfa. Returns false and sets error_out if it would have more than max_states states.
+bool buildFindDfa(const Nfa& nfa, FindDfa& dfa_out, std::string& error_out, size_t max_states=max_dfa_states);
+
+// For each state, the classes of the run of the pattern that it's in the middle of (e.g. the rest of a literal, or of \d{16}), i.e. the chain of
+// classes whose bytes all lead to the same state that's one step further from the start, when no other byte does, and that can_compare accepts.
+// Each run is at most max_length classes long, and is empty if the state doesn't continue one. Runs end at states that accept a pattern, so none
+// are skipped over. Only every max_length-th state along a chain gets its run, since the run before it covers the states in between.
+std::vector<std::vector<ByteSet>> findRuns(const Dfa& dfa, size_t max_length, const std::function<bool(const ByteSet&)>& can_compare);
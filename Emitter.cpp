@@ -0,0 +1,268 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <cctype>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Object/Archive.h>
+#include <llvm/Object/ArchiveWriter.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include "Emitter.h"
+#include "Matcher.h"
+#include "Optimizer.h"
+#include "Target.h"
+
+namespace {
+	void prepareModule(llvm::Module& module, llvm::TargetMachine& target_machine, unsigned opt_level) {
+		module.setDataLayout(target_machine.createDataLayout());
+		module.setTargetTriple(target_machine.getTargetTriple().str());
+		setTargetAttributes(module, target_machine);
+		optimizeModule(module, &target_machine, opt_level);
+	}
+
+	bool emitObject(llvm::Module& module, llvm::TargetMachine& target_machine, unsigned opt_level, llvm::raw_pwrite_stream& output, std::string& error_out) {
+		prepareModule(module, target_machine, opt_level);
+
+		llvm::legacy::PassManager pass_manager;
+		if (target_machine.addPassesToEmitFile(pass_manager, output, nullptr, llvm::CGFT_ObjectFile)) {
+			error_out = "The target can't emit object files";
+			return false;
+		}
+		pass_manager.run(module);
+
+		return true;
+	}
+
+	// The regex is quoted in a comment, so it mustn't be able to end it
+	std::string escapeComment(const std::string& text) {
+		std::string escaped;
+		for (size_t i = 0; i < text.size(); i++) {
+			escaped += text[i];
+			if (text[i] == '*' && i + 1 < text.size() && text[i + 1] == '/') {
+				escaped += ' ';
+			}
+		}
+
+		return escaped;
+	}
+
+	// Macros are named by the prefix in upper case
+	std::string getMacroPrefix(const std::string& prefix) {
+		std::string macro_prefix;
+		for (char c : prefix) {
+			macro_prefix += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+		}
+
+		return macro_prefix;
+	}
+
+	std::string getIncludeGuard(const std::string& prefix) {
+		return getMacroPrefix(prefix) + "_H";
+	}
+
+	// Writes a static library with a symbol table, so the linker only pulls in the members whose symbols are used
+	bool writeLibrary(const std::vector<llvm::NewArchiveMember>& members, const std::string& path, std::string& error_out) {
+		llvm::Error error = llvm::writeArchive(path, members, true, llvm::object::Archive::K_GNU, true, false);
+		if (error) {
+			error_out = llvm::toString(std::move(error));
+			return false;
+		}
+
+		return true;
+	}
+
+	// Starts the header for matchers named by prefix. In find mode, the find functions read files differently from the others, which is noted.
+	void writeHeaderStart(llvm::raw_ostream& output, const std::string& prefix, bool is_find_mode) {
+		std::string guard = getIncludeGuard(prefix);
+		output << "#ifndef " << guard << "\n";
+		output << "#define " << guard << "\n\n";
+		output << "#include <stddef.h>\n";
+		output << "#include <stdint.h>\n\n";
+		output << "#ifdef __cplusplus\n";
+		output << "extern \"C\" {\n";
+		output << "#endif\n\n";
+		output << "/*\n";
+		output << " * The matchers keep no state between calls, so they can be called from any number of threads at once. The fd and file functions read\n";
+		output << " * files that can't be mapped in 64 KiB blocks on the stack";
+		if (is_find_mode) {
+			output << ", except for the " << find_fd_function_suffix << " and " << find_file_function_suffix << " functions, which\n";
+			output << " * read the whole file into a buffer from malloc, since matches can be anywhere and any length";
+		}
+		output << ".\n";
+		output << " */\n\n";
+	}
+
+	// Declares the entry points that compileRegex builds with options, named by prefix
+	void writeDeclarations(llvm::raw_ostream& output, const std::string& prefix, const CompileOptions& options) {
+		output << "/* Returns 1 if buf matches, or 0 otherwise */\n";
+		output << "int32_t " << getSymbolName(prefix, match_function_suffix) << "(const char* buf, size_t len);\n";
+		output << "/* Returns 1 if the contents of fd match, 0 otherwise, or -1 if fd can't be read */\n";
+		output << "int32_t " << getSymbolName(prefix, match_fd_function_suffix) << "(int32_t fd);\n";
+		output << "/* Returns 1 if the contents of the file at path match, 0 otherwise, or -1 if it can't be opened or read */\n";
+		output << "int32_t " << getSymbolName(prefix, match_file_function_suffix) << "(const char* path);\n";
+		output << "/* Sets results[i] to 1 if record i matches or 0 otherwise, for each of the n records stored back to back in data, where record i is\n";
+		output << "   data[offsets[i], offsets[i + 1]) (so offsets has n + 1 entries). Returns how many matched. */\n";
+		output << "size_t " << getSymbolName(prefix, match_batch_function_suffix) << "(const char* data, const uint32_t* offsets, size_t n, uint8_t* results);\n";
+		if (options.line_mode) {
+			output << "/* Prints the matching lines of fd (prefixed with name if it isn't null) and returns how many there were, or -1 if fd can't be read */\n";
+			output << "int64_t " << getSymbolName(prefix, grep_fd_function_suffix) << "(int32_t fd, const char* name);\n";
+			output << "/* Like the above, but for the file at path, and also returning -1 if it can't be opened */\n";
+			output << "int64_t " << getSymbolName(prefix, grep_file_function_suffix) << "(const char* path, const char* name);\n";
+			output << "/* Prints the matching lines of buf like the above, carrying on from state: the number of lines before buf and how many of them\n";
+			output << "   matched (both 0 at the start of the input). Returns the updated count, and takes the last line of buf to be complete. */\n";
+			output << "int64_t " << getSymbolName(prefix, grep_lines_function_suffix) << "(const char* buf, size_t len, const char* name, int64_t state[2]);\n";
+			output << "/* Like the above, but only counts the lines without printing anything, so that parts of an input can be counted in parallel */\n";
+			output << "int64_t " << getSymbolName(prefix, count_lines_function_suffix) << "(const char* buf, size_t len, int64_t state[2]);\n";
+		}
+		if (options.find_mode) {
+			output << "/* If there's a match in buf at or after from, sets start and end to the offsets of the leftmost-longest one and returns 1. Otherwise\n";
+			output << "   returns 0. */\n";
+			output << "int32_t " << getSymbolName(prefix, find_function_suffix) << "(const char* buf, size_t len, size_t from, size_t* start, size_t* end);\n";
+			output << "/* Returns how many matches there are in buf that don't overlap */\n";
+			output << "int64_t " << getSymbolName(prefix, count_function_suffix) << "(const char* buf, size_t len);\n";
+			output << "/* Prints the offsets of the matches in fd, or how many there are (prefixed with name if it isn't null), and returns how many there\n";
+			output << "   were, or -1 if fd can't be read */\n";
+			output << "int64_t " << getSymbolName(prefix, find_fd_function_suffix) << "(int32_t fd, const char* name);\n";
+			output << "/* Like the above, but for the file at path, and also returning -1 if it can't be opened */\n";
+			output << "int64_t " << getSymbolName(prefix, find_file_function_suffix) << "(const char* path, const char* name);\n";
+		}
+	}
+
+	void writeHeaderEnd(llvm::raw_ostream& output) {
+		output << "\n#ifdef __cplusplus\n";
+		output << "}\n";
+		output << "#endif\n\n";
+		output << "#endif\n";
+	}
+}
+
+bool emitIrFile(llvm::Module& module, llvm::TargetMachine& target_machine, unsigned opt_level, const std::string& path, std::string& error_out) {
+	std::error_code ec;
+	llvm::raw_fd_ostream output(path, ec);
+	if (ec) {
+		error_out = ec.message();
+		return false;
+	}
+
+	prepareModule(module, target_machine, opt_level);
+	module.print(output, nullptr);
+
+	return true;
+}
+
+bool emitObjectFile(llvm::Module& module, llvm::TargetMachine& target_machine, unsigned opt_level, const std::string& path, std::string& error_out) {
+	std::error_code ec;
+	llvm::raw_fd_ostream output(path, ec);
+	if (ec) {
+		error_out = ec.message();
+		return false;
+	}
+
+	return emitObject(module, target_machine, opt_level, output, error_out);
+}
+
+bool emitStaticLibrary(llvm::Module& module, llvm::TargetMachine& target_machine, unsigned opt_level, const std::string& path, std::string& error_out) {
+	llvm::SmallVector<char, 0> object;
+	if (!emitObjectBuffer(module, target_machine, opt_level, object, error_out)) {
+		return false;
+	}
+
+	std::vector<llvm::NewArchiveMember> members;
+	members.emplace_back(llvm::MemoryBufferRef(llvm::StringRef(object.data(), object.size()), llvm::sys::path::stem(path).str() + ".o"));
+	return writeLibrary(members, path, error_out);
+}
+
+bool emitObjectBuffer(llvm::Module& module, llvm::TargetMachine& target_machine, unsigned opt_level, llvm::SmallVectorImpl<char>& object_out, std::string& error_out) {
+	llvm::raw_svector_ostream output(object_out);
+	return emitObject(module, target_machine, opt_level, output, error_out);
+}
+
+bool emitBatchLibrary(const BatchObjects& objects, const std::string& symbol_prefix, const std::string& path, std::string& error_out) {
+	// The member names have to outlive the members, which only refer to them
+	size_t num_members = objects.entry_points.size() + objects.matchers.size();
+	std::vector<std::string> member_names;
+	member_names.reserve(num_members);
+	std::vector<llvm::NewArchiveMember> members;
+	members.reserve(num_members);
+	for (size_t i = 0; i < objects.entry_points.size(); i++) {
+		member_names.push_back(getBatchSymbolPrefix(symbol_prefix, i) + ".o");
+		members.emplace_back(llvm::MemoryBufferRef(llvm::StringRef(objects.entry_points[i].data(), objects.entry_points[i].size()), member_names.back()));
+	}
+	for (size_t i = 0; i < objects.matchers.size(); i++) {
+		member_names.push_back(objects.matcher_prefixes[i] + ".o");
+		members.emplace_back(llvm::MemoryBufferRef(llvm::StringRef(objects.matchers[i].data(), objects.matchers[i].size()), member_names.back()));
+	}
+
+	return writeLibrary(members, path, error_out);
+}
+
+bool emitHeader(const std::string& regex, const CompileOptions& options, const std::string& path, std::string& error_out) {
+	std::error_code ec;
+	llvm::raw_fd_ostream output(path, ec);
+	if (ec) {
+		error_out = ec.message();
+		return false;
+	}
+
+	const std::string& prefix = options.symbol_prefix;
+	output << "/* Generated by RegexCompiler for the regex: " << escapeComment(regex) << " */\n";
+	writeHeaderStart(output, prefix, options.find_mode);
+	writeDeclarations(output, prefix, options);
+	writeHeaderEnd(output);
+
+	return true;
+}
+
+bool emitSetHeader(const std::vector<std::string>& regexes, const CompileOptions& options, const std::string& path, std::string& error_out) {
+	std::error_code ec;
+	llvm::raw_fd_ostream output(path, ec);
+	if (ec) {
+		error_out = ec.message();
+		return false;
+	}
+
+	const std::string& prefix = options.symbol_prefix;
+	output << "/* Generated by RegexCompiler for the patterns:\n";
+	for (size_t i = 0; i < regexes.size(); i++) {
+		output << " * " << (i + 1) << ": " << escapeComment(regexes[i]) << "\n";
+	}
+	output << " */\n";
+	writeHeaderStart(output, prefix, false);
+	output << "/* The number of patterns, so matched needs (" << getMacroPrefix(prefix) << "_PATTERN_COUNT + 63) / 64 words */\n";
+	output << "#define " << getMacroPrefix(prefix) << "_PATTERN_COUNT " << regexes.size() << "\n\n";
+	output << "/* Sets bit i of matched if the (i + 1)th pattern matches buf, and returns how many matched */\n";
+	output << "int32_t " << getSymbolName(prefix, match_set_function_suffix) << "(const char* buf, size_t len, uint64_t* matched);\n";
+	output << "/* Like the above, for the contents of fd, returning -1 if fd can't be read */\n";
+	output << "int32_t " << getSymbolName(prefix, match_set_fd_function_suffix) << "(int32_t fd, uint64_t* matched);\n";
+	output << "/* Like the above, for the file at path, also returning -1 if it can't be opened */\n";
+	output << "int32_t " << getSymbolName(prefix, match_set_file_function_suffix) << "(const char* path, uint64_t* matched);\n";
+	writeHeaderEnd(output);
+
+	return true;
+}
+
+bool emitBatchHeader(const std::vector<std::string>& regexes, const CompileOptions& options, const std::string& path, std::string& error_out) {
+	std::error_code ec;
+	llvm::raw_fd_ostream output(path, ec);
+	if (ec) {
+		error_out = ec.message();
+		return false;
+	}
+
+	const std::string& prefix = options.symbol_prefix;
+	output << "/* Generated by RegexCompiler for a batch of " << regexes.size() << " regexes, each with its own matchers */\n";
+	writeHeaderStart(output, prefix, options.find_mode);
+	output << "/* The number of regexes, which are numbered from 1 */\n";
+	output << "#define " << getMacroPrefix(prefix) << "_PATTERN_COUNT " << regexes.size() << "\n";
+	for (size_t i = 0; i < regexes.size(); i++) {
+		output << "\n/* " << (i + 1) << ": " << escapeComment(regexes[i]) << " */\n";
+		writeDeclarations(output, getBatchSymbolPrefix(prefix, i), options);
+	}
+	writeHeaderEnd(output);
+
+	return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+#include "Compiler.h"
+#include "Batch.h"
+
+// Optimizes module for target_machine at opt_level and writes it to path as LLVM IR
+bool emitIrFile(llvm::Module& module, llvm::TargetMachine& target_machine, unsigned opt_level, const std::string& path, std::string& error_out);
+
+// Like emitIrFile, but writes an object file
+bool emitObjectFile(llvm::Module& module, llvm::TargetMachine& target_machine, unsigned opt_level, const std::string& path, std::string& error_out);
+
+// Like emitObjectFile, but wraps the object in a static library (with a symbol table) so it can be passed to the linker as -l<name>
+bool emitStaticLibrary(llvm::Module& module, llvm::TargetMachine& target_machine, unsigned opt_level, const std::string& path, std::string& error_out);
+
+// Like emitObjectFile, but appends the object to object_out instead of writing it to a file
+bool emitObjectBuffer(llvm::Module& module, llvm::TargetMachine& target_machine, unsigned opt_level, llvm::SmallVectorImpl<char>& object_out, std::string& error_out);
+
+// Writes the objects that compileBatch built to path as a static library, with a member for the entry points of each regex named by their prefix
+// (e.g. rx_1.o) and one for each matcher named by its own, so that the linker only pulls in the matchers that a program uses
+bool emitBatchLibrary(const BatchObjects& objects, const std::string& symbol_prefix, const std::string& path, std::string& error_out);
+
+// Writes a C header declaring the entry points that compileRegex built for regex with options
+bool emitHeader(const std::string& regex, const CompileOptions& options, const std::string& path, std::string& error_out);
+
+// Writes a C header declaring the entry points that compileRegexSet built for regexes with options
+bool emitSetHeader(const std::vector<std::string>& regexes, const CompileOptions& options, const std::string& path, std::string& error_out);
+
+// Writes a C header declaring the entry points of each regex of a batch (see getBatchSymbolPrefix), and the number of them
+bool emitBatchHeader(const std::vector<std::string>& regexes, const CompileOptions& options, const std::string& path, std::string& error_out);
@@ -0,0 +1,455 @@
+#include <array>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Constants.h>
+#include "Find.h"
+#include "Matcher.h"
+#include "Runtime.h"
+#include "TypeProvider.h"
+#include "ConstantProvider.h"
+
+namespace {
+	// A transition back to the same state that only starts new groups (e.g. while looking for the first byte of a match) or leaves them as they are
+	// (e.g. in the middle of .*) can be skipped over with a search, since the groups it starts would only have started at the last byte skipped
+	bool isSkippable(const FindTransition& transition, int32_t state) {
+		if (transition.to != state || transition.matched_group != -1 || transition.group_matched_before_newline != -1) {
+			return false;
+		}
+
+		for (size_t i = 0; i < transition.group_sources.size(); i++) {
+			if (transition.group_sources[i] != -1 && transition.group_sources[i] != static_cast<int32_t>(i)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Builds the function that calls find_next_function from the start of buf to its end, and returns how many matches there were, with the
+	// signature i64 (i8* buf, i64 len, i8* name). If print_matches is set, it prints each one's offsets (prefixed with name if it isn't null).
+	llvm::Function* buildFindAllFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* find_next_function, bool print_matches) {
+		TypeProvider type_provider(context);
+		ConstantProvider constant_provider(type_provider);
+
+		llvm::FunctionType* find_all_type = llvm::FunctionType::get(
+			type_provider.getInt64(),
+			std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getBytePtr() }, // buf, len, and name
+			false
+		);
+		llvm::Function* find_all = llvm::Function::Create(find_all_type, llvm::Function::PrivateLinkage, print_matches ? "rx_print_matches" : "rx_count_matches", &module);
+		llvm::Value* buf = find_all->args().begin();
+		llvm::Value* len = (find_all->args().begin() + 1);
+		llvm::Value* name = (find_all->args().begin() + 2);
+
+		llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", find_all);
+		llvm::BasicBlock* loop = llvm::BasicBlock::Create(context, "loop", find_all);
+		llvm::BasicBlock* find = llvm::BasicBlock::Create(context, "find", find_all);
+		llvm::BasicBlock* found = llvm::BasicBlock::Create(context, "found", find_all);
+		llvm::BasicBlock* next = llvm::BasicBlock::Create(context, "next", find_all);
+		llvm::BasicBlock* done = llvm::BasicBlock::Create(context, "done", find_all);
+
+		builder.SetInsertPoint(entry);
+		llvm::AllocaInst* start = builder.CreateAlloca(type_provider.getInt64(), nullptr, "start");
+		llvm::AllocaInst* end = builder.CreateAlloca(type_provider.getInt64(), nullptr, "end");
+		builder.CreateBr(loop);
+
+		builder.SetInsertPoint(loop);
+		llvm::PHINode* from = builder.CreatePHI(type_provider.getInt64(), 2);
+		llvm::PHINode* count = builder.CreatePHI(type_provider.getInt64(), 2);
+		from->addIncoming(constant_provider.getInt64(0), entry);
+		count->addIncoming(constant_provider.getInt64(0), entry);
+		builder.CreateCondBr(builder.CreateICmpULE(from, len), find, done);
+
+		builder.SetInsertPoint(find);
+		llvm::Value* is_found = builder.CreateCall(find_next_function->getFunctionType(), find_next_function, std::vector<llvm::Value*> { buf, len, from, start, end });
+		builder.CreateCondBr(is_found, found, done);
+
+		builder.SetInsertPoint(found);
+		llvm::Value* match_start = builder.CreateLoad(type_provider.getInt64(), start);
+		llvm::Value* match_end = builder.CreateLoad(type_provider.getInt64(), end);
+		if (print_matches) {
+			llvm::Function* printf_function = getPrintfFunction(context, module);
+			llvm::BasicBlock* print_named = llvm::BasicBlock::Create(context, "print_named", find_all);
+			llvm::BasicBlock* print_unnamed = llvm::BasicBlock::Create(context, "print_unnamed", find_all);
+			builder.CreateCondBr(builder.CreateIsNotNull(name), print_named, print_unnamed);
+
+			builder.SetInsertPoint(print_named);
+			builder.CreateCall(printf_function->getFunctionType(), printf_function, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("%s:%lld %lld\n"), name, match_start, match_end });
+			builder.CreateBr(next);
+
+			builder.SetInsertPoint(print_unnamed);
+			builder.CreateCall(printf_function->getFunctionType(), printf_function, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("%lld %lld\n"), match_start, match_end });
+			builder.CreateBr(next);
+		} else {
+			builder.CreateBr(next);
+		}
+
+		// An empty match can't end the next search where it starts, or it would find the same match again
+		builder.SetInsertPoint(next);
+		llvm::Value* next_from = builder.CreateSelect(
+			builder.CreateICmpEQ(match_start, match_end),
+			builder.CreateAdd(match_end, constant_provider.getInt64(1)),
+			match_end
+		);
+		from->addIncoming(next_from, next);
+		count->addIncoming(builder.CreateAdd(count, constant_provider.getInt64(1)), next);
+		builder.CreateBr(loop);
+
+		builder.SetInsertPoint(done);
+		builder.CreateRet(count);
+
+		return find_all;
+	}
+}
+
+llvm::Function* buildFindNextFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const FindDfa& dfa, bool has_byte_shuffle) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::FunctionType* find_next_type = llvm::FunctionType::get(
+		type_provider.getBit(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getInt64(), type_provider.getInt64Ptr(), type_provider.getInt64Ptr() }, // buf, len, from, start, and end
+		false
+	);
+	llvm::Function* find_next = llvm::Function::Create(find_next_type, llvm::Function::PrivateLinkage, "rx_find_next", &module);
+	llvm::Value* buf = find_next->args().begin();
+	llvm::Value* input_len = (find_next->args().begin() + 1);
+	llvm::Value* from = (find_next->args().begin() + 2);
+	llvm::Value* start_out = (find_next->args().begin() + 3);
+	llvm::Value* end_out = (find_next->args().begin() + 4);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", find_next);
+	llvm::BasicBlock* found = llvm::BasicBlock::Create(context, "found", find_next);
+	llvm::BasicBlock* not_found = llvm::BasicBlock::Create(context, "not_found", find_next);
+
+	// Each group's start is kept in a register (once the allocas are promoted), along with the match found so far and the one that ended before
+	// the last newline
+	size_t max_groups = 1;
+	for (const FindDfaState& state : dfa.states) {
+		max_groups = std::max(max_groups, state.num_groups);
+	}
+	builder.SetInsertPoint(entry);
+	llvm::AllocaInst* index = builder.CreateAlloca(type_provider.getInt64(), nullptr, "index");
+	llvm::AllocaInst* group_starts = builder.CreateAlloca(type_provider.getInt64(), constant_provider.getInt32(static_cast<uint32_t>(max_groups)), "group_starts");
+	llvm::AllocaInst* match_start = builder.CreateAlloca(type_provider.getInt64(), nullptr, "match_start");
+	llvm::AllocaInst* match_end = builder.CreateAlloca(type_provider.getInt64(), nullptr, "match_end");
+	llvm::AllocaInst* newline_match_start = builder.CreateAlloca(type_provider.getInt64(), nullptr, "newline_match_start");
+	builder.CreateStore(from, index);
+
+	auto getGroupStart = [&](size_t group) {
+		return builder.CreateGEP(type_provider.getInt64(), group_starts, std::vector<llvm::Value*> { constant_provider.getInt32(static_cast<uint32_t>(group)) });
+	};
+
+	builder.SetInsertPoint(found);
+	builder.CreateStore(builder.CreateLoad(type_provider.getInt64(), match_start), start_out);
+	builder.CreateStore(builder.CreateLoad(type_provider.getInt64(), match_end), end_out);
+	builder.CreateRet(constant_provider.getBit(1));
+
+	builder.SetInsertPoint(not_found);
+	builder.CreateRet(constant_provider.getBit(0));
+
+	std::vector<llvm::BasicBlock*> state_blocks;
+	for (size_t i = 0; i < dfa.states.size(); i++) {
+		state_blocks.push_back(llvm::BasicBlock::Create(context, "state_" + std::to_string(i), find_next));
+	}
+
+	// Transitions that move the groups' starts around or note a match do that on the way to the next state, and the rest go straight there
+	auto buildTransition = [&](const FindTransition& transition, bool has_match, const std::string& name) {
+		bool has_moves = transition.matched_group != -1 || transition.group_matched_before_newline != -1;
+		for (size_t i = 0; i < transition.group_sources.size(); i++) {
+			has_moves |= transition.group_sources[i] != static_cast<int32_t>(i);
+		}
+		llvm::BasicBlock* target = transition.to != -1 ? state_blocks[transition.to] : (has_match || transition.matched_group != -1 ? found : not_found);
+		if (!has_moves) {
+			return target;
+		}
+
+		llvm::BasicBlock* moves = llvm::BasicBlock::Create(context, name, find_next);
+		builder.SetInsertPoint(moves);
+		llvm::Value* position = builder.CreateLoad(type_provider.getInt64(), index);
+		if (transition.group_matched_before_newline != -1) {
+			builder.CreateStore(builder.CreateLoad(type_provider.getInt64(), getGroupStart(transition.group_matched_before_newline)), newline_match_start);
+		}
+		// Groups only ever move to an earlier slot, so they can be moved in order
+		for (size_t i = 0; i < transition.group_sources.size(); i++) {
+			int32_t source = transition.group_sources[i];
+			if (source == -1) {
+				builder.CreateStore(position, getGroupStart(i));
+			} else if (source != static_cast<int32_t>(i)) {
+				builder.CreateStore(builder.CreateLoad(type_provider.getInt64(), getGroupStart(source)), getGroupStart(i));
+			}
+		}
+		if (transition.matched_group != -1) {
+			builder.CreateStore(builder.CreateLoad(type_provider.getInt64(), getGroupStart(transition.matched_group)), match_start);
+			builder.CreateStore(position, match_end);
+		}
+		builder.CreateBr(target);
+
+		return moves;
+	};
+
+	builder.SetInsertPoint(entry);
+	llvm::BasicBlock* input_start = buildTransition(dfa.input_start, false, "input_start");
+	llvm::BasicBlock* start = buildTransition(dfa.start, false, "start");
+	builder.SetInsertPoint(entry);
+	builder.CreateCondBr(builder.CreateICmpEQ(from, constant_provider.getInt64(0)), input_start, start);
+
+	for (size_t i = 0; i < dfa.states.size(); i++) {
+		const FindDfaState& state = dfa.states[i];
+		std::string state_name = "state_" + std::to_string(i);
+		llvm::BasicBlock* check_end = llvm::BasicBlock::Create(context, state_name + "_check_end", find_next);
+		llvm::BasicBlock* step = llvm::BasicBlock::Create(context, state_name + "_step", find_next);
+		llvm::BasicBlock* input_end = llvm::BasicBlock::Create(context, state_name + "_end", find_next);
+
+		std::vector<llvm::BasicBlock*> transition_blocks;
+		for (size_t j = 0; j < state.transitions.size(); j++) {
+			transition_blocks.push_back(buildTransition(state.transitions[j], state.has_match, state_name + "_transition_" + std::to_string(j)));
+		}
+
+		// Like a DFA state that leads back to itself on most bytes, this skips ahead to the next byte that doesn't
+		builder.SetInsertPoint(state_blocks[i]);
+		auto skippable = std::find_if(state.transitions.begin(), state.transitions.end(), [&](const FindTransition& transition) {
+			return isSkippable(transition, static_cast<int32_t>(i));
+		});
+		llvm::Function* find_exit = nullptr;
+		if (skippable != state.transitions.end()) {
+			ByteSet exit_bytes;
+			for (int byte = 0; byte < 256; byte++) {
+				exit_bytes[byte] = state.byte_transitions[byte] != static_cast<uint32_t>(skippable - state.transitions.begin());
+			}
+			find_exit = exit_bytes.none() ? nullptr : buildFindExitFunction(context, builder, module, exit_bytes, has_byte_shuffle);
+		}
+
+		if (find_exit) {
+			llvm::AllocaInst* search_credit;
+			{
+				llvm::IRBuilderBase::InsertPointGuard insert_point_guard(builder);
+				builder.SetInsertPoint(entry, entry->begin());
+				search_credit = builder.CreateAlloca(type_provider.getInt32(), nullptr, state_name + "_search_credit");
+				builder.CreateStore(constant_provider.getInt32(max_search_credit), search_credit);
+			}
+
+			llvm::BasicBlock* search = llvm::BasicBlock::Create(context, state_name + "_search", find_next);
+			llvm::Value* input_index = builder.CreateLoad(type_provider.getInt64(), index);
+			llvm::Value* credit = builder.CreateLoad(type_provider.getInt32(), search_credit);
+			builder.CreateCondBr(builder.CreateICmpSGT(credit, constant_provider.getInt32(0)), search, check_end);
+
+			// The groups that the skipped bytes start would have started after the last of them
+			builder.SetInsertPoint(search);
+			llvm::Value* exit_index = builder.CreateCall(find_exit->getFunctionType(), find_exit, std::vector<llvm::Value*> { buf, input_index, input_len });
+			builder.CreateStore(buildNextSearchCredit(context, builder, credit, input_index, exit_index), search_credit);
+			builder.CreateStore(exit_index, index);
+			llvm::Value* is_skipped = builder.CreateICmpNE(exit_index, input_index);
+			for (size_t j = 0; j < skippable->group_sources.size(); j++) {
+				if (skippable->group_sources[j] == -1) {
+					llvm::Value* group_start = getGroupStart(j);
+					builder.CreateStore(builder.CreateSelect(is_skipped, exit_index, builder.CreateLoad(type_provider.getInt64(), group_start)), group_start);
+				}
+			}
+		}
+		builder.CreateBr(check_end);
+
+		builder.SetInsertPoint(check_end);
+		llvm::Value* input_index = builder.CreateLoad(type_provider.getInt64(), index);
+		builder.CreateCondBr(builder.CreateICmpULT(input_index, input_len), step, input_end);
+
+		builder.SetInsertPoint(step);
+		llvm::Value* input = builder.CreateLoad(type_provider.getByte(), builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { input_index }));
+		builder.CreateStore(builder.CreateAdd(input_index, constant_provider.getInt64(1)), index);
+		std::array<int32_t, 256> targets;
+		std::copy(state.byte_transitions.begin(), state.byte_transitions.end(), targets.begin());
+		buildByteSwitch(context, builder, module, input, targets, transition_blocks, "rx_find_" + state_name + "_table");
+
+		// At the end of the input, a group that matches there (e.g. with $) or one that matched before a final newline beats what was found so far
+		builder.SetInsertPoint(input_end);
+		if (state.group_matched_at_end != -1) {
+			builder.CreateStore(builder.CreateLoad(type_provider.getInt64(), getGroupStart(state.group_matched_at_end)), match_start);
+			builder.CreateStore(input_len, match_end);
+			builder.CreateBr(found);
+		} else if (state.is_matched_before_newline) {
+			builder.CreateStore(builder.CreateLoad(type_provider.getInt64(), newline_match_start), match_start);
+			builder.CreateStore(builder.CreateSub(input_len, constant_provider.getInt64(1)), match_end);
+			builder.CreateBr(found);
+		} else {
+			builder.CreateBr(state.has_match ? found : not_found);
+		}
+	}
+
+	return find_next;
+}
+
+llvm::Function* buildFindFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* find_next_function, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	// Lengths and offsets are size_t so that this can be called from C, assuming a 64-bit target
+	llvm::FunctionType* find_type = llvm::FunctionType::get(
+		type_provider.getInt32(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getInt64(), type_provider.getInt64Ptr(), type_provider.getInt64Ptr() }, // buf, len, from, start, and end
+		false
+	);
+	llvm::Function* find_function = llvm::Function::Create(find_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, find_function_suffix), &module);
+	llvm::Value* buf = find_function->args().begin();
+	llvm::Value* input_len = (find_function->args().begin() + 1);
+	llvm::Value* from = (find_function->args().begin() + 2);
+	llvm::Value* start_out = (find_function->args().begin() + 3);
+	llvm::Value* end_out = (find_function->args().begin() + 4);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", find_function);
+	llvm::BasicBlock* find = llvm::BasicBlock::Create(context, "find", find_function);
+	llvm::BasicBlock* not_found = llvm::BasicBlock::Create(context, "not_found", find_function);
+
+	builder.SetInsertPoint(entry);
+	builder.CreateCondBr(builder.CreateICmpUGT(from, input_len), not_found, find);
+
+	// The offsets are only written when there's a match, so they can go straight to the caller's
+	builder.SetInsertPoint(find);
+	llvm::Value* is_found = builder.CreateCall(
+		find_next_function->getFunctionType(),
+		find_next_function,
+		std::vector<llvm::Value*> { buf, input_len, from, start_out, end_out }
+	);
+	builder.CreateRet(builder.CreateZExt(is_found, type_provider.getInt32()));
+
+	builder.SetInsertPoint(not_found);
+	builder.CreateRet(constant_provider.getInt32(0));
+
+	return find_function;
+}
+
+llvm::Function* buildCountFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* find_next_function, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+
+	llvm::Function* count_matches = buildFindAllFunction(context, builder, module, find_next_function, false);
+
+	llvm::FunctionType* count_type = llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64() }, // buf and len
+		false
+	);
+	llvm::Function* count_function = llvm::Function::Create(count_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, count_function_suffix), &module);
+	llvm::Value* buf = count_function->args().begin();
+	llvm::Value* input_len = (count_function->args().begin() + 1);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", count_function);
+
+	builder.SetInsertPoint(entry);
+	llvm::Value* result = builder.CreateCall(
+		count_matches->getFunctionType(),
+		count_matches,
+		std::vector<llvm::Value*> { buf, input_len, llvm::ConstantPointerNull::get(type_provider.getBytePtr()) }
+	);
+	builder.CreateRet(result);
+
+	return count_function;
+}
+
+llvm::Function* buildFindFdFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* find_next_function, const FindModeOptions& options, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::Function* find_all = buildFindAllFunction(context, builder, module, find_next_function, !options.count_only);
+
+	llvm::FunctionType* find_fd_type = llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> { type_provider.getInt32(), type_provider.getBytePtr() }, // fd and name
+		false
+	);
+	llvm::Function* find_fd = llvm::Function::Create(find_fd_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, find_fd_function_suffix), &module);
+	llvm::Value* fd = find_fd->args().begin();
+	llvm::Value* name = (find_fd->args().begin() + 1);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", find_fd);
+	llvm::BasicBlock* read_failed = llvm::BasicBlock::Create(context, "read_failed", find_fd);
+	llvm::BasicBlock* finish = llvm::BasicBlock::Create(context, "finish", find_fd);
+
+	// Matches can be anywhere and any length, so unlike matching and grepping the whole input has to be in memory at once
+	llvm::BasicBlock* read;
+	llvm::Value* read_buf;
+	llvm::Value* read_size;
+	llvm::BasicBlock* read_all = buildReadAll(context, builder, module, find_fd, fd, read_failed, read, read_buf, read_size);
+	llvm::Value* read_count = builder.CreateCall(find_all->getFunctionType(), find_all, std::vector<llvm::Value*> { read_buf, read_size, name });
+	buildFree(context, builder, module, read_buf);
+	llvm::BasicBlock* read_done = builder.GetInsertBlock();
+	builder.CreateBr(finish);
+
+	llvm::BasicBlock* mapped;
+	llvm::Value* mapping;
+	llvm::Value* mapping_size;
+	llvm::Value* mapped_buf;
+	llvm::Value* mapped_len;
+	llvm::BasicBlock* map_fd = buildMapFd(context, builder, module, find_fd, fd, read_all, mapped, mapping, mapping_size, mapped_buf, mapped_len);
+	llvm::Value* mapped_count = builder.CreateCall(find_all->getFunctionType(), find_all, std::vector<llvm::Value*> { mapped_buf, mapped_len, name });
+	buildUnmap(context, builder, module, mapping, mapping_size);
+	llvm::BasicBlock* mapped_done = builder.GetInsertBlock();
+	builder.CreateBr(finish);
+
+	builder.SetInsertPoint(entry);
+	builder.CreateBr(map_fd);
+
+	builder.SetInsertPoint(read_failed);
+	builder.CreateRet(constant_provider.getInt64(-1, true));
+
+	builder.SetInsertPoint(finish);
+	llvm::PHINode* match_count = builder.CreatePHI(type_provider.getInt64(), 2);
+	match_count->addIncoming(read_count, read_done);
+	match_count->addIncoming(mapped_count, mapped_done);
+	if (options.count_only) {
+		llvm::Function* printf_function = getPrintfFunction(context, module);
+		llvm::BasicBlock* print_named = llvm::BasicBlock::Create(context, "print_named", find_fd);
+		llvm::BasicBlock* print_unnamed = llvm::BasicBlock::Create(context, "print_unnamed", find_fd);
+		llvm::BasicBlock* printed = llvm::BasicBlock::Create(context, "printed", find_fd);
+		builder.CreateCondBr(builder.CreateIsNotNull(name), print_named, print_unnamed);
+
+		builder.SetInsertPoint(print_named);
+		builder.CreateCall(printf_function->getFunctionType(), printf_function, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("%s:%lld\n"), name, match_count });
+		builder.CreateBr(printed);
+
+		builder.SetInsertPoint(print_unnamed);
+		builder.CreateCall(printf_function->getFunctionType(), printf_function, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("%lld\n"), match_count });
+		builder.CreateBr(printed);
+
+		builder.SetInsertPoint(printed);
+	}
+	builder.CreateRet(match_count);
+
+	return find_fd;
+}
+
+llvm::Function* buildFindFileFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* find_fd_function, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::FunctionType* find_file_type = llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getBytePtr() }, // path and name
+		false
+	);
+	llvm::Function* find_file_function = llvm::Function::Create(find_file_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, find_file_function_suffix), &module);
+	llvm::Value* path = find_file_function->args().begin();
+	llvm::Value* name = (find_file_function->args().begin() + 1);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", find_file_function);
+	llvm::BasicBlock* opened = llvm::BasicBlock::Create(context, "opened", find_file_function);
+	llvm::BasicBlock* open_failed = llvm::BasicBlock::Create(context, "open_failed", find_file_function);
+
+	builder.SetInsertPoint(entry);
+	llvm::Value* fd = buildOpen(context, builder, module, path);
+	builder.CreateCondBr(builder.CreateICmpSLT(fd, constant_provider.getInt32(0)), open_failed, opened);
+
+	builder.SetInsertPoint(open_failed);
+	builder.CreateRet(constant_provider.getInt64(-1, true));
+
+	builder.SetInsertPoint(opened);
+	llvm::Value* result = builder.CreateCall(find_fd_function->getFunctionType(), find_fd_function, std::vector<llvm::Value*> { fd, name });
+	buildClose(context, builder, module, fd);
+	builder.CreateRet(result);
+
+	return find_file_function;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include "Dfa.h"
+
+// Options for find mode, where the generated program prints where each match is rather than only whether there is one
+struct FindModeOptions {
+	// Print how many matches there are instead of where they are
+	bool count_only;
+};
+
+// Matches are leftmost-longest: the one that starts first, and the longest of those that start there. Finding all of them starts each search where
+// the last match ended (or one byte further on, after an empty match), so they don't overlap, and ^ only matches at the start of the whole input.
+
+// Builds the private function that the others are built on, which has the signature i1 (i8* buf, i64 len, i64 from, i64* start, i64* end). It runs
+// dfa over buf from index from, and if there's a match there or later, sets start and end to its offsets and returns 1. Otherwise it returns 0.
+// has_byte_shuffle enables searching for classes of bytes with PSHUFB in states that rarely change.
+llvm::Function* buildFindNextFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const FindDfa& dfa, bool has_byte_shuffle);
+
+// Builds the function named by find_function_suffix
+llvm::Function* buildFindFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* find_next_function, const std::string& symbol_prefix);
+// Builds the function named by count_function_suffix
+llvm::Function* buildCountFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* find_next_function, const std::string& symbol_prefix);
+
+// Builds the function named by find_fd_function_suffix, which maps fd (or reads all of it, if it can't be mapped) and prints its matches
+llvm::Function* buildFindFdFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* find_next_function, const FindModeOptions& options, const std::string& symbol_prefix);
+// Builds the function named by find_file_function_suffix, which opens the file at path and passes it to find_fd_function
+llvm::Function* buildFindFileFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* find_fd_function, const std::string& symbol_prefix);
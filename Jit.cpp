@@ -0,0 +1,116 @@
+#include <string>
+#include <memory>
+#include <utility>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/Error.h>
+#include <llvm/MC/SubtargetFeature.h>
+#include "Jit.h"
+#include "Optimizer.h"
+#include "Emitter.h"
+
+Jit::Jit(std::unique_ptr<llvm::orc::LLJIT> jit, std::unique_ptr<llvm::TargetMachine> target_machine, unsigned opt_level)
+: jit{std::move(jit)}, target_machine{std::move(target_machine)}, opt_level{opt_level}
+{ }
+
+std::unique_ptr<Jit> Jit::create(const TargetSelection& selection, std::string& error_out) {
+	llvm::InitializeNativeTarget();
+	llvm::InitializeNativeTargetAsmPrinter();
+
+	if (!selection.arch.empty()) {
+		error_out = "The JIT can only target the host architecture";
+		return nullptr;
+	}
+
+	auto target_machine_builder = llvm::orc::JITTargetMachineBuilder::detectHost();
+	if (!target_machine_builder) {
+		error_out = llvm::toString(target_machine_builder.takeError());
+		return nullptr;
+	}
+	target_machine_builder->setCodeGenOptLevel(getCodeGenOptLevel(selection.opt_level));
+	// The host's features are only known to be right for the host's CPU
+	if (!selection.cpu.empty() && selection.cpu != native_cpu_name) {
+		target_machine_builder->setCPU(selection.cpu);
+		target_machine_builder->getFeatures() = llvm::SubtargetFeatures();
+	}
+
+	auto target_machine = target_machine_builder->createTargetMachine();
+	if (!target_machine) {
+		error_out = llvm::toString(target_machine.takeError());
+		return nullptr;
+	}
+
+	auto jit = llvm::orc::LLJITBuilder()
+		.setJITTargetMachineBuilder(std::move(*target_machine_builder))
+		.create();
+	if (!jit) {
+		error_out = llvm::toString(jit.takeError());
+		return nullptr;
+	}
+
+	// The generated code may call into libc (e.g. puts and exit when panicking)
+	auto process_symbols = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess((*jit)->getDataLayout().getGlobalPrefix());
+	if (!process_symbols) {
+		error_out = llvm::toString(process_symbols.takeError());
+		return nullptr;
+	}
+	(*jit)->getMainJITDylib().addGenerator(std::move(*process_symbols));
+
+	llvm::TargetMachine* optimization_target = target_machine->get();
+	unsigned opt_level = selection.opt_level;
+	(*jit)->getIRTransformLayer().setTransform(
+		[optimization_target, opt_level](llvm::orc::ThreadSafeModule module, const llvm::orc::MaterializationResponsibility&) -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+			module.withModuleDo([optimization_target, opt_level](llvm::Module& m) { optimizeModule(m, optimization_target, opt_level); });
+			return module;
+		}
+	);
+
+	return std::unique_ptr<Jit>(new Jit(std::move(*jit), std::move(*target_machine), opt_level));
+}
+
+bool Jit::addModule(std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> context, std::string& error_out) {
+	module->setDataLayout(jit->getDataLayout());
+	module->setTargetTriple(jit->getTargetTriple().str());
+
+	llvm::Error error = jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context)));
+	if (error) {
+		error_out = llvm::toString(std::move(error));
+		return false;
+	}
+
+	return true;
+}
+
+bool Jit::emitObject(llvm::Module& module, llvm::SmallVectorImpl<char>& object_out, std::string& error_out) {
+	// The JIT compiles modules with target machines from the same builder as this one, so the object is the same as it would have made
+	return emitObjectBuffer(module, *target_machine, opt_level, object_out, error_out);
+}
+
+bool Jit::addObject(std::unique_ptr<llvm::MemoryBuffer> object, std::string& error_out) {
+	llvm::Error error = jit->addObjectFile(std::move(object));
+	if (error) {
+		error_out = llvm::toString(std::move(error));
+		return false;
+	}
+
+	return true;
+}
+
+const llvm::TargetMachine& Jit::getTargetMachine() const {
+	return *target_machine;
+}
+
+uint64_t Jit::lookup(const char* name, std::string& error_out) {
+	auto symbol = jit->lookup(name);
+	if (!symbol) {
+		error_out = llvm::toString(symbol.takeError());
+		return 0;
+	}
+
+	return symbol->getAddress();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Target/TargetMachine.h>
+#include "Target.h"
+
+// Signatures of the functions named in Matcher.h
+using MatchFunction = int32_t (*)(const char* buf, size_t len);
+using MatchFdFunction = int32_t (*)(int32_t fd);
+using MatchFileFunction = int32_t (*)(const char* path);
+using GrepFdFunction = int64_t (*)(int32_t fd, const char* name);
+using GrepFileFunction = int64_t (*)(const char* path, const char* name);
+using GrepLinesFunction = int64_t (*)(const char* buf, size_t len, const char* name, int64_t* state);
+using CountLinesFunction = int64_t (*)(const char* buf, size_t len, int64_t* state);
+using MatchSetFdFunction = int32_t (*)(int32_t fd, uint64_t* matched);
+using MatchSetFileFunction = int32_t (*)(const char* path, uint64_t* matched);
+
+// Compiles modules in-process with ORC, so a regex can be matched without writing out IR and invoking clang
+class Jit {
+public:
+	// Returns nullptr and sets error_out if the host can't be targeted. The selected CPU defaults to the host's, since the code only ever runs here.
+	static std::unique_ptr<Jit> create(const TargetSelection& selection, std::string& error_out);
+
+	// Optimizes the module for the selected CPU and adds it to the JIT, the module must have been built in context
+	bool addModule(std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> context, std::string& error_out);
+	// Optimizes and compiles the module for the selected CPU like addModule would, but into object_out, which can be added with addObject (e.g.
+	// after caching it, see ObjectCache)
+	bool emitObject(llvm::Module& module, llvm::SmallVectorImpl<char>& object_out, std::string& error_out);
+	// Adds an object compiled by emitObject, possibly by an earlier process for the same CPU
+	bool addObject(std::unique_ptr<llvm::MemoryBuffer> object, std::string& error_out);
+
+	// Returns nullptr and sets error_out if the function can't be found
+	template <typename FunctionType>
+	FunctionType lookupFunction(const char* name, std::string& error_out) {
+		return reinterpret_cast<FunctionType>(lookup(name, error_out));
+	}
+
+	// The machine the code is compiled for
+	const llvm::TargetMachine& getTargetMachine() const;
+
+private:
+	Jit(std::unique_ptr<llvm::orc::LLJIT> jit, std::unique_ptr<llvm::TargetMachine> target_machine, unsigned opt_level);
+	uint64_t lookup(const char* name, std::string& error_out);
+
+	std::unique_ptr<llvm::orc::LLJIT> jit;
+	std::unique_ptr<llvm::TargetMachine> target_machine;
+	unsigned opt_level;
+};
@@ -0,0 +1,472 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Constants.h>
+#include "Lines.h"
+#include "Matcher.h"
+#include "Runtime.h"
+#include "VectorSearch.h"
+#include "TypeProvider.h"
+#include "ConstantProvider.h"
+
+// The generated grep functions share their progress through an i64[2], holding the number of the last line seen and how many lines have matched
+const uint32_t state_line_number = 0;
+const uint32_t state_match_count = 1;
+
+llvm::Value* buildIncrementState(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Value* state, uint32_t index) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::Value* address = builder.CreateGEP(type_provider.getInt64(), state, std::vector<llvm::Value*> { constant_provider.getInt32(index) });
+	llvm::Value* value = builder.CreateAdd(builder.CreateLoad(type_provider.getInt64(), address), constant_provider.getInt64(1));
+	builder.CreateStore(value, address);
+	return value;
+}
+
+llvm::Function* buildGrepLineFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* scan_function, const LineModeOptions& options) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::FunctionType* grep_line_type = llvm::FunctionType::get(
+		type_provider.getVoid(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getBytePtr(), type_provider.getInt64()->getPointerTo() }, // line, len, name, and state
+		false
+	);
+	llvm::Function* grep_line = llvm::Function::Create(grep_line_type, llvm::Function::PrivateLinkage, "rx_grep_line", &module);
+	llvm::Value* line = grep_line->args().begin();
+	llvm::Value* len = (grep_line->args().begin() + 1);
+	llvm::Value* name = (grep_line->args().begin() + 2);
+	llvm::Value* state = (grep_line->args().begin() + 3);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", grep_line);
+	llvm::BasicBlock* matched = llvm::BasicBlock::Create(context, "matched", grep_line);
+	llvm::BasicBlock* done = llvm::BasicBlock::Create(context, "done", grep_line);
+
+	// The line is passed as its own buffer, so ^ and $ anchor to it rather than the whole input
+	builder.SetInsertPoint(entry);
+	llvm::Value* line_number = buildIncrementState(context, builder, state, state_line_number);
+	llvm::Value* result = builder.CreateCall(
+		scan_function->getFunctionType(),
+		scan_function,
+		std::vector<llvm::Value*> { line, len, constant_provider.getInt64(scan_initial_state), constant_provider.getBit(1) }
+	);
+	builder.CreateCondBr(builder.CreateICmpEQ(result, constant_provider.getInt64(scan_matched, true)), matched, done);
+
+	builder.SetInsertPoint(matched);
+	buildIncrementState(context, builder, state, state_match_count);
+	if (options.count_only) {
+		builder.CreateBr(done);
+	} else {
+		llvm::Function* printf_function = getPrintfFunction(context, module);
+		llvm::BasicBlock* print_name = llvm::BasicBlock::Create(context, "print_name", grep_line);
+		llvm::BasicBlock* print_line = llvm::BasicBlock::Create(context, "print_line", grep_line);
+		builder.CreateCondBr(builder.CreateIsNotNull(name), print_name, print_line);
+
+		builder.SetInsertPoint(print_name);
+		builder.CreateCall(printf_function->getFunctionType(), printf_function, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("%s:"), name });
+		builder.CreateBr(print_line);
+
+		// The prefix is printed with printf, but the line itself is written as it is, since it can have NUL bytes in it like grep's output can
+		builder.SetInsertPoint(print_line);
+		if (options.print_line_numbers) {
+			builder.CreateCall(printf_function->getFunctionType(), printf_function, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("%lld:"), line_number });
+		}
+		buildWriteStdout(context, builder, module, line, len);
+		buildWriteStdout(context, builder, module, builder.CreateGlobalStringPtr("\n"), constant_provider.getInt64(1));
+		builder.CreateBr(done);
+	}
+
+	builder.SetInsertPoint(done);
+	builder.CreateRetVoid();
+
+	return grep_line;
+}
+
+llvm::Function* buildGrepBlockFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* scan_function, const LineModeOptions& options) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::Function* grep_line = buildGrepLineFunction(context, builder, module, scan_function, options);
+	llvm::Function* find_byte = buildFindByteFunction(context, builder, module);
+
+	llvm::FunctionType* grep_block_type = llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getBit(), type_provider.getBytePtr(), type_provider.getInt64()->getPointerTo() }, // buf, len, is_final, name, and state
+		false
+	);
+	llvm::Function* grep_block = llvm::Function::Create(grep_block_type, llvm::Function::PrivateLinkage, "rx_grep_block", &module);
+	llvm::Value* buf = grep_block->args().begin();
+	llvm::Value* len = (grep_block->args().begin() + 1);
+	llvm::Value* is_final = (grep_block->args().begin() + 2);
+	llvm::Value* name = (grep_block->args().begin() + 3);
+	llvm::Value* state = (grep_block->args().begin() + 4);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", grep_block);
+	llvm::BasicBlock* line_loop = llvm::BasicBlock::Create(context, "line_loop", grep_block);
+	llvm::BasicBlock* complete_line = llvm::BasicBlock::Create(context, "complete_line", grep_block);
+	llvm::BasicBlock* no_newline = llvm::BasicBlock::Create(context, "no_newline", grep_block);
+	llvm::BasicBlock* last_line = llvm::BasicBlock::Create(context, "last_line", grep_block);
+	llvm::BasicBlock* partial_line = llvm::BasicBlock::Create(context, "partial_line", grep_block);
+
+	builder.SetInsertPoint(entry);
+	builder.CreateBr(line_loop);
+
+	builder.SetInsertPoint(line_loop);
+	llvm::PHINode* line_start = builder.CreatePHI(type_provider.getInt64(), 2);
+	line_start->addIncoming(constant_provider.getInt64(0), entry);
+	llvm::Value* newline_index = builder.CreateCall(
+		find_byte->getFunctionType(),
+		find_byte,
+		std::vector<llvm::Value*> { buf, line_start, len, constant_provider.getByte('\n') }
+	);
+	llvm::Value* line = builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { line_start });
+	builder.CreateCondBr(builder.CreateICmpSLT(newline_index, len), complete_line, no_newline);
+
+	builder.SetInsertPoint(complete_line);
+	builder.CreateCall(
+		grep_line->getFunctionType(),
+		grep_line,
+		std::vector<llvm::Value*> { line, builder.CreateSub(newline_index, line_start), name, state }
+	);
+	line_start->addIncoming(builder.CreateAdd(newline_index, constant_provider.getInt64(1)), complete_line);
+	builder.CreateBr(line_loop);
+
+	builder.SetInsertPoint(no_newline);
+	builder.CreateCondBr(builder.CreateAnd(is_final, builder.CreateICmpSLT(line_start, len)), last_line, partial_line);
+
+	builder.SetInsertPoint(last_line);
+	builder.CreateCall(
+		grep_line->getFunctionType(),
+		grep_line,
+		std::vector<llvm::Value*> { line, builder.CreateSub(len, line_start), name, state }
+	);
+	builder.CreateRet(len);
+
+	builder.SetInsertPoint(partial_line);
+	builder.CreateRet(line_start);
+
+	return grep_block;
+}
+
+llvm::Function* buildGrepFdFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* grep_block, const LineModeOptions& options, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::Function* read_function = getReadFunction(context, module);
+	llvm::Function* malloc_function = getExternalFunction(module, "malloc", llvm::FunctionType::get(
+		type_provider.getBytePtr(),
+		std::vector<llvm::Type*> { type_provider.getInt64() }, // size
+		false
+	));
+	llvm::Function* realloc_function = getExternalFunction(module, "realloc", llvm::FunctionType::get(
+		type_provider.getBytePtr(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64() }, // ptr and size
+		false
+	));
+	llvm::Function* free_function = getExternalFunction(module, "free", llvm::FunctionType::get(
+		type_provider.getVoid(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr() }, // ptr
+		false
+	));
+
+	llvm::FunctionType* grep_fd_type = llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> { type_provider.getInt32(), type_provider.getBytePtr() }, // fd and name
+		false
+	);
+	llvm::Function* grep_fd = llvm::Function::Create(grep_fd_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, grep_fd_function_suffix), &module);
+	llvm::Value* fd = grep_fd->args().begin();
+	llvm::Value* name = (grep_fd->args().begin() + 1);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", grep_fd);
+	llvm::BasicBlock* stream_entry = llvm::BasicBlock::Create(context, "stream_entry", grep_fd);
+	llvm::BasicBlock* read_loop = llvm::BasicBlock::Create(context, "read_loop", grep_fd);
+	llvm::BasicBlock* read_succeeded = llvm::BasicBlock::Create(context, "read_succeeded", grep_fd);
+	llvm::BasicBlock* read_more = llvm::BasicBlock::Create(context, "read_more", grep_fd);
+	llvm::BasicBlock* grow_buffer = llvm::BasicBlock::Create(context, "grow_buffer", grep_fd);
+	llvm::BasicBlock* at_eof = llvm::BasicBlock::Create(context, "at_eof", grep_fd);
+	llvm::BasicBlock* read_failed = llvm::BasicBlock::Create(context, "read_failed", grep_fd);
+	llvm::BasicBlock* finish = llvm::BasicBlock::Create(context, "finish", grep_fd);
+
+	builder.SetInsertPoint(entry);
+	llvm::AllocaInst* state = builder.CreateAlloca(type_provider.getInt64(), constant_provider.getInt32(2), "state");
+	builder.CreateStore(constant_provider.getInt64(0), builder.CreateGEP(type_provider.getInt64(), state, std::vector<llvm::Value*> { constant_provider.getInt32(state_line_number) }));
+	builder.CreateStore(constant_provider.getInt64(0), builder.CreateGEP(type_provider.getInt64(), state, std::vector<llvm::Value*> { constant_provider.getInt32(state_match_count) }));
+
+	llvm::BasicBlock* mapped;
+	llvm::Value* mapping;
+	llvm::Value* mapping_size;
+	llvm::Value* mapped_buf;
+	llvm::Value* mapped_len;
+	llvm::BasicBlock* map_fd = buildMapFd(context, builder, module, grep_fd, fd, stream_entry, mapped, mapping, mapping_size, mapped_buf, mapped_len);
+
+	builder.SetInsertPoint(entry);
+	builder.CreateBr(map_fd);
+
+	builder.SetInsertPoint(mapped);
+	builder.CreateCall(
+		grep_block->getFunctionType(),
+		grep_block,
+		std::vector<llvm::Value*> { mapped_buf, mapped_len, constant_provider.getBit(1), name, state }
+	);
+	buildUnmap(context, builder, module, mapping, mapping_size);
+	builder.CreateBr(finish);
+
+	// Unlike buildStreamScan a line has no maximum length, so the buffer grows until it can hold the longest line
+	builder.SetInsertPoint(stream_entry);
+	llvm::Value* initial_buf = builder.CreateCall(malloc_function->getFunctionType(), malloc_function, std::vector<llvm::Value*> { constant_provider.getInt64(stream_block_size) });
+	builder.CreateBr(read_loop);
+
+	builder.SetInsertPoint(read_loop);
+	llvm::PHINode* buf = builder.CreatePHI(type_provider.getBytePtr(), 3);
+	llvm::PHINode* capacity = builder.CreatePHI(type_provider.getInt64(), 3);
+	llvm::PHINode* fill = builder.CreatePHI(type_provider.getInt64(), 3);
+	buf->addIncoming(initial_buf, stream_entry);
+	capacity->addIncoming(constant_provider.getInt64(stream_block_size), stream_entry);
+	fill->addIncoming(constant_provider.getInt64(0), stream_entry);
+	llvm::Value* num_read = builder.CreateCall(
+		read_function->getFunctionType(),
+		read_function,
+		std::vector<llvm::Value*> {
+			fd,
+			builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { fill }),
+			builder.CreateSub(capacity, fill)
+		}
+	);
+	builder.CreateCondBr(builder.CreateICmpSLT(num_read, constant_provider.getInt64(0)), read_failed, read_succeeded);
+
+	builder.SetInsertPoint(read_succeeded);
+	builder.CreateCondBr(builder.CreateICmpEQ(num_read, constant_provider.getInt64(0)), at_eof, read_more);
+
+	builder.SetInsertPoint(read_more);
+	llvm::Value* filled = builder.CreateAdd(fill, num_read);
+	llvm::Value* consumed = builder.CreateCall(
+		grep_block->getFunctionType(),
+		grep_block,
+		std::vector<llvm::Value*> { buf, filled, constant_provider.getBit(0), name, state }
+	);
+	llvm::Value* remaining = builder.CreateSub(filled, consumed);
+	builder.CreateMemMove(
+		buf, llvm::MaybeAlign(1),
+		builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { consumed }), llvm::MaybeAlign(1),
+		remaining
+	);
+	buf->addIncoming(buf, read_more);
+	capacity->addIncoming(capacity, read_more);
+	fill->addIncoming(remaining, read_more);
+	builder.CreateCondBr(builder.CreateICmpEQ(remaining, capacity), grow_buffer, read_loop);
+
+	builder.SetInsertPoint(grow_buffer);
+	llvm::BasicBlock* buffer_grown = llvm::BasicBlock::Create(context, "buffer_grown", grep_fd);
+	builder.CreateCondBr(builder.CreateICmpSGE(capacity, constant_provider.getInt64(max_read_size)), read_failed, buffer_grown);
+
+	builder.SetInsertPoint(buffer_grown);
+	llvm::Value* grown_capacity = builder.CreateMul(capacity, constant_provider.getInt64(2));
+	llvm::Value* grown_buf = builder.CreateCall(
+		realloc_function->getFunctionType(),
+		realloc_function,
+		std::vector<llvm::Value*> { buf, grown_capacity }
+	);
+	buf->addIncoming(grown_buf, buffer_grown);
+	capacity->addIncoming(grown_capacity, buffer_grown);
+	fill->addIncoming(remaining, buffer_grown);
+	builder.CreateCondBr(builder.CreateIsNull(grown_buf), read_failed, read_loop);
+
+	builder.SetInsertPoint(at_eof);
+	builder.CreateCall(
+		grep_block->getFunctionType(),
+		grep_block,
+		std::vector<llvm::Value*> { buf, fill, constant_provider.getBit(1), name, state }
+	);
+	builder.CreateCall(free_function->getFunctionType(), free_function, std::vector<llvm::Value*> { buf });
+	builder.CreateBr(finish);
+
+	builder.SetInsertPoint(read_failed);
+	builder.CreateCall(free_function->getFunctionType(), free_function, std::vector<llvm::Value*> { buf });
+	builder.CreateRet(constant_provider.getInt64(-1, true));
+
+	builder.SetInsertPoint(finish);
+	llvm::Value* match_count = builder.CreateLoad(type_provider.getInt64(), builder.CreateGEP(type_provider.getInt64(), state, std::vector<llvm::Value*> { constant_provider.getInt32(state_match_count) }));
+	if (options.count_only) {
+		llvm::Function* printf_function = getPrintfFunction(context, module);
+		llvm::BasicBlock* print_named = llvm::BasicBlock::Create(context, "print_named", grep_fd);
+		llvm::BasicBlock* print_unnamed = llvm::BasicBlock::Create(context, "print_unnamed", grep_fd);
+		llvm::BasicBlock* printed = llvm::BasicBlock::Create(context, "printed", grep_fd);
+		builder.CreateCondBr(builder.CreateIsNotNull(name), print_named, print_unnamed);
+
+		builder.SetInsertPoint(print_named);
+		builder.CreateCall(printf_function->getFunctionType(), printf_function, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("%s:%lld\n"), name, match_count });
+		builder.CreateBr(printed);
+
+		builder.SetInsertPoint(print_unnamed);
+		builder.CreateCall(printf_function->getFunctionType(), printf_function, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("%lld\n"), match_count });
+		builder.CreateBr(printed);
+
+		builder.SetInsertPoint(printed);
+	}
+	builder.CreateRet(match_count);
+
+	return grep_fd;
+}
+
+llvm::Function* buildGrepFileFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* grep_fd_function, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::FunctionType* grep_file_type = llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getBytePtr() }, // path and name
+		false
+	);
+	llvm::Function* grep_file_function = llvm::Function::Create(grep_file_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, grep_file_function_suffix), &module);
+	llvm::Value* path = grep_file_function->args().begin();
+	llvm::Value* name = (grep_file_function->args().begin() + 1);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", grep_file_function);
+	llvm::BasicBlock* opened = llvm::BasicBlock::Create(context, "opened", grep_file_function);
+	llvm::BasicBlock* open_failed = llvm::BasicBlock::Create(context, "open_failed", grep_file_function);
+
+	builder.SetInsertPoint(entry);
+	llvm::Value* fd = buildOpen(context, builder, module, path);
+	builder.CreateCondBr(builder.CreateICmpSLT(fd, constant_provider.getInt32(0)), open_failed, opened);
+
+	builder.SetInsertPoint(open_failed);
+	builder.CreateRet(constant_provider.getInt64(-1, true));
+
+	builder.SetInsertPoint(opened);
+	llvm::Value* result = builder.CreateCall(grep_fd_function->getFunctionType(), grep_fd_function, std::vector<llvm::Value*> { fd, name });
+	buildClose(context, builder, module, fd);
+	builder.CreateRet(result);
+
+	return grep_file_function;
+}
+
+llvm::Function* buildGrepLinesFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* grep_block, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::FunctionType* grep_lines_type = llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getBytePtr(), type_provider.getInt64Ptr() }, // buf, len, name, and state
+		false
+	);
+	llvm::Function* grep_lines = llvm::Function::Create(grep_lines_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, grep_lines_function_suffix), &module);
+	llvm::Value* buf = grep_lines->args().begin();
+	llvm::Value* len = (grep_lines->args().begin() + 1);
+	llvm::Value* name = (grep_lines->args().begin() + 2);
+	llvm::Value* state = (grep_lines->args().begin() + 3);
+
+	builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", grep_lines));
+	builder.CreateCall(grep_block->getFunctionType(), grep_block, std::vector<llvm::Value*> { buf, len, constant_provider.getBit(1), name, state });
+	builder.CreateRet(builder.CreateLoad(type_provider.getInt64(), builder.CreateGEP(type_provider.getInt64(), state, std::vector<llvm::Value*> { constant_provider.getInt32(state_match_count) })));
+
+	return grep_lines;
+}
+
+llvm::Function* buildCountLinesFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* count_block, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::FunctionType* count_lines_type = llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getInt64Ptr() }, // buf, len, and state
+		false
+	);
+	llvm::Function* count_lines = llvm::Function::Create(count_lines_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, count_lines_function_suffix), &module);
+	llvm::Value* buf = count_lines->args().begin();
+	llvm::Value* len = (count_lines->args().begin() + 1);
+	llvm::Value* state = (count_lines->args().begin() + 2);
+
+	builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", count_lines));
+	builder.CreateCall(
+		count_block->getFunctionType(),
+		count_block,
+		std::vector<llvm::Value*> { buf, len, constant_provider.getBit(1), llvm::ConstantPointerNull::get(type_provider.getBytePtr()), state }
+	);
+	builder.CreateRet(builder.CreateLoad(type_provider.getInt64(), builder.CreateGEP(type_provider.getInt64(), state, std::vector<llvm::Value*> { constant_provider.getInt32(state_match_count) })));
+
+	return count_lines;
+}
+
+llvm::Function* buildGrepMain(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* grep_fd_function, llvm::Function* grep_file_function) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::Function* main_function = createMainFunction(context, module);
+	llvm::Value* argc = main_function->args().begin();
+	llvm::Value* argv = (main_function->args().begin() + 1);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", main_function);
+	llvm::BasicBlock* grep_stdin = llvm::BasicBlock::Create(context, "grep_stdin", main_function);
+	llvm::BasicBlock* stdin_failed = llvm::BasicBlock::Create(context, "stdin_failed", main_function);
+	llvm::BasicBlock* file_loop = llvm::BasicBlock::Create(context, "file_loop", main_function);
+	llvm::BasicBlock* file_body = llvm::BasicBlock::Create(context, "file_body", main_function);
+	llvm::BasicBlock* file_read = llvm::BasicBlock::Create(context, "file_read", main_function);
+	llvm::BasicBlock* file_failed = llvm::BasicBlock::Create(context, "file_failed", main_function);
+	llvm::BasicBlock* files_done = llvm::BasicBlock::Create(context, "files_done", main_function);
+	llvm::BasicBlock* matched = llvm::BasicBlock::Create(context, "matched", main_function);
+	llvm::BasicBlock* not_matched = llvm::BasicBlock::Create(context, "not_matched", main_function);
+
+	builder.SetInsertPoint(entry);
+	builder.CreateCondBr(builder.CreateICmpSLT(argc, constant_provider.getInt32(2)), grep_stdin, file_loop);
+
+	builder.SetInsertPoint(grep_stdin);
+	llvm::Value* stdin_count = builder.CreateCall(
+		grep_fd_function->getFunctionType(),
+		grep_fd_function,
+		std::vector<llvm::Value*> { constant_provider.getInt32(0), llvm::ConstantPointerNull::get(type_provider.getBytePtr()) }
+	);
+	llvm::BasicBlock* stdin_read = llvm::BasicBlock::Create(context, "stdin_read", main_function);
+	builder.CreateCondBr(builder.CreateICmpSLT(stdin_count, constant_provider.getInt64(0)), stdin_failed, stdin_read);
+
+	builder.SetInsertPoint(stdin_read);
+	builder.CreateCondBr(builder.CreateICmpSGT(stdin_count, constant_provider.getInt64(0)), matched, not_matched);
+
+	// Like grep, output is prefixed with the path if there's more than one file
+	builder.SetInsertPoint(file_loop);
+	llvm::PHINode* arg_index = builder.CreatePHI(type_provider.getInt32(), 2);
+	llvm::PHINode* any_matched = builder.CreatePHI(type_provider.getBit(), 2);
+	arg_index->addIncoming(constant_provider.getInt32(1), entry);
+	any_matched->addIncoming(constant_provider.getBit(0), entry);
+	builder.CreateCondBr(builder.CreateICmpSLT(arg_index, argc), file_body, files_done);
+
+	builder.SetInsertPoint(file_body);
+	llvm::Value* path = builder.CreateLoad(type_provider.getBytePtr(), builder.CreateGEP(type_provider.getBytePtr(), argv, std::vector<llvm::Value*> { arg_index }));
+	llvm::Value* name = builder.CreateSelect(
+		builder.CreateICmpSGT(argc, constant_provider.getInt32(2)),
+		path,
+		llvm::ConstantPointerNull::get(type_provider.getBytePtr())
+	);
+	llvm::Value* file_count = builder.CreateCall(grep_file_function->getFunctionType(), grep_file_function, std::vector<llvm::Value*> { path, name });
+	builder.CreateCondBr(builder.CreateICmpSLT(file_count, constant_provider.getInt64(0)), file_failed, file_read);
+
+	builder.SetInsertPoint(file_read);
+	arg_index->addIncoming(builder.CreateAdd(arg_index, constant_provider.getInt32(1)), file_read);
+	any_matched->addIncoming(builder.CreateOr(any_matched, builder.CreateICmpSGT(file_count, constant_provider.getInt64(0))), file_read);
+	builder.CreateBr(file_loop);
+
+	builder.SetInsertPoint(files_done);
+	builder.CreateCondBr(any_matched, matched, not_matched);
+
+	llvm::Function* panic = buildPanic(context, builder, module);
+	builder.SetInsertPoint(stdin_failed);
+	builder.CreateCall(panic->getFunctionType(), panic, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("Error: Could not read input.") });
+	builder.CreateUnreachable();
+
+	builder.SetInsertPoint(file_failed);
+	builder.CreateCall(panic->getFunctionType(), panic, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("Error: Could not read input file.") });
+	builder.CreateUnreachable();
+
+	builder.SetInsertPoint(matched);
+	builder.CreateRet(constant_provider.getInt32(0));
+
+	builder.SetInsertPoint(not_matched);
+	builder.CreateRet(constant_provider.getInt32(1));
+
+	return main_function;
+}
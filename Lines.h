@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+
+// Options for line mode, where each line of the input is matched separately (with ^ and $ anchoring to the start and end of the line)
+struct LineModeOptions {
+	// Print how many lines matched instead of the lines themselves
+	bool count_only;
+	// Prefix each matching line with its line number
+	bool print_line_numbers;
+};
+
+// Builds a private function with the signature i64 (i8* buf, i64 len, i1 is_final, i8* name, i64* state), which matches each complete line of buf
+// with scan_function (and the trailing partial line if is_final is set), printing the matching lines or only counting them as options say. state is
+// an i64[2] holding the number of the last line seen and how many lines have matched. Returns how many bytes were consumed.
+llvm::Function* buildGrepBlockFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* scan_function, const LineModeOptions& options);
+
+// Builds the function named by grep_fd_function_suffix, which greps fd with grep_block (built with the same options)
+llvm::Function* buildGrepFdFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* grep_block, const LineModeOptions& options, const std::string& symbol_prefix);
+
+// Builds the function named by grep_file_function_suffix, which opens the file at path and passes it to grep_fd_function
+llvm::Function* buildGrepFileFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* grep_fd_function, const std::string& symbol_prefix);
+
+// Builds the function named by grep_lines_function_suffix, which greps buf with grep_block
+llvm::Function* buildGrepLinesFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* grep_block, const std::string& symbol_prefix);
+// Builds the function named by count_lines_function_suffix, which greps buf with count_block (built with count_only set)
+llvm::Function* buildCountLinesFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* count_block, const std::string& symbol_prefix);
+
+// Builds a main function that greps each file given as an argument, or stdin if there are none, and returns 0 if any line matched or 1 otherwise
+llvm::Function* buildGrepMain(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* grep_fd_function, llvm::Function* grep_file_function);
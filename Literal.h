@@ -1,25 +1,20 @@
 #pragma once
 
-#include <string>
-#include <llvm/IR/Function.h>
-#include <llvm/IR/LLVMContext.h>
-#include <llvm/IR/IRBuilder.h>
-#include <llvm/IR/Module.h>
-#include <llvm/IR/Type.h>
-#include <llvm/IR/DerivedTypes.h>
 #include "Atom.h"
 
 class Literal : public Atom {
 public:
-	Literal(char to_match, llvm::LLVMContext* context, llvm::Module* module, llvm::IRBuilder<>* builder);
-	llvm::Function* codegen() override;
-	llvm::FunctionType* get_generated_function_type() const;
-	std::string get_generated_function_name() const;
+	// A case-insensitive literal that's a letter matches it in either case
+	Literal(char to_match, bool is_case_insensitive);
+	void add_to_nfa(Nfa& nfa, int32_t from, int32_t to) const override;
+	AtomSummary get_summary() const override;
+	bool get_single_byte(char& byte_out) const override;
+	bool get_positions(std::vector<ByteSet>& positions_out) const override;
 
 private:
+	// The byte to match, or its lowercase letter if is_folded
 	char to_match;
-	llvm::LLVMContext* context;
-	llvm::Module* module;
-	llvm::IRBuilder<>* builder;
-	llvm::FunctionType* generated_function_type;
+	bool is_folded;
+
+	ByteSet get_bytes() const;
 };
\ No newline at end of file
@@ -0,0 +1,718 @@
+#include <array>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/GlobalVariable.h>
+#include "Matcher.h"
+#include "Dfa.h"
+#include "VectorSearch.h"
+#include "TypeProvider.h"
+#include "ConstantProvider.h"
+
+const char* const default_symbol_prefix = "rx";
+const char* const match_function_suffix = "_match";
+const char* const match_fd_function_suffix = "_match_fd";
+const char* const match_file_function_suffix = "_match_file";
+const char* const match_batch_function_suffix = "_match_batch";
+const char* const grep_fd_function_suffix = "_grep_fd";
+const char* const grep_file_function_suffix = "_grep_file";
+const char* const grep_lines_function_suffix = "_grep_lines";
+const char* const count_lines_function_suffix = "_count_lines";
+const char* const find_function_suffix = "_find";
+const char* const count_function_suffix = "_count";
+const char* const find_fd_function_suffix = "_find_fd";
+const char* const find_file_function_suffix = "_find_file";
+const char* const match_set_function_suffix = "_match_set";
+const char* const match_set_fd_function_suffix = "_match_set_fd";
+const char* const match_set_file_function_suffix = "_match_set_file";
+const char* const scan_function_name = "rx_scan";
+const int64_t scan_initial_state = 0;
+const int64_t scan_matched = -1;
+const int64_t scan_failed = -2;
+const size_t max_accelerated_bytes = 3;
+const size_t min_accelerated_loop_bytes = 8;
+const int32_t min_search_skip = 8;
+const int32_t max_search_credit = 256;
+const size_t max_run_length = 16;
+const size_t max_run_ranges = 4;
+const size_t max_switch_ranges = 8;
+const size_t max_coded_dfa_states = 256;
+
+bool getRunRanges(const ByteSet& bytes, std::vector<std::pair<uint8_t, uint8_t>>& ranges_out, uint8_t& case_bits_out) {
+	// Case-insensitive letters are compared as lowercase
+	uint8_t letter;
+	bool is_folded = getFoldedLetter(bytes, letter);
+	ranges_out = is_folded ? std::vector<std::pair<uint8_t, uint8_t>> { { letter, letter } } : getByteRanges(bytes);
+	case_bits_out = is_folded ? 0x20 : 0;
+	return ranges_out.size() <= max_run_ranges;
+}
+
+llvm::Value* buildRunCompare(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Value* input, const std::vector<std::vector<std::pair<uint8_t, uint8_t>>>& run_ranges, const std::vector<uint8_t>& case_bits) {
+	if (std::any_of(case_bits.begin(), case_bits.end(), [](uint8_t bits) { return bits != 0; })) {
+		input = builder.CreateOr(input, llvm::ConstantDataVector::get(context, llvm::ArrayRef<uint8_t>(case_bits)));
+	}
+
+	size_t num_ranges = 1;
+	for (const std::vector<std::pair<uint8_t, uint8_t>>& ranges : run_ranges) {
+		num_ranges = std::max(num_ranges, ranges.size());
+	}
+
+	// Literals are one compare, and classes take one subtraction and one unsigned compare per range (see buildFindRangesFunction). Classes with
+	// fewer ranges than the others repeat their last one.
+	llvm::Value* any_match = nullptr;
+	for (size_t i = 0; i < num_ranges; i++) {
+		std::vector<uint8_t> firsts;
+		std::vector<uint8_t> widths;
+		for (const std::vector<std::pair<uint8_t, uint8_t>>& ranges : run_ranges) {
+			const std::pair<uint8_t, uint8_t>& range = ranges[std::min(i, ranges.size() - 1)];
+			firsts.push_back(range.first);
+			widths.push_back(static_cast<uint8_t>(range.second - range.first));
+		}
+
+		llvm::Value* first = llvm::ConstantDataVector::get(context, llvm::ArrayRef<uint8_t>(firsts));
+		llvm::Value* range_match = std::all_of(widths.begin(), widths.end(), [](uint8_t width) { return width == 0; })
+			? builder.CreateICmpEQ(input, first)
+			: builder.CreateICmpULE(builder.CreateSub(input, first), llvm::ConstantDataVector::get(context, llvm::ArrayRef<uint8_t>(widths)));
+		any_match = any_match ? builder.CreateOr(any_match, range_match) : range_match;
+	}
+
+	return any_match;
+}
+
+namespace {
+	// Returns the bits of each word of matched to set for patterns, given each pattern's bit in pattern_ids
+	std::map<uint32_t, uint64_t> getMatchedWordMasks(const std::vector<uint32_t>& patterns, const std::vector<uint32_t>& pattern_ids) {
+		std::map<uint32_t, uint64_t> word_masks;
+		for (uint32_t pattern : patterns) {
+			word_masks[pattern_ids[pattern] / 64] |= uint64_t(1) << (pattern_ids[pattern] % 64);
+		}
+		return word_masks;
+	}
+
+	// Sets the bits of matched for the patterns that have been found, given each pattern's bit in pattern_ids
+	void buildSetMatchedBits(TypeProvider& type_provider, llvm::IRBuilder<>& builder, llvm::Value* matched, const std::vector<uint32_t>& patterns, const std::vector<uint32_t>& pattern_ids) {
+		ConstantProvider constant_provider(type_provider);
+
+		for (const auto& [word, mask] : getMatchedWordMasks(patterns, pattern_ids)) {
+			llvm::Value* word_ptr = builder.CreateGEP(type_provider.getInt64(), matched, std::vector<llvm::Value*> { constant_provider.getInt32(word) });
+			builder.CreateStore(builder.CreateOr(builder.CreateLoad(type_provider.getInt64(), word_ptr), constant_provider.getInt64(mask)), word_ptr);
+		}
+	}
+
+	// Builds the scan function for dfa, or for a set of patterns if pattern_ids isn't null (see buildSetScanFunction)
+	llvm::Function* buildDfaScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const Dfa& dfa, bool has_byte_shuffle, const std::vector<uint32_t>* pattern_ids) {
+		TypeProvider type_provider(context);
+		ConstantProvider constant_provider(type_provider);
+
+		std::vector<llvm::Type*> scan_args { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getInt64(), type_provider.getBit() }; // buf, len, state, and is final
+		if (pattern_ids) {
+			scan_args.push_back(type_provider.getInt64Ptr()); // matched
+		}
+		llvm::FunctionType* scan_type = llvm::FunctionType::get(type_provider.getInt64(), scan_args, false);
+		llvm::Function* scan_function = llvm::Function::Create(scan_type, llvm::Function::PrivateLinkage, scan_function_name, &module);
+		llvm::Value* buf = scan_function->args().begin();
+		llvm::Value* input_len = (scan_function->args().begin() + 1);
+		llvm::Value* initial_state = (scan_function->args().begin() + 2);
+		llvm::Value* is_final = (scan_function->args().begin() + 3);
+		llvm::Value* matched_patterns = pattern_ids ? (scan_function->args().begin() + 4) : nullptr;
+
+		llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", scan_function);
+		llvm::BasicBlock* matched = llvm::BasicBlock::Create(context, "matched", scan_function);
+		llvm::BasicBlock* failed = llvm::BasicBlock::Create(context, "failed", scan_function);
+
+		builder.SetInsertPoint(matched);
+		builder.CreateRet(constant_provider.getInt64(scan_matched, true));
+
+		builder.SetInsertPoint(failed);
+		builder.CreateRet(constant_provider.getInt64(scan_failed, true));
+
+		// Each state is coded directly as a block, and accepting and dead states just return (after noting which patterns matched, for a set of them)
+		std::vector<llvm::BasicBlock*> state_blocks;
+		for (size_t i = 0; i < dfa.states.size(); i++) {
+			const DfaState& state = dfa.states[i];
+			if (state.is_accepting && pattern_ids) {
+				state_blocks.push_back(llvm::BasicBlock::Create(context, "state_" + std::to_string(i), scan_function));
+				builder.SetInsertPoint(state_blocks.back());
+				buildSetMatchedBits(type_provider, builder, matched_patterns, state.accepted_patterns, *pattern_ids);
+				builder.CreateBr(matched);
+			} else if (state.is_accepting) {
+				state_blocks.push_back(matched);
+			} else if (state.is_dead) {
+				state_blocks.push_back(failed);
+			} else {
+				state_blocks.push_back(llvm::BasicBlock::Create(context, "state_" + std::to_string(i), scan_function));
+			}
+		}
+
+		builder.SetInsertPoint(entry);
+		llvm::AllocaInst* index = builder.CreateAlloca(type_provider.getInt64(), nullptr, "index");
+		builder.CreateStore(constant_provider.getInt64(0), index);
+		llvm::SwitchInst* resume = builder.CreateSwitch(initial_state, failed, static_cast<unsigned>(dfa.states.size()));
+		for (size_t i = 0; i < dfa.states.size(); i++) {
+			resume->addCase(constant_provider.getInt64(i), state_blocks[i]);
+		}
+
+		// The blocks that read a single byte from the index, which literal runs that only partially match also jump to
+		std::vector<llvm::BasicBlock*> step_blocks;
+		for (size_t i = 0; i < dfa.states.size(); i++) {
+			step_blocks.push_back(dfa.states[i].is_accepting || dfa.states[i].is_dead
+				? nullptr
+				: llvm::BasicBlock::Create(context, "state_" + std::to_string(i) + "_step", scan_function));
+		}
+
+		// Runs stop at the first class with too many ranges to compare against
+		std::vector<std::vector<ByteSet>> runs = findRuns(dfa, max_run_length, [](const ByteSet& bytes) {
+			std::vector<std::pair<uint8_t, uint8_t>> ranges;
+			uint8_t case_bits;
+			return getRunRanges(bytes, ranges, case_bits);
+		});
+		for (size_t i = 0; i < dfa.states.size(); i++) {
+			const DfaState& state = dfa.states[i];
+			if (state.is_accepting || state.is_dead) {
+				continue;
+			}
+
+			llvm::BasicBlock* step = step_blocks[i];
+			llvm::BasicBlock* input_end = llvm::BasicBlock::Create(context, "state_" + std::to_string(i) + "_end", scan_function);
+
+			builder.SetInsertPoint(state_blocks[i]);
+			if (pattern_ids) {
+				buildSetMatchedBits(type_provider, builder, matched_patterns, state.accepted_patterns, *pattern_ids);
+			}
+			llvm::Value* input_index = builder.CreateLoad(type_provider.getInt64(), index);
+
+			// States that only leave on a few bytes (e.g. the one looking for the start of a match) skip ahead to the next of them with a vector search
+			ByteSet exit_bytes;
+			for (int byte = 0; byte < 256; byte++) {
+				exit_bytes[byte] = state.transitions[byte] != static_cast<int32_t>(i);
+			}
+			bool has_runs = true;
+			if (exit_bytes.none()) {
+				input_index = input_len;
+			} else {
+				llvm::Function* find_exit = buildFindExitFunction(context, builder, module, exit_bytes, has_byte_shuffle);
+
+				if (find_exit) {
+					// Each search adds how many bytes it skipped (less what it costs) to the state's credit, and it only searches while that's positive
+					llvm::AllocaInst* search_credit;
+					{
+						llvm::IRBuilderBase::InsertPointGuard insert_point_guard(builder);
+						builder.SetInsertPoint(entry, entry->begin());
+						search_credit = builder.CreateAlloca(type_provider.getInt32(), nullptr, "state_" + std::to_string(i) + "_search_credit");
+						builder.CreateStore(constant_provider.getInt32(max_search_credit), search_credit);
+					}
+
+					llvm::BasicBlock* search = llvm::BasicBlock::Create(context, "state_" + std::to_string(i) + "_search", scan_function);
+					llvm::BasicBlock* no_search = llvm::BasicBlock::Create(context, "state_" + std::to_string(i) + "_no_search", scan_function);
+					llvm::Value* credit = builder.CreateLoad(type_provider.getInt32(), search_credit);
+					builder.CreateCondBr(builder.CreateICmpSGT(credit, constant_provider.getInt32(0)), search, no_search);
+
+					builder.SetInsertPoint(no_search);
+					builder.CreateCondBr(builder.CreateICmpULT(input_index, input_len), step, input_end);
+
+					builder.SetInsertPoint(search);
+					llvm::Value* found = builder.CreateCall(find_exit->getFunctionType(), find_exit, std::vector<llvm::Value*> { buf, input_index, input_len });
+					builder.CreateStore(buildNextSearchCredit(context, builder, credit, input_index, found), search_credit);
+					builder.CreateStore(found, index);
+					input_index = found;
+				} else if (!exit_bytes.all()) {
+					// Without a search to land on the bytes that start a run, comparing it at every byte that loops back would be wasted
+					has_runs = false;
+				}
+			}
+
+			// Each class in the run is compared against its ranges
+			std::vector<std::vector<std::pair<uint8_t, uint8_t>>> run_ranges;
+			std::vector<uint8_t> run_case_bits;
+			for (const ByteSet& bytes : has_runs ? runs[i] : std::vector<ByteSet> {}) {
+				std::vector<std::pair<uint8_t, uint8_t>> ranges;
+				uint8_t case_bits;
+				getRunRanges(bytes, ranges, case_bits);
+				run_ranges.push_back(ranges);
+				run_case_bits.push_back(case_bits);
+			}
+
+			if (run_ranges.size() < 2) {
+				builder.CreateCondBr(builder.CreateICmpULT(input_index, input_len), step, input_end);
+			} else {
+				// Compare the rest of a run in one go when there's enough input left. If only part of it matches we skip to the state where it stopped
+				// matching, and read that byte like usual.
+				llvm::BasicBlock* check_room = llvm::BasicBlock::Create(context, "state_" + std::to_string(i) + "_check_room", scan_function);
+				llvm::BasicBlock* compare_run = llvm::BasicBlock::Create(context, "state_" + std::to_string(i) + "_compare_run", scan_function);
+				llvm::BasicBlock* run_matched = llvm::BasicBlock::Create(context, "state_" + std::to_string(i) + "_run_matched", scan_function);
+				llvm::BasicBlock* run_mismatched = llvm::BasicBlock::Create(context, "state_" + std::to_string(i) + "_run_mismatched", scan_function);
+				builder.CreateCondBr(builder.CreateICmpULT(input_index, input_len), check_room, input_end);
+
+				builder.SetInsertPoint(check_room);
+				llvm::Value* run_end = builder.CreateAdd(input_index, constant_provider.getInt64(run_ranges.size()));
+				builder.CreateCondBr(builder.CreateICmpULE(run_end, input_len), compare_run, step);
+
+				builder.SetInsertPoint(compare_run);
+				llvm::FixedVectorType* run_type = llvm::FixedVectorType::get(type_provider.getByte(), static_cast<unsigned>(run_ranges.size()));
+				llvm::Value* input_run = builder.CreateAlignedLoad(
+					run_type,
+					builder.CreateBitCast(builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { input_index }), run_type->getPointerTo()),
+					llvm::MaybeAlign(1)
+				);
+				llvm::IntegerType* run_mask_type = llvm::IntegerType::get(context, static_cast<unsigned>(run_ranges.size()));
+				llvm::Value* run_mask = builder.CreateBitCast(buildRunCompare(context, builder, input_run, run_ranges, run_case_bits), run_mask_type);
+				builder.CreateCondBr(builder.CreateICmpEQ(run_mask, llvm::ConstantInt::getAllOnesValue(run_mask_type)), run_matched, run_mismatched);
+
+				builder.SetInsertPoint(run_mismatched);
+				llvm::Value* num_matched = builder.CreateBinaryIntrinsic(llvm::Intrinsic::cttz, builder.CreateNot(run_mask), constant_provider.getBit(1));
+				builder.CreateStore(builder.CreateAdd(input_index, builder.CreateZExtOrTrunc(num_matched, type_provider.getInt64())), index);
+				llvm::SwitchInst* partial_run = builder.CreateSwitch(num_matched, step, static_cast<unsigned>(run_ranges.size() - 1));
+
+				int32_t run_target = static_cast<int32_t>(i);
+				for (size_t j = 0; j < run_ranges.size(); j++) {
+					run_target = dfa.states[run_target].transitions[run_ranges[j][0].first];
+					if (j + 1 < run_ranges.size()) {
+						partial_run->addCase(llvm::ConstantInt::get(run_mask_type, j + 1), step_blocks[run_target]);
+					}
+				}
+
+				builder.SetInsertPoint(run_matched);
+				builder.CreateStore(run_end, index);
+				builder.CreateBr(state_blocks[run_target]);
+			}
+
+			// Each byte is read exactly once
+			builder.SetInsertPoint(step);
+			input_index = builder.CreateLoad(type_provider.getInt64(), index);
+			llvm::Value* input = builder.CreateLoad(
+				type_provider.getByte(),
+				builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { input_index })
+			);
+			builder.CreateStore(builder.CreateAdd(input_index, constant_provider.getInt64(1)), index);
+
+			buildByteSwitch(context, builder, module, input, state.transitions, state_blocks, "rx_state_" + std::to_string(i) + "_table");
+
+			// Once the input runs out the caller can resume from this state with the next block, unless this is the end
+			builder.SetInsertPoint(input_end);
+			if (pattern_ids && !state.patterns_accepted_at_end.empty()) {
+				// The patterns that need $ only match at the end, and the rest have already been noted
+				llvm::BasicBlock* at_end = llvm::BasicBlock::Create(context, "state_" + std::to_string(i) + "_at_end", scan_function);
+				llvm::BasicBlock* resumable = llvm::BasicBlock::Create(context, "state_" + std::to_string(i) + "_resumable", scan_function);
+				builder.CreateCondBr(is_final, at_end, resumable);
+
+				builder.SetInsertPoint(at_end);
+				buildSetMatchedBits(type_provider, builder, matched_patterns, state.patterns_accepted_at_end, *pattern_ids);
+				builder.CreateRet(constant_provider.getInt64(scan_failed, true));
+
+				builder.SetInsertPoint(resumable);
+				builder.CreateRet(constant_provider.getInt64(i));
+			} else {
+				bool accepts_at_end = !pattern_ids && !state.patterns_accepted_at_end.empty();
+				builder.CreateRet(builder.CreateSelect(
+					is_final,
+					constant_provider.getInt64(accepts_at_end ? scan_matched : scan_failed, true),
+					constant_provider.getInt64(i)
+				));
+			}
+		}
+
+		return scan_function;
+	}
+
+	// What the table scan function does when it enters a state
+	const uint8_t table_state_continues = 0;
+	// Only for a set of patterns: some of them have matched, and the rest are still followed
+	const uint8_t table_state_matches = 1;
+	const uint8_t table_state_accepts = 2;
+	const uint8_t table_state_dead = 3;
+
+	// The bits of matched that a table scan function sets for each state, as entries offsets[state] to offsets[state + 1] of words and masks
+	struct MatchedBitsTables {
+		llvm::GlobalVariable* offsets;
+		llvm::GlobalVariable* words;
+		llvm::GlobalVariable* masks;
+	};
+
+	template <typename T>
+	llvm::GlobalVariable* buildConstantTable(llvm::LLVMContext& context, llvm::Module& module, const std::vector<T>& values, const std::string& name) {
+		llvm::Constant* table_constant = llvm::ConstantDataArray::get(context, values);
+		return new llvm::GlobalVariable(module, table_constant->getType(), true, llvm::GlobalValue::PrivateLinkage, table_constant, name);
+	}
+
+	llvm::Value* buildTableLoad(TypeProvider& type_provider, llvm::IRBuilder<>& builder, llvm::GlobalVariable* table, llvm::Type* element_type, llvm::Value* index) {
+		ConstantProvider constant_provider(type_provider);
+		return builder.CreateLoad(element_type, builder.CreateGEP(table->getValueType(), table, std::vector<llvm::Value*> { constant_provider.getInt64(0), index }));
+	}
+
+	// Builds the tables of the bits that each state of dfa sets, for the patterns that get_patterns returns for it
+	MatchedBitsTables buildMatchedBitsTables(llvm::LLVMContext& context, llvm::Module& module, const Dfa& dfa, const std::vector<uint32_t>& pattern_ids, const std::function<const std::vector<uint32_t>&(const DfaState&)>& get_patterns, const std::string& name) {
+		std::vector<uint32_t> offsets { 0 };
+		std::vector<uint32_t> words;
+		std::vector<uint64_t> masks;
+		for (const DfaState& state : dfa.states) {
+			for (const auto& [word, mask] : getMatchedWordMasks(get_patterns(state), pattern_ids)) {
+				words.push_back(word);
+				masks.push_back(mask);
+			}
+			offsets.push_back(static_cast<uint32_t>(words.size()));
+		}
+
+		// Empty arrays can't be constant data, and the entry is never read
+		words.push_back(0);
+		masks.push_back(0);
+		return MatchedBitsTables {
+			buildConstantTable(context, module, offsets, name + "_offsets"),
+			buildConstantTable(context, module, words, name + "_words"),
+			buildConstantTable(context, module, masks, name + "_masks")
+		};
+	}
+
+	// Sets the bits of matched that tables list for state
+	void buildTableMatchedBits(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Value* matched, llvm::Value* state, const MatchedBitsTables& tables, const std::string& name) {
+		TypeProvider type_provider(context);
+		ConstantProvider constant_provider(type_provider);
+		llvm::Function* function = builder.GetInsertBlock()->getParent();
+
+		llvm::BasicBlock* before = builder.GetInsertBlock();
+		llvm::BasicBlock* loop = llvm::BasicBlock::Create(context, name + "_loop", function);
+		llvm::BasicBlock* set_bits = llvm::BasicBlock::Create(context, name + "_set_bits", function);
+		llvm::BasicBlock* done = llvm::BasicBlock::Create(context, name + "_done", function);
+
+		llvm::Value* first = builder.CreateZExt(buildTableLoad(type_provider, builder, tables.offsets, type_provider.getInt32(), state), type_provider.getInt64());
+		llvm::Value* last = builder.CreateZExt(
+			buildTableLoad(type_provider, builder, tables.offsets, type_provider.getInt32(), builder.CreateAdd(state, constant_provider.getInt64(1))),
+			type_provider.getInt64()
+		);
+		builder.CreateBr(loop);
+
+		builder.SetInsertPoint(loop);
+		llvm::PHINode* entry = builder.CreatePHI(type_provider.getInt64(), 2);
+		entry->addIncoming(first, before);
+		builder.CreateCondBr(builder.CreateICmpULT(entry, last), set_bits, done);
+
+		builder.SetInsertPoint(set_bits);
+		llvm::Value* word = builder.CreateZExt(buildTableLoad(type_provider, builder, tables.words, type_provider.getInt32(), entry), type_provider.getInt64());
+		llvm::Value* mask = buildTableLoad(type_provider, builder, tables.masks, type_provider.getInt64(), entry);
+		llvm::Value* word_ptr = builder.CreateGEP(type_provider.getInt64(), matched, std::vector<llvm::Value*> { word });
+		builder.CreateStore(builder.CreateOr(builder.CreateLoad(type_provider.getInt64(), word_ptr), mask), word_ptr);
+		entry->addIncoming(builder.CreateAdd(entry, constant_provider.getInt64(1)), set_bits);
+		builder.CreateBr(loop);
+
+		builder.SetInsertPoint(done);
+	}
+
+	// Builds a scan function for dfa like buildDfaScanFunction does, but one that looks up each transition in a table instead of coding each state
+	// as blocks of its own. It reads a byte at a time with no searches or run compares, but its size doesn't depend on the DFA's, so large DFAs
+	// compile in about the time it takes to build them.
+	llvm::Function* buildTableScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const Dfa& dfa, const std::vector<uint32_t>* pattern_ids) {
+		TypeProvider type_provider(context);
+		ConstantProvider constant_provider(type_provider);
+
+		std::vector<llvm::Type*> scan_args { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getInt64(), type_provider.getBit() }; // buf, len, state, and is final
+		if (pattern_ids) {
+			scan_args.push_back(type_provider.getInt64Ptr()); // matched
+		}
+		llvm::FunctionType* scan_type = llvm::FunctionType::get(type_provider.getInt64(), scan_args, false);
+		llvm::Function* scan_function = llvm::Function::Create(scan_type, llvm::Function::PrivateLinkage, scan_function_name, &module);
+		llvm::Value* buf = scan_function->args().begin();
+		llvm::Value* input_len = (scan_function->args().begin() + 1);
+		llvm::Value* initial_state = (scan_function->args().begin() + 2);
+		llvm::Value* is_final = (scan_function->args().begin() + 3);
+		llvm::Value* matched_patterns = pattern_ids ? (scan_function->args().begin() + 4) : nullptr;
+		std::string table_prefix = scan_function_name;
+
+		// Bytes that every state treats alike share a column of the transition table, which keeps it small (e.g. a list of keywords only needs a
+		// column for each letter they use and one for everything else)
+		std::array<uint8_t, 256> byte_columns {};
+		size_t num_columns = 1;
+		for (const DfaState& state : dfa.states) {
+			std::map<std::pair<uint8_t, int32_t>, uint8_t> split_columns;
+			for (int byte = 0; byte < 256; byte++) {
+				auto inserted = split_columns.emplace(std::make_pair(byte_columns[byte], state.transitions[byte]), static_cast<uint8_t>(split_columns.size()));
+				byte_columns[byte] = inserted.first->second;
+			}
+			num_columns = split_columns.size();
+		}
+		std::vector<int> column_bytes(num_columns);
+		for (int byte = 255; byte >= 0; byte--) {
+			column_bytes[byte_columns[byte]] = byte;
+		}
+
+		// There are at most max_dfa_states states, so each one fits in 16 bits
+		std::vector<uint16_t> transitions;
+		std::vector<uint8_t> kinds;
+		std::vector<uint8_t> accepts_at_end;
+		for (const DfaState& state : dfa.states) {
+			for (int byte : column_bytes) {
+				transitions.push_back(static_cast<uint16_t>(state.transitions[byte]));
+			}
+
+			if (state.is_dead) {
+				kinds.push_back(table_state_dead);
+			} else if (state.is_accepting) {
+				kinds.push_back(table_state_accepts);
+			} else if (pattern_ids && !state.accepted_patterns.empty()) {
+				kinds.push_back(table_state_matches);
+			} else {
+				kinds.push_back(table_state_continues);
+			}
+			accepts_at_end.push_back(!state.patterns_accepted_at_end.empty());
+		}
+
+		llvm::GlobalVariable* columns_table = buildConstantTable(context, module, std::vector<uint8_t>(byte_columns.begin(), byte_columns.end()), table_prefix + "_columns");
+		llvm::GlobalVariable* transitions_table = buildConstantTable(context, module, transitions, table_prefix + "_transitions");
+		llvm::GlobalVariable* kinds_table = buildConstantTable(context, module, kinds, table_prefix + "_kinds");
+
+		llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", scan_function);
+		llvm::BasicBlock* enter_state = llvm::BasicBlock::Create(context, "enter_state", scan_function);
+		llvm::BasicBlock* special_state = llvm::BasicBlock::Create(context, "special_state", scan_function);
+		llvm::BasicBlock* live_state = llvm::BasicBlock::Create(context, "live_state", scan_function);
+		llvm::BasicBlock* next_byte = llvm::BasicBlock::Create(context, "next_byte", scan_function);
+		llvm::BasicBlock* step = llvm::BasicBlock::Create(context, "step", scan_function);
+		llvm::BasicBlock* input_end = llvm::BasicBlock::Create(context, "input_end", scan_function);
+		llvm::BasicBlock* at_end = llvm::BasicBlock::Create(context, "at_end", scan_function);
+		llvm::BasicBlock* resumable = llvm::BasicBlock::Create(context, "resumable", scan_function);
+		llvm::BasicBlock* matched = llvm::BasicBlock::Create(context, "matched", scan_function);
+		llvm::BasicBlock* failed = llvm::BasicBlock::Create(context, "failed", scan_function);
+
+		builder.SetInsertPoint(matched);
+		builder.CreateRet(constant_provider.getInt64(scan_matched, true));
+
+		builder.SetInsertPoint(failed);
+		builder.CreateRet(constant_provider.getInt64(scan_failed, true));
+
+		builder.SetInsertPoint(entry);
+		llvm::AllocaInst* index = builder.CreateAlloca(type_provider.getInt64(), nullptr, "index");
+		llvm::AllocaInst* current_state = builder.CreateAlloca(type_provider.getInt64(), nullptr, "state");
+		builder.CreateStore(constant_provider.getInt64(0), index);
+		builder.CreateStore(initial_state, current_state);
+		builder.CreateBr(enter_state);
+
+		// Most states just carry on, so the others are checked for with a single compare
+		builder.SetInsertPoint(enter_state);
+		llvm::Value* state = builder.CreateLoad(type_provider.getInt64(), current_state);
+		llvm::Value* kind = buildTableLoad(type_provider, builder, kinds_table, type_provider.getByte(), state);
+		builder.CreateCondBr(builder.CreateICmpEQ(kind, constant_provider.getByte(table_state_continues)), next_byte, special_state);
+
+		builder.SetInsertPoint(special_state);
+		builder.CreateCondBr(builder.CreateICmpEQ(kind, constant_provider.getByte(table_state_dead)), failed, live_state);
+
+		builder.SetInsertPoint(live_state);
+		if (pattern_ids) {
+			MatchedBitsTables accepted_tables = buildMatchedBitsTables(context, module, dfa, *pattern_ids, [](const DfaState& dfa_state) -> const std::vector<uint32_t>& {
+				return dfa_state.accepted_patterns;
+			}, table_prefix + "_accepted");
+			buildTableMatchedBits(context, builder, matched_patterns, state, accepted_tables, "accepted");
+		}
+		builder.CreateCondBr(builder.CreateICmpEQ(kind, constant_provider.getByte(table_state_accepts)), matched, next_byte);
+
+		// Each byte is read exactly once
+		builder.SetInsertPoint(next_byte);
+		llvm::Value* input_index = builder.CreateLoad(type_provider.getInt64(), index);
+		builder.CreateCondBr(builder.CreateICmpULT(input_index, input_len), step, input_end);
+
+		builder.SetInsertPoint(step);
+		llvm::Value* input = builder.CreateLoad(
+			type_provider.getByte(),
+			builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { input_index })
+		);
+		builder.CreateStore(builder.CreateAdd(input_index, constant_provider.getInt64(1)), index);
+		llvm::Value* column = builder.CreateZExt(
+			buildTableLoad(type_provider, builder, columns_table, type_provider.getByte(), builder.CreateZExt(input, type_provider.getInt64())),
+			type_provider.getInt64()
+		);
+		llvm::Value* transition = builder.CreateAdd(builder.CreateMul(state, constant_provider.getInt64(num_columns)), column);
+		builder.CreateStore(builder.CreateZExt(buildTableLoad(type_provider, builder, transitions_table, type_provider.getInt16(), transition), type_provider.getInt64()), current_state);
+		builder.CreateBr(enter_state);
+
+		// Once the input runs out the caller can resume from this state with the next block, unless this is the end
+		builder.SetInsertPoint(input_end);
+		builder.CreateCondBr(is_final, at_end, resumable);
+
+		builder.SetInsertPoint(resumable);
+		builder.CreateRet(state);
+
+		builder.SetInsertPoint(at_end);
+		if (pattern_ids) {
+			// The patterns that need $ only match at the end, and the rest have already been noted
+			MatchedBitsTables at_end_tables = buildMatchedBitsTables(context, module, dfa, *pattern_ids, [](const DfaState& dfa_state) -> const std::vector<uint32_t>& {
+				return dfa_state.patterns_accepted_at_end;
+			}, table_prefix + "_accepted_at_end");
+			buildTableMatchedBits(context, builder, matched_patterns, state, at_end_tables, "accepted_at_end");
+			builder.CreateBr(failed);
+		} else {
+			llvm::GlobalVariable* accepts_at_end_table = buildConstantTable(context, module, accepts_at_end, table_prefix + "_accepts_at_end");
+			llvm::Value* accepts = buildTableLoad(type_provider, builder, accepts_at_end_table, type_provider.getByte(), state);
+			builder.CreateCondBr(builder.CreateICmpNE(accepts, constant_provider.getByte(0)), matched, failed);
+		}
+
+		return scan_function;
+	}
+}
+
+std::string getSymbolName(const std::string& prefix, const char* suffix) {
+	return prefix + suffix;
+}
+
+std::string getBatchSymbolPrefix(const std::string& prefix, size_t index) {
+	return prefix + "_" + std::to_string(index + 1);
+}
+
+llvm::Function* buildFindExitFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const ByteSet& exit_bytes, bool has_byte_shuffle) {
+	llvm::IRBuilderBase::InsertPointGuard insert_point_guard(builder);
+	if (exit_bytes.count() <= max_accelerated_bytes) {
+		std::vector<uint8_t> bytes;
+		for (int byte = 0; byte < 256; byte++) {
+			if (exit_bytes.test(byte)) {
+				bytes.push_back(static_cast<uint8_t>(byte));
+			}
+		}
+		return buildFindAnyByteFunction(context, builder, module, bytes);
+	}
+
+	// e.g. waiting for the first byte of a class, or for the end of a run like \d+, which are too many bytes to compare against one by one
+	if (256 - exit_bytes.count() < min_accelerated_loop_bytes) {
+		return nullptr;
+	}
+	llvm::Function* find_exit = buildFindRangesFunction(context, builder, module, exit_bytes);
+	if (!find_exit && has_byte_shuffle) {
+		find_exit = buildFindClassFunction(context, builder, module, exit_bytes);
+	}
+	return find_exit;
+}
+
+llvm::Value* buildNextSearchCredit(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Value* credit, llvm::Value* from, llvm::Value* found) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	// Each search adds how many bytes it skipped, less what it costs, up to a limit so that a long skip doesn't pay for a long run of short ones
+	// Offsets are 64 bits, but the credit is capped so it only needs 32
+	llvm::Value* skipped = builder.CreateTrunc(
+		builder.CreateBinaryIntrinsic(llvm::Intrinsic::umin, builder.CreateSub(found, from), constant_provider.getInt64(max_search_credit)),
+		type_provider.getInt32()
+	);
+	llvm::Value* next_credit = builder.CreateSub(builder.CreateAdd(credit, skipped), constant_provider.getInt32(min_search_skip));
+	return builder.CreateBinaryIntrinsic(llvm::Intrinsic::smin, next_credit, constant_provider.getInt32(max_search_credit));
+}
+
+void buildByteSwitch(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Value* input, const std::array<int32_t, 256>& targets, const std::vector<llvm::BasicBlock*>& target_blocks, const std::string& table_name) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	// The most common target is the default so that the switch only lists the exceptions
+	std::map<int32_t, ByteSet> target_bytes;
+	for (int byte = 0; byte < 256; byte++) {
+		target_bytes[targets[byte]].set(static_cast<uint8_t>(byte));
+	}
+	int32_t default_target = std::max_element(target_bytes.begin(), target_bytes.end(), [](const auto& a, const auto& b) { return a.second.count() < b.second.count(); })->first;
+
+	// Letters that match in either case (e.g. in (?i)error) are one masked compare each before the switch, instead of a case each in it
+	std::array<int32_t, 256> switch_targets = targets;
+	std::vector<std::pair<uint8_t, int32_t>> folded_targets;
+	for (const auto& [target, bytes] : target_bytes) {
+		uint8_t letter;
+		if (target != default_target && getFoldedLetter(bytes, letter)) {
+			folded_targets.emplace_back(letter, target);
+			switch_targets[letter] = default_target;
+			switch_targets[letter & ~0x20] = default_target;
+		}
+	}
+
+	size_t num_ranges = 1;
+	size_t num_cases = 0;
+	for (int byte = 0; byte < 256; byte++) {
+		num_cases += switch_targets[byte] != default_target;
+		if (byte > 0 && switch_targets[byte] != switch_targets[byte - 1]) {
+			num_ranges++;
+		}
+	}
+
+	if (num_ranges <= max_switch_ranges) {
+		for (const std::pair<uint8_t, int32_t>& folded_target : folded_targets) {
+			llvm::BasicBlock* other_case = llvm::BasicBlock::Create(
+				context, builder.GetInsertBlock()->getName().str() + "_not_" + std::string(1, static_cast<char>(folded_target.first)), builder.GetInsertBlock()->getParent()
+			);
+			builder.CreateCondBr(buildCompareFoldedLetter(builder, input, folded_target.first), target_blocks[folded_target.second], other_case);
+			builder.SetInsertPoint(other_case);
+		}
+
+		// A few ranges (e.g. [a-z]) become range compares
+		llvm::SwitchInst* transition = builder.CreateSwitch(input, target_blocks[default_target], static_cast<unsigned>(num_cases));
+		for (int byte = 0; byte < 256; byte++) {
+			if (switch_targets[byte] != default_target) {
+				transition->addCase(constant_provider.getByte(static_cast<uint8_t>(byte)), target_blocks[switch_targets[byte]]);
+			}
+		}
+		return;
+	}
+
+	// Anything more scattered (e.g. \w or [,;:|]) looks up which target to take in a table, and switches over the targets instead
+	std::vector<int32_t> distinct_targets;
+	std::vector<uint8_t> table;
+	for (int32_t target : targets) {
+		auto existing = std::find(distinct_targets.begin(), distinct_targets.end(), target);
+		if (existing == distinct_targets.end()) {
+			existing = distinct_targets.insert(distinct_targets.end(), target);
+		}
+		table.push_back(static_cast<uint8_t>(existing - distinct_targets.begin()));
+	}
+
+	llvm::Constant* table_constant = llvm::ConstantDataArray::get(context, table);
+	llvm::GlobalVariable* table_global = new llvm::GlobalVariable(module, table_constant->getType(), true, llvm::GlobalValue::PrivateLinkage, table_constant, table_name);
+	llvm::Value* target_index = builder.CreateLoad(
+		type_provider.getByte(),
+		builder.CreateGEP(table_constant->getType(), table_global, std::vector<llvm::Value*> { constant_provider.getInt32(0), builder.CreateZExt(input, type_provider.getInt32()) })
+	);
+
+	llvm::SwitchInst* transition = builder.CreateSwitch(target_index, target_blocks[distinct_targets[0]], static_cast<unsigned>(distinct_targets.size() - 1));
+	for (size_t i = 1; i < distinct_targets.size(); i++) {
+		transition->addCase(constant_provider.getByte(static_cast<uint8_t>(i)), target_blocks[distinct_targets[i]]);
+	}
+}
+
+llvm::Function* buildScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const Dfa& dfa, bool has_byte_shuffle) {
+	if (dfa.states.size() > max_coded_dfa_states) {
+		return buildTableScanFunction(context, builder, module, dfa, nullptr);
+	}
+	return buildDfaScanFunction(context, builder, module, dfa, has_byte_shuffle, nullptr);
+}
+
+llvm::Function* buildSetScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const Dfa& dfa, bool has_byte_shuffle, const std::vector<uint32_t>& pattern_ids, size_t max_coded_states) {
+	if (dfa.states.size() > max_coded_states) {
+		return buildTableScanFunction(context, builder, module, dfa, &pattern_ids);
+	}
+	return buildDfaScanFunction(context, builder, module, dfa, has_byte_shuffle, &pattern_ids);
+}
+
+llvm::Function* buildMatchFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* scan_function, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	// The length is a size_t so that this can be called from C, assuming a 64-bit target
+	llvm::FunctionType* match_type = llvm::FunctionType::get(
+		type_provider.getInt32(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64() }, // buf and len
+		false
+	);
+	llvm::Function* match_function = llvm::Function::Create(match_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, match_function_suffix), &module);
+	llvm::Value* buf = match_function->args().begin();
+	llvm::Value* input_len = (match_function->args().begin() + 1);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", match_function);
+
+	builder.SetInsertPoint(entry);
+	llvm::Value* result = builder.CreateCall(
+		scan_function->getFunctionType(),
+		scan_function,
+		std::vector<llvm::Value*> { buf, input_len, constant_provider.getInt64(scan_initial_state), constant_provider.getBit(1) }
+	);
+	builder.CreateRet(builder.CreateZExt(builder.CreateICmpEQ(result, constant_provider.getInt64(scan_matched, true)), type_provider.getInt32()));
+
+	return match_function;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include "Dfa.h"
+
+// The generated entry points are named by a prefix (so that several matchers can be linked into one program) followed by one of the suffixes below
+extern const char* const default_symbol_prefix;
+std::string getSymbolName(const std::string& prefix, const char* suffix);
+// The prefix of the entry points for the regex at index (from 0) of a batch compiled with the given prefix, e.g. rx_1 for the first (see
+// compileBatch)
+std::string getBatchSymbolPrefix(const std::string& prefix, size_t index);
+
+// The matcher, which has the signature i32 (i8* buf, i64 len) and returns 1 on a match or 0 otherwise
+extern const char* const match_function_suffix;
+// The file descriptor matcher, which has the signature i32 (i32 fd) and returns 1 on a match, 0 otherwise, or -1 if fd can't be read
+extern const char* const match_fd_function_suffix;
+// The file matcher, which has the signature i32 (i8* path) and returns 1 on a match, 0 otherwise, or -1 if the file can't be opened or read
+extern const char* const match_file_function_suffix;
+// The batch matcher, which has the signature i64 (i8* data, i32* offsets, i64 n, i8* results) and matches each of n records stored back to back in
+// data, where record i is data[offsets[i], offsets[i + 1]) (see Records.h). Sets results[i] to 1 if record i matches or 0 otherwise, and returns how
+// many matched.
+extern const char* const match_batch_function_suffix;
+// The line matcher built in line mode, which has the signature i64 (i32 fd, i8* name) and prints the matching lines of fd (prefixed with name if
+// it isn't null), or their count. Returns the number of matching lines, or -1 if fd can't be read.
+extern const char* const grep_fd_function_suffix;
+// The line matcher for files built in line mode, which has the signature i64 (i8* path, i8* name) and otherwise works like the above, except that
+// it also returns -1 if the file can't be opened
+extern const char* const grep_file_function_suffix;
+// The line matcher for buffers built in line mode, which has the signature i64 (i8* buf, i64 len, i8* name, i64* state) and greps the lines of buf
+// like the above, carrying on from state: an i64[2] holding the number of lines before buf and how many of them matched (both 0 at the start of the
+// input). Returns the updated match count, and doesn't print it in count-only mode. The last line of buf is taken to be complete.
+extern const char* const grep_lines_function_suffix;
+// The line counter built in line mode, which has the signature i64 (i8* buf, i64 len, i64* state) and works like the above without printing
+// anything, so that the lines of a large input can be counted in parallel before only the parts with matches are printed
+extern const char* const count_lines_function_suffix;
+// The match finder built in find mode, which has the signature i32 (i8* buf, i64 len, i64 from, i64* start, i64* end) and finds the first match in
+// buf that starts at or after from (see Find.h). Returns 1 and sets start and end to its offsets if there is one, or 0 if there isn't.
+extern const char* const find_function_suffix;
+// The match counter built in find mode, which has the signature i64 (i8* buf, i64 len) and returns how many matches there are in buf (as found one
+// after the other)
+extern const char* const count_function_suffix;
+// The match finder for file descriptors built in find mode, which has the signature i64 (i32 fd, i8* name) and prints the start and end offsets of
+// each match in fd (prefixed with name if it isn't null), or their count. Returns the number of matches, or -1 if fd can't be read.
+extern const char* const find_fd_function_suffix;
+// The match finder for files built in find mode, which has the signature i64 (i8* path, i8* name) and otherwise works like the above, except that
+// it also returns -1 if the file can't be opened
+extern const char* const find_file_function_suffix;
+// For a set of patterns, the set matcher, which has the signature i32 (i8* buf, i64 len, i64* matched) and sets bit i of matched (an array of
+// (pattern count + 63) / 64 words) if pattern i matches buf, clearing the rest. Returns how many patterns matched.
+extern const char* const match_set_function_suffix;
+// The file descriptor set matcher, which has the signature i32 (i32 fd, i64* matched) and otherwise works like the above, returning -1 if fd can't
+// be read
+extern const char* const match_set_fd_function_suffix;
+// The file set matcher, which has the signature i32 (i8* path, i64* matched) and also returns -1 if the file can't be opened
+extern const char* const match_set_file_function_suffix;
+// Name of the private function the matcher is built on, which has the signature i64 (i8* buf, i64 len, i64 state, i1 is_final). It runs the DFA
+// over buf starting from state (scan_initial_state at the start of the input) and returns scan_matched or scan_failed as soon as that's known,
+// and otherwise the state to resume from with the next block of input. When is_final is set, buf is the rest of the input and only scan_matched or
+// scan_failed are returned.
+extern const char* const scan_function_name;
+extern const int64_t scan_initial_state;
+extern const int64_t scan_matched;
+extern const int64_t scan_failed;
+// DFA states that lead back to themselves on all but this many bytes skip ahead with a vector search for the others
+extern const size_t max_accelerated_bytes;
+// States that lead back to themselves on at least this many bytes (e.g. in the middle of \d+) also search for the others, if they're a few ranges or
+// (with PSHUFB) a class
+extern const size_t min_accelerated_loop_bytes;
+// A search that skips fewer than this many bytes on average (e.g. for bytes that are common in the input) is slower than reading them one at a
+// time, so each state stops searching for the rest of the scan once it has fallen behind by max_search_credit bytes
+extern const int32_t min_search_skip;
+extern const int32_t max_search_credit;
+// States in the middle of a run like a literal or \d{16} compare up to this many of its bytes at once (see findRuns), as long as each class in it
+// is at most this many ranges
+extern const size_t max_run_length;
+extern const size_t max_run_ranges;
+// States whose transitions split the bytes into more ranges than this look up their next state in a table instead of comparing against each range
+extern const size_t max_switch_ranges;
+// DFAs with more states than this are scanned with a loop that looks up each transition in a table, rather than having each state coded as blocks
+// of its own, since the time LLVM takes to optimize the blocks grows faster than their number
+extern const size_t max_coded_dfa_states;
+
+// Sets ranges_out to the ranges buildRunCompare compares a byte against to check whether it's in bytes, and case_bits_out to the bits it sets in the
+// byte first. Returns whether there are at most max_run_ranges of them.
+bool getRunRanges(const ByteSet& bytes, std::vector<std::pair<uint8_t, uint8_t>>& ranges_out, uint8_t& case_bits_out);
+// Returns whether each byte of input (a vector of bytes) is in the class at its position of a run, given by the ranges of each class and the bits to
+// set in each byte first (0x20 for the letters that match in either case, see buildCompareFoldedLetter)
+llvm::Value* buildRunCompare(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Value* input, const std::vector<std::vector<std::pair<uint8_t, uint8_t>>>& run_ranges, const std::vector<uint8_t>& case_bits);
+
+// Builds the search a state that leads back to itself on all but exit_bytes skips ahead with (see max_accelerated_bytes and min_accelerated_loop_bytes),
+// or returns null if it has too many exit bytes for one to pay off
+llvm::Function* buildFindExitFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const ByteSet& exit_bytes, bool has_byte_shuffle);
+// Returns a state's search credit (see min_search_skip) after a search from index from that landed on index found
+llvm::Value* buildNextSearchCredit(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Value* credit, llvm::Value* from, llvm::Value* found);
+
+// Branches to target_blocks[targets[input]] for the byte input, comparing it against the ranges of targets or, if there are more than
+// max_switch_ranges of them, looking up which one it's in from a constant table named table_name
+void buildByteSwitch(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Value* input, const std::array<int32_t, 256>& targets, const std::vector<llvm::BasicBlock*>& target_blocks, const std::string& table_name);
+
+// has_byte_shuffle enables searching for classes of bytes with PSHUFB, see hasByteShuffle
+llvm::Function* buildScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const Dfa& dfa, bool has_byte_shuffle);
+// Builds a scan function for a DFA that searches for a set of patterns (see buildNfaSet), which has an extra i64* matched argument after is_final.
+// Rather than returning as soon as a pattern matches, it sets bit pattern_ids[i] of matched when pattern i does and carries on, and only returns
+// scan_matched once they've all matched. Otherwise it returns scan_failed once it's done. The DFA is table-driven if it has more than
+// max_coded_states states, so that the groups of a set can share max_coded_dfa_states between them.
+llvm::Function* buildSetScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const Dfa& dfa, bool has_byte_shuffle, const std::vector<uint32_t>& pattern_ids, size_t max_coded_states);
+llvm::Function* buildMatchFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* scan_function, const std::string& symbol_prefix);
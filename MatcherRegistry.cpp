@@ -0,0 +1,151 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+#include <dlfcn.h>
+#include "MatcherRegistry.h"
+
+struct MatcherRegistry::Ruleset {
+	void* library;
+	std::vector<MatchFunction> matchers;
+};
+
+// Padded to a cache line, so that readers on different cores don't contend for the line they each write on every call
+struct alignas(64) MatcherRegistry::ReaderSlot {
+	// The epoch the reader entered in, or 0 while it isn't in a call
+	std::atomic<uint64_t> epoch;
+	// Whether a reader owns the slot
+	bool is_used;
+};
+
+MatcherRegistry::Reader::Reader(MatcherRegistry& registry, ReaderSlot& slot)
+: registry{registry}, slot{slot}
+{ }
+
+MatcherRegistry::Reader::~Reader() {
+	std::lock_guard<std::mutex> lock(registry.slots_mutex);
+	slot.is_used = false;
+}
+
+const MatcherRegistry::Ruleset* MatcherRegistry::Reader::enter() {
+	// Sequentially consistent, so that a swap that doesn't see this epoch yet has already replaced the ruleset this is about to read
+	slot.epoch.store(registry.epoch.load());
+	return registry.current.load();
+}
+
+void MatcherRegistry::Reader::exit() {
+	slot.epoch.store(0, std::memory_order_release);
+}
+
+int32_t MatcherRegistry::Reader::match(size_t index, const char* buf, size_t len) {
+	const Ruleset* ruleset = enter();
+	int32_t result = ruleset && index < ruleset->matchers.size() ? ruleset->matchers[index](buf, len) : -1;
+	exit();
+
+	return result;
+}
+
+size_t MatcherRegistry::Reader::matchAll(const char* buf, size_t len, std::vector<uint8_t>& results) {
+	const Ruleset* ruleset = enter();
+	size_t num_matched = 0;
+	results.assign(ruleset ? ruleset->matchers.size() : 0, 0);
+	for (size_t i = 0; i < results.size(); i++) {
+		results[i] = ruleset->matchers[i](buf, len) > 0;
+		num_matched += results[i];
+	}
+	exit();
+
+	return num_matched;
+}
+
+MatcherRegistry::MatcherRegistry()
+: current{nullptr}, epoch{1}
+{ }
+
+MatcherRegistry::~MatcherRegistry() {
+	const Ruleset* ruleset = current.load();
+	if (ruleset) {
+		dlclose(ruleset->library);
+		delete ruleset;
+	}
+}
+
+bool MatcherRegistry::load(const std::string& path, const std::string& prefix, std::string& error_out) {
+	// The matchers are bound straight away so that a missing symbol fails here rather than in a reader, and kept local so that two rulesets' symbols
+	// never resolve to each other
+	void* library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if (!library) {
+		error_out = dlerror();
+		return false;
+	}
+
+	std::unique_ptr<Ruleset> ruleset(new Ruleset { library, {} });
+	while (true) {
+		std::string name = prefix + "_" + std::to_string(ruleset->matchers.size() + 1) + "_match";
+		void* matcher = dlsym(library, name.c_str());
+		if (!matcher) {
+			break;
+		}
+		ruleset->matchers.push_back(reinterpret_cast<MatchFunction>(matcher));
+	}
+
+	if (ruleset->matchers.empty()) {
+		error_out = "No matcher named " + prefix + "_1_match in " + path;
+		dlclose(library);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(load_mutex);
+	const Ruleset* old_ruleset = current.exchange(ruleset.release());
+	waitForReaders(epoch.fetch_add(1) + 1);
+	if (old_ruleset) {
+		dlclose(old_ruleset->library);
+		delete old_ruleset;
+	}
+
+	return true;
+}
+
+std::unique_ptr<MatcherRegistry::Reader> MatcherRegistry::createReader() {
+	std::lock_guard<std::mutex> lock(slots_mutex);
+	ReaderSlot* free_slot = nullptr;
+	for (std::unique_ptr<ReaderSlot>& slot : slots) {
+		if (!slot->is_used) {
+			free_slot = slot.get();
+			break;
+		}
+	}
+	if (!free_slot) {
+		slots.push_back(std::unique_ptr<ReaderSlot>(new ReaderSlot { {0}, false }));
+		free_slot = slots.back().get();
+	}
+
+	free_slot->is_used = true;
+	return std::unique_ptr<Reader>(new Reader(*this, *free_slot));
+}
+
+void MatcherRegistry::waitForReaders(uint64_t new_epoch) {
+	// Readers created from here on can only see the new ruleset, so only the ones that exist now need to be waited on
+	std::vector<ReaderSlot*> readers;
+	{
+		std::lock_guard<std::mutex> lock(slots_mutex);
+		for (std::unique_ptr<ReaderSlot>& slot : slots) {
+			readers.push_back(slot.get());
+		}
+	}
+
+	// Calls are short, so this spins (giving up the core in between) rather than having readers signal anything
+	for (ReaderSlot* reader : readers) {
+		while (true) {
+			uint64_t reader_epoch = reader->epoch.load();
+			if (reader_epoch == 0 || reader_epoch >= new_epoch) {
+				break;
+			}
+			std::this_thread::yield();
+		}
+	}
+}
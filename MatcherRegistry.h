@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Loads the matchers of a batch (see compileBatch) from a shared library at runtime and swaps in new versions of them while other threads are matching,
+// for services whose rules change without a restart. The library can be linked from the one --batch writes, e.g.
+// `cc -shared -o rules-2.so -Wl,--whole-archive librx.a -Wl,--no-whole-archive` (its objects are position independent).
+//
+// Swapping works like RCU: matching only reads the current ruleset through an atomic pointer, after recording the epoch it started in, so it never
+// takes a lock or waits for a swap. A swap replaces the pointer, moves on to the next epoch and then waits until every thread that may still be using
+// the old ruleset has finished its call before unloading it.
+class MatcherRegistry {
+	struct Ruleset;
+	struct ReaderSlot;
+
+public:
+	using MatchFunction = int32_t (*)(const char* buf, size_t len);
+
+	// A thread's registration for matching. Each thread that matches needs its own, which it should keep rather than create for each call, and all of
+	// them have to be destroyed before the registry.
+	class Reader {
+	public:
+		~Reader();
+		Reader(const Reader&) = delete;
+		Reader& operator=(const Reader&) = delete;
+
+		// Returns 1 if the regex at index (from 0) of the current ruleset matches buf, 0 if it doesn't, or -1 if there's no such regex (or nothing
+		// has been loaded)
+		int32_t match(size_t index, const char* buf, size_t len);
+		// Sets results to whether each regex of the current ruleset matches buf, so they all come from the same version, and returns how many did
+		size_t matchAll(const char* buf, size_t len, std::vector<uint8_t>& results);
+
+	private:
+		friend class MatcherRegistry;
+		Reader(MatcherRegistry& registry, ReaderSlot& slot);
+
+		// Marks the start and end of a call, between which the ruleset returned by enter isn't unloaded
+		const Ruleset* enter();
+		void exit();
+
+		MatcherRegistry& registry;
+		ReaderSlot& slot;
+	};
+
+	MatcherRegistry();
+	// Unloads the current ruleset, so no thread may be matching
+	~MatcherRegistry();
+	MatcherRegistry(const MatcherRegistry&) = delete;
+	MatcherRegistry& operator=(const MatcherRegistry&) = delete;
+
+	// Opens the shared library at path and looks up the matchers named prefix_1_match, prefix_2_match and so on until one is missing, then makes
+	// them the current ruleset and unloads the previous one once the calls using it have finished. dlopen returns the library that's already loaded
+	// for a path, so each version has to be at a new path. Returns false and sets error_out if the library can't be opened or has no matchers, in
+	// which case the current ruleset is kept. Only blocks the calling thread, and swaps are done one at a time.
+	bool load(const std::string& path, const std::string& prefix, std::string& error_out);
+
+	std::unique_ptr<Reader> createReader();
+
+private:
+	// Waits until every reader that entered before the current epoch has exited
+	void waitForReaders(uint64_t epoch);
+
+	std::atomic<const Ruleset*> current;
+	// Starts at 1, since readers that are outside a call record 0
+	std::atomic<uint64_t> epoch;
+
+	// Readers' slots are kept until the registry is destroyed (and reused by later readers), so a swap can wait on them without holding slots_mutex
+	std::mutex slots_mutex;
+	std::vector<std::unique_ptr<ReaderSlot>> slots;
+
+	std::mutex load_mutex;
+};
@@ -0,0 +1,96 @@
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include "Nfa.h"
+#include "Summary.h"
+
+Nfa::Nfa()
+: start{0}, num_optional_copies{0}
+{
+	addState();
+}
+
+int32_t Nfa::addState() {
+	states.push_back(NfaState { {}, {}, static_cast<int32_t>(accepts.size()) - 1 });
+	return static_cast<int32_t>(states.size() - 1);
+}
+
+void Nfa::addByteTransition(int32_t from, int32_t to, const ByteSet& bytes) {
+	states[from].byte_transitions.push_back(NfaByteTransition { bytes, to });
+}
+
+void Nfa::addEpsilonTransition(int32_t from, int32_t to, Assertion assertion) {
+	states[from].epsilon_transitions.push_back(NfaEpsilonTransition { assertion, to });
+}
+
+int32_t Nfa::addPattern() {
+	accepts.push_back(-1);
+	int32_t first = addState();
+	addEpsilonTransition(start, first, Assertion::None);
+	return first;
+}
+
+int32_t Nfa::getStart() const {
+	return start;
+}
+
+const std::vector<int32_t>& Nfa::getAccepts() const {
+	return accepts;
+}
+
+void Nfa::setAccept(int32_t state) {
+	accepts.back() = state;
+}
+
+void Nfa::addOptionalCopies(int32_t first, uint32_t num_copies) {
+	// A copy in an outer repeat takes the place of one in a repeat inside it, since the states can only be in one run
+	uint32_t copy_size = static_cast<uint32_t>(states.size() - static_cast<size_t>(first)) / num_copies;
+	for (size_t state = static_cast<size_t>(first); state < states.size(); state++) {
+		uint32_t position = static_cast<uint32_t>(state - static_cast<size_t>(first));
+		states[state].copies = num_optional_copies;
+		states[state].copy_index = position / copy_size;
+		states[state].copy_offset = position % copy_size;
+	}
+	num_optional_copies++;
+}
+
+const std::vector<NfaState>& Nfa::getStates() const {
+	return states;
+}
+
+namespace {
+	void addAtoms(Nfa& nfa, const std::vector<std::unique_ptr<Atom>>& atoms) {
+		int32_t current = nfa.addPattern();
+		for (const std::unique_ptr<Atom>& atom : atoms) {
+			int32_t next = nfa.addState();
+			atom->add_to_nfa(nfa, current, next);
+			current = next;
+		}
+		nfa.setAccept(current);
+	}
+}
+
+uint64_t getNfaSize(const std::vector<std::unique_ptr<Atom>>& atoms, bool expand_repeats) {
+	// Each atom adds a state after it (see addAtoms)
+	uint64_t size = 0;
+	for (const std::unique_ptr<Atom>& atom : atoms) {
+		size = addLengths(size, addLengths(atom->get_nfa_size(expand_repeats), 1));
+	}
+	return size;
+}
+
+Nfa buildNfa(const std::vector<std::unique_ptr<Atom>>& atoms) {
+	Nfa nfa;
+	addAtoms(nfa, atoms);
+
+	return nfa;
+}
+
+Nfa buildNfaSet(const std::vector<const std::vector<std::unique_ptr<Atom>>*>& patterns) {
+	Nfa nfa;
+	for (const std::vector<std::unique_ptr<Atom>>* atoms : patterns) {
+		addAtoms(nfa, *atoms);
+	}
+
+	return nfa;
+}
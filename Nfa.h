@@ -0,0 +1,78 @@
+#pragma once
+
+#include <bitset>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include "Atom.h"
+
+// Conditions on the position in the input that guard epsilon transitions
+enum class Assertion {
+	None,
+	// Only at the start of the input
+	StringStart,
+	// Only at the end of the input, or before a newline that ends it
+	StringEnd
+};
+
+struct NfaByteTransition {
+	ByteSet bytes;
+	int32_t to;
+};
+
+struct NfaEpsilonTransition {
+	Assertion assertion;
+	int32_t to;
+};
+
+struct NfaState {
+	std::vector<NfaByteTransition> byte_transitions;
+	std::vector<NfaEpsilonTransition> epsilon_transitions;
+	// The pattern that this state is part of, or -1 for the start state that they all share
+	int32_t pattern;
+	// If this state is in one of a run of copies of the same states (see Nfa::addOptionalCopies), the run's id (or -1 if it isn't), which copy
+	// it's in, and where it is in that copy
+	int32_t copies = -1;
+	uint32_t copy_index = 0;
+	uint32_t copy_offset = 0;
+};
+
+// A Thompson NFA for one or more patterns, where each atom adds transitions between a pair of states. The patterns share a start state, and each
+// has its own accepting state.
+class Nfa {
+public:
+	Nfa();
+
+	// Adds a state that's part of the last pattern added
+	int32_t addState();
+	void addByteTransition(int32_t from, int32_t to, const ByteSet& bytes);
+	void addEpsilonTransition(int32_t from, int32_t to, Assertion assertion);
+	// Starts a new pattern, and returns its first state, which the start state leads to
+	int32_t addPattern();
+
+	int32_t getStart() const;
+	// The accepting state of each pattern
+	const std::vector<int32_t>& getAccepts() const;
+	// Sets the accepting state of the last pattern added
+	void setAccept(int32_t state);
+	// Marks the states from first on (to the last one added) as num_copies copies of the same states, where whatever a state of one copy can
+	// match, the same state of an earlier copy can too (like the optional copies of x{2,5}, since fewer of them have been used up). A DFA only
+	// has to follow the earliest copy that each state is in.
+	void addOptionalCopies(int32_t first, uint32_t num_copies);
+	const std::vector<NfaState>& getStates() const;
+
+private:
+	std::vector<NfaState> states;
+	int32_t start;
+	std::vector<int32_t> accepts;
+	int32_t num_optional_copies;
+};
+
+// Returns how many states matching atoms in sequence adds to an NFA (at most), or UINT64_MAX if that's more than can be counted. Unless
+// expand_repeats, each repeat is counted as a single copy of its atom.
+uint64_t getNfaSize(const std::vector<std::unique_ptr<Atom>>& atoms, bool expand_repeats);
+
+// Builds the NFA matching atoms in sequence
+Nfa buildNfa(const std::vector<std::unique_ptr<Atom>>& atoms);
+// Builds the NFA matching any of patterns, each of which is a sequence of atoms, so that pattern i of the NFA is patterns[i]
+Nfa buildNfaSet(const std::vector<const std::vector<std::unique_ptr<Atom>>*>& patterns);
@@ -0,0 +1,55 @@
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Support/CodeGen.h>
+#include <llvm/Target/TargetMachine.h>
+#include "Optimizer.h"
+
+const unsigned default_opt_level = 3;
+const unsigned max_opt_level = 3;
+
+llvm::CodeGenOpt::Level getCodeGenOptLevel(unsigned opt_level) {
+	switch (opt_level) {
+		case 0:
+			return llvm::CodeGenOpt::None;
+		case 1:
+			return llvm::CodeGenOpt::Less;
+		case 2:
+			return llvm::CodeGenOpt::Default;
+		default:
+			return llvm::CodeGenOpt::Aggressive;
+	}
+}
+
+void optimizeModule(llvm::Module& module, llvm::TargetMachine* target_machine, unsigned opt_level) {
+	llvm::LoopAnalysisManager loop_analysis_manager;
+	llvm::FunctionAnalysisManager function_analysis_manager;
+	llvm::CGSCCAnalysisManager cgscc_analysis_manager;
+	llvm::ModuleAnalysisManager module_analysis_manager;
+
+	llvm::PassBuilder pass_builder(target_machine);
+	pass_builder.registerModuleAnalyses(module_analysis_manager);
+	pass_builder.registerCGSCCAnalyses(cgscc_analysis_manager);
+	pass_builder.registerFunctionAnalyses(function_analysis_manager);
+	pass_builder.registerLoopAnalyses(loop_analysis_manager);
+	pass_builder.crossRegisterProxies(loop_analysis_manager, function_analysis_manager, cgscc_analysis_manager, module_analysis_manager);
+
+	llvm::ModulePassManager module_pass_manager;
+	switch (opt_level) {
+		case 0:
+			// Only runs the always-inliner
+			module_pass_manager = pass_builder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0);
+			break;
+		case 1:
+			module_pass_manager = pass_builder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O1);
+			break;
+		case 2:
+			module_pass_manager = pass_builder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2);
+			break;
+		default:
+			module_pass_manager = pass_builder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
+			break;
+	}
+	module_pass_manager.run(module, module_analysis_manager);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CodeGen.h>
+#include <llvm/Target/TargetMachine.h>
+
+// Optimization levels work like clang's -O0 to -O3
+extern const unsigned default_opt_level;
+extern const unsigned max_opt_level;
+
+// The code generator's optimization level for opt_level
+llvm::CodeGenOpt::Level getCodeGenOptLevel(unsigned opt_level);
+
+// Runs the pipeline for opt_level over module, using target_machine (if not null) for target-specific cost models
+void optimizeModule(llvm::Module& module, llvm::TargetMachine* target_machine, unsigned opt_level);
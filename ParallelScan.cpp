@@ -0,0 +1,105 @@
+#include <string>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <cinttypes>
+#include <cstdio>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/FileSystem.h>
+#include "ParallelScan.h"
+
+namespace {
+	size_t getChunkSize(const ThreadPool& pool, size_t len) {
+		uint64_t chunk_size = len / (uint64_t(pool.getNumThreads()) * chunks_per_thread);
+		return static_cast<size_t>(std::clamp(chunk_size, min_chunk_size, max_chunk_size));
+	}
+
+	// A chunk of the input for grepInParallel, with the state that count_lines leaves for it (see grep_lines_function_suffix)
+	struct LineChunk {
+		const char* start;
+		size_t len;
+		int64_t state[2];
+	};
+}
+
+std::unique_ptr<llvm::MemoryBuffer> mapForParallelScan(const std::string& path) {
+	uint64_t size;
+	if (llvm::sys::fs::file_size(path, size) || size < min_parallel_file_size) {
+		return nullptr;
+	}
+
+	// Without a null terminator the file is always mapped rather than read
+	llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(path, false, false);
+	if (!buffer) {
+		return nullptr;
+	}
+	return std::move(*buffer);
+}
+
+int32_t matchInParallel(ThreadPool& pool, MatchFunction match, const char* buf, size_t len, uint64_t overlap) {
+	size_t chunk_size = getChunkSize(pool, len);
+	std::atomic<bool> is_matched(false);
+	for (size_t start = 0; start < len; start += chunk_size) {
+		// A match that starts in this chunk can run on into the next one by up to overlap bytes
+		size_t chunk_len = static_cast<size_t>(std::min<uint64_t>(len - start, uint64_t(chunk_size) + overlap));
+		pool.submit([&is_matched, match, buf, start, chunk_len]() {
+			if (!is_matched.load(std::memory_order_relaxed) && match(buf + start, chunk_len) > 0) {
+				is_matched.store(true, std::memory_order_relaxed);
+			}
+		});
+	}
+	pool.wait();
+
+	return is_matched.load() ? 1 : 0;
+}
+
+int64_t grepInParallel(ThreadPool& pool, GrepLinesFunction grep_lines, CountLinesFunction count_lines, const char* buf, size_t len, const char* name, bool count_only) {
+	size_t chunk_size = getChunkSize(pool, len);
+	std::vector<LineChunk> chunks;
+	for (size_t start = 0; start < len;) {
+		size_t end = std::min(len, start + chunk_size);
+		if (end < len) {
+			const void* newline = std::memchr(buf + end - 1, '\n', len - (end - 1));
+			end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - buf) + 1 : len;
+		}
+		chunks.push_back(LineChunk { buf + start, end - start, { 0, 0 } });
+		start = end;
+	}
+
+	for (LineChunk& chunk : chunks) {
+		pool.submit([&chunk, count_lines]() {
+			count_lines(chunk.start, chunk.len, chunk.state);
+		});
+	}
+	pool.wait();
+
+	int64_t match_count = 0;
+	for (const LineChunk& chunk : chunks) {
+		match_count += chunk.state[1];
+	}
+
+	// Printing has to be in order, but only the chunks with matches have to be scanned again for it. Like the generated code, this prints with stdio.
+	if (count_only) {
+		if (name) {
+			std::printf("%s:%" PRId64 "\n", name, match_count);
+		} else {
+			std::printf("%" PRId64 "\n", match_count);
+		}
+		return match_count;
+	}
+
+	int64_t line_number = 0;
+	for (const LineChunk& chunk : chunks) {
+		if (chunk.state[1] > 0) {
+			int64_t state[2] = { line_number, 0 };
+			grep_lines(chunk.start, chunk.len, name, state);
+		}
+		line_number += chunk.state[0];
+	}
+
+	return match_count;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <llvm/Support/MemoryBuffer.h>
+#include "ThreadPool.h"
+#include "Jit.h"
+
+// Large files are scanned with the JIT in chunks spread over a thread pool, each of which is passed to the generated functions (see Matcher.h) on
+// its own. Only inputs where that gives the same answer as scanning them in one go are split up.
+
+// Files smaller than this aren't worth splitting up
+const uint64_t min_parallel_file_size = 4 << 20;
+// Each thread gets about this many chunks, so that the ones that finish early have something to steal from the others
+const unsigned chunks_per_thread = 4;
+// Chunks are kept between these sizes, so that each task is worth queuing and a match found in one chunk soon stops the others
+const uint64_t min_chunk_size = 1 << 20;
+const uint64_t max_chunk_size = 64 << 20;
+
+// Maps the file at path if it's large enough to be worth scanning in parallel. Returns null if it isn't or it can't be mapped, in which case the
+// caller should scan it as usual (which also reports the error if it can't be read).
+std::unique_ptr<llvm::MemoryBuffer> mapForParallelScan(const std::string& path);
+
+// Matches buf in chunks that each share overlap bytes with the next (see getChunkOverlap), so that every match is wholly inside one of them. Chunks
+// that haven't started are skipped once any of them matches. Returns 1 on a match or 0 otherwise.
+int32_t matchInParallel(ThreadPool& pool, MatchFunction match, const char* buf, size_t len, uint64_t overlap);
+
+// Greps buf in chunks that end at the end of a line, so that each line is in exactly one of them. The chunks are counted in parallel with count_lines,
+// and then the ones with matches are printed in order with grep_lines, so the output is the same as grepping buf in one go. If count_only is set,
+// the count is printed instead (prefixed with name if it isn't null). Returns the number of matching lines.
+int64_t grepInParallel(ThreadPool& pool, GrepLinesFunction grep_lines, CountLinesFunction count_lines, const char* buf, size_t len, const char* name, bool count_only);
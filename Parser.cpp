@@ -0,0 +1,316 @@
+#include <string>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "Parser.h"
+#include "Literal.h"
+#include "StringStartMetacharacter.h"
+#include "StringEndMetacharacter.h"
+#include "CharacterClass.h"
+#include "Repeat.h"
+#include "Alternation.h"
+#include "Nfa.h"
+
+namespace {
+	// Regexes whose repeats add more NFA states than this once they're expanded are rejected, since repeats like x{m,n} add a copy of their atom's
+	// states for each count (and nested ones multiply them), and the DFA and the code generated from it grow with them. Optional copies don't
+	// blow up the DFA (see Nfa::addOptionalCopies), so this only keeps compiling from taking more than about a second. What's written out in
+	// the regex, like a long literal or a list of keywords, isn't limited by this.
+	const uint64_t max_repeat_states = 2048;
+
+	// Building the NFA recurses into each group, so they can only be nested this deep
+	const size_t max_group_depth = 1000;
+
+	using Branch = std::vector<std::unique_ptr<Atom>>;
+
+	// Returns whether c (following a \) names a class like \d, and sets bytes_out to its bytes
+	bool parseClassEscape(char c, ByteSet& bytes_out) {
+		switch (c) {
+			case 'd':
+				bytes_out = CharacterClass::digits();
+				return true;
+			case 'D':
+				bytes_out = ~CharacterClass::digits();
+				return true;
+			case 'w':
+				bytes_out = CharacterClass::word_characters();
+				return true;
+			case 'W':
+				bytes_out = ~CharacterClass::word_characters();
+				return true;
+			case 's':
+				bytes_out = CharacterClass::whitespace();
+				return true;
+			case 'S':
+				bytes_out = ~CharacterClass::whitespace();
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	// Parses a bracket expression like [a-z_] or [^,] starting after the [, and leaves index on the closing ]. If is_case_insensitive is set, the
+	// letters in it match in either case (and a negated one matches neither).
+	bool parseBracket(const std::string& regex, size_t& index, bool is_case_insensitive, ByteSet& bytes_out, std::string& error_out) {
+		bool is_negated = index < regex.size() && regex[index] == '^';
+		if (is_negated) {
+			index++;
+		}
+
+		ByteSet bytes;
+		// Like in Perl, a ] right at the start is a literal
+		bool is_first = true;
+		while (index < regex.size() && (regex[index] != ']' || is_first)) {
+			is_first = false;
+
+			char first = regex[index];
+			if (first == '\\') {
+				if (++index == regex.size()) {
+					break;
+				}
+
+				ByteSet class_bytes;
+				if (parseClassEscape(regex[index], class_bytes)) {
+					bytes |= class_bytes;
+					index++;
+					continue;
+				}
+				first = regex[index];
+			}
+			index++;
+
+			// A - that isn't between two characters is a literal
+			if (index + 1 < regex.size() && regex[index] == '-' && regex[index + 1] != ']') {
+				index++;
+				char last = regex[index];
+				if (last == '\\') {
+					if (++index == regex.size()) {
+						break;
+					}
+					last = regex[index];
+				}
+				index++;
+
+				if (static_cast<uint8_t>(last) < static_cast<uint8_t>(first)) {
+					error_out = std::string("Invalid range ") + first + "-" + last + " in character class";
+					return false;
+				}
+				for (int c = static_cast<uint8_t>(first); c <= static_cast<uint8_t>(last); c++) {
+					bytes.set(static_cast<uint8_t>(c));
+				}
+			} else {
+				bytes.set(static_cast<uint8_t>(first));
+			}
+		}
+
+		if (index >= regex.size()) {
+			error_out = "Unterminated character class";
+			return false;
+		}
+
+		if (is_case_insensitive) {
+			bytes = CharacterClass::case_folded(bytes);
+		}
+		bytes_out = is_negated ? ~bytes : bytes;
+		return true;
+	}
+	// Parses the count in a repeat like {2,4} from index, which is left on the first character after it
+	bool parseRepeatCount(const std::string& regex, size_t& index, uint32_t& count_out) {
+		size_t start = index;
+		uint64_t count = 0;
+		while (index < regex.size() && regex[index] >= '0' && regex[index] <= '9') {
+			// Huge counts are kept just below no_max_count, so they're still too big rather than unbounded
+			count = std::min<uint64_t>(count * 10 + static_cast<uint64_t>(regex[index] - '0'), Repeat::no_max_count - 1);
+			index++;
+		}
+
+		count_out = static_cast<uint32_t>(count);
+		return index != start;
+	}
+
+	// Parses a repeat like {2}, {2,}, {2,4} or {,4} starting after the {, and leaves index on the closing }. Returns false without an error if it
+	// isn't one, since the { is then a literal, like in Perl.
+	bool parseBraces(const std::string& regex, size_t& index, uint32_t& min_count_out, uint32_t& max_count_out, std::string& error_out) {
+		size_t start = index;
+		bool has_min = parseRepeatCount(regex, index, min_count_out);
+		if (!has_min) {
+			min_count_out = 0;
+		}
+
+		if (index < regex.size() && regex[index] == ',') {
+			index++;
+			if (!parseRepeatCount(regex, index, max_count_out)) {
+				max_count_out = Repeat::no_max_count;
+			}
+		} else {
+			max_count_out = min_count_out;
+		}
+
+		if (index >= regex.size() || regex[index] != '}' || (!has_min && max_count_out == Repeat::no_max_count)) {
+			index = start - 1;
+			return false;
+		}
+
+		if (min_count_out > max_count_out) {
+			error_out = "Minimum repeat count above maximum in " + regex.substr(start - 1, index - start + 2);
+		}
+		return true;
+	}
+}
+
+bool parseRegex(const std::string& regex, std::vector<std::unique_ptr<Atom>>& atoms_out, std::string& error_out, bool is_case_insensitive) {
+	// The groups that are open, innermost last, each with the branches (separated by |) parsed so far and whether it's case-insensitive. The first
+	// is the whole regex.
+	std::vector<std::vector<Branch>> groups(1);
+	std::vector<bool> are_case_insensitive { is_case_insensitive };
+	groups.back().emplace_back();
+
+	// Whether the last atom can be repeated, which anchors and repeats themselves can't
+	bool can_repeat = false;
+	bool follows_repeat = false;
+	for (size_t i = 0; i < regex.size(); i++) {
+		char c = regex[i];
+		if (c == '|' || c == '(' || c == ')') {
+			if (c == '|') {
+				groups.back().emplace_back();
+				can_repeat = false;
+			} else if (c == '(') {
+				if (groups.size() > max_group_depth) {
+					error_out = "Groups nested more than " + std::to_string(max_group_depth) + " deep";
+					return false;
+				}
+
+				// Groups don't capture anything, so (?:...) is the same as (...). (?i:...) is case-insensitive, and so is the whole regex after a
+				// leading (?i).
+				bool is_group_case_insensitive = are_case_insensitive.back();
+				if (regex.compare(i, 4, "(?i)") == 0) {
+					if (i != 0) {
+						error_out = "(?i) is only supported at the start of the regex, use (?i:...) for part of it";
+						return false;
+					}
+					are_case_insensitive.back() = true;
+					i += 3;
+					continue;
+				} else if (regex.compare(i, 4, "(?i:") == 0) {
+					is_group_case_insensitive = true;
+					i += 3;
+				} else if (i + 1 < regex.size() && regex[i + 1] == '?') {
+					if (i + 2 >= regex.size() || regex[i + 2] != ':') {
+						error_out = "Unknown group type (?";
+						return false;
+					}
+					i += 2;
+				}
+				groups.emplace_back(1);
+				are_case_insensitive.push_back(is_group_case_insensitive);
+				can_repeat = false;
+			} else {
+				if (groups.size() == 1) {
+					error_out = "Unmatched )";
+					return false;
+				}
+
+				std::vector<Branch> branches = std::move(groups.back());
+				groups.pop_back();
+				are_case_insensitive.pop_back();
+				groups.back().back().push_back(std::make_unique<Alternation>(std::move(branches)));
+				can_repeat = true;
+			}
+
+			follows_repeat = false;
+			continue;
+		}
+
+		Branch& atoms = groups.back().back();
+		uint32_t min_count = 0;
+		uint32_t max_count = 0;
+		bool is_repeat = true;
+		if (c == '*') {
+			max_count = Repeat::no_max_count;
+		} else if (c == '+') {
+			min_count = 1;
+			max_count = Repeat::no_max_count;
+		} else if (c == '?') {
+			max_count = 1;
+		} else if (c == '{') {
+			i++;
+			is_repeat = parseBraces(regex, i, min_count, max_count, error_out);
+			if (!error_out.empty()) {
+				return false;
+			}
+		} else {
+			is_repeat = false;
+		}
+
+		if (is_repeat) {
+			if (!can_repeat) {
+				error_out = follows_repeat ? "Multiple repeat" : std::string("Nothing to repeat before ") + c;
+				return false;
+			}
+
+			std::unique_ptr<Atom> atom = std::move(atoms.back());
+			atoms.back() = std::make_unique<Repeat>(std::move(atom), min_count, max_count);
+			can_repeat = false;
+			follows_repeat = true;
+			continue;
+		}
+
+		can_repeat = c != '^' && c != '$';
+		follows_repeat = false;
+		if (c == '^') {
+			atoms.push_back(std::make_unique<StringStartMetacharacter>());
+		} else if (c == '$') {
+			atoms.push_back(std::make_unique<StringEndMetacharacter>());
+		} else if (c == '.') {
+			// Like in Perl, . matches anything but a newline
+			ByteSet bytes;
+			bytes.set('\n');
+			atoms.push_back(std::make_unique<CharacterClass>(~bytes));
+		} else if (c == '[') {
+			i++;
+			ByteSet bytes;
+			if (!parseBracket(regex, i, are_case_insensitive.back(), bytes, error_out)) {
+				return false;
+			}
+			atoms.push_back(std::make_unique<CharacterClass>(bytes));
+		} else if (c == '\\') {
+			if (++i == regex.size()) {
+				error_out = "Trailing unescaped \\";
+				return false;
+			}
+
+			ByteSet bytes;
+			if (parseClassEscape(regex[i], bytes)) {
+				atoms.push_back(std::make_unique<CharacterClass>(bytes));
+			} else {
+				atoms.push_back(std::make_unique<Literal>(regex[i], are_case_insensitive.back()));
+			}
+		} else {
+			atoms.push_back(std::make_unique<Literal>(c, are_case_insensitive.back()));
+		}
+	}
+
+	if (groups.size() > 1) {
+		error_out = "Unmatched (";
+		return false;
+	}
+
+	// Alternatives at the top level are one atom, but otherwise the atoms are returned as they are
+	if (groups.back().size() > 1) {
+		atoms_out.push_back(std::make_unique<Alternation>(std::move(groups.back())));
+	} else {
+		atoms_out = std::move(groups.back().back());
+	}
+
+	// Checked before anything is built from them, since (x{100}){100} is small to parse but not to expand
+	// A repeat that can match nothing, like x{0}, expands to fewer states than it's written with
+	uint64_t expanded_size = getNfaSize(atoms_out, true);
+	uint64_t written_size = getNfaSize(atoms_out, false);
+	if (expanded_size > written_size && expanded_size - written_size > max_repeat_states) {
+		error_out = "Regex is too big once its repeats are expanded, they add more than " + std::to_string(max_repeat_states) + " NFA states";
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <vector>
+#include "Atom.h"
+
+// Parses a regex into the atoms that make it up. Returns false and sets error_out if the regex is invalid. If is_case_insensitive is set, letters
+// match in either case, like when the regex starts with (?i).
+bool parseRegex(const std::string& regex, std::vector<std::unique_ptr<Atom>>& atoms_out, std::string& error_out, bool is_case_insensitive=false);
@@ -0,0 +1,131 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Intrinsics.h>
+#include "Prefilter.h"
+#include "Summary.h"
+#include "Matcher.h"
+#include "VectorSearch.h"
+#include "TypeProvider.h"
+#include "ConstantProvider.h"
+
+namespace {
+	// Bytes that are common in text and logs, most common first. Anything else is assumed to be rarer than all of them.
+	const char* const common_bytes = " etaoinsrhldcumfpgwybvkxjqz0123456789\n.,-:/_=ETAOINSRHLDCUMFPGWYBVKXJQZ\"'()[]";
+}
+
+bool chooseRareByte(const ByteSet& required_bytes, const ByteSet& required_letters, uint8_t& byte_out, bool& is_letter_out) {
+	if (required_bytes.none() && required_letters.none()) {
+		return false;
+	}
+
+	size_t best_rank = 0;
+	for (int byte = 0; byte < 256; byte++) {
+		if (!required_bytes.test(byte) && !required_letters.test(byte)) {
+			continue;
+		}
+
+		const char* common = byte == 0 ? nullptr : std::strchr(common_bytes, byte);
+		size_t rank = common ? static_cast<size_t>(common - common_bytes) + 1 : std::strlen(common_bytes) + 1;
+		if (rank > best_rank) {
+			best_rank = rank;
+			byte_out = static_cast<uint8_t>(byte);
+			is_letter_out = !required_bytes.test(byte);
+		}
+	}
+
+	return true;
+}
+
+llvm::Function* buildPrefilteredScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const AtomSummary& summary, bool is_end_anchored, llvm::Function* scan_function) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	bool has_window = is_end_anchored && !summary.has_string_start && summary.max_length < unbounded_length;
+	uint8_t rare_byte;
+	bool is_rare_letter = false;
+	bool has_rare_byte = !has_window && chooseRareByte(summary.required_bytes, summary.required_letters, rare_byte, is_rare_letter);
+	if (summary.min_length == 0 && !has_window && !has_rare_byte) {
+		return scan_function;
+	}
+
+	llvm::Function* find_byte = nullptr;
+	if (has_rare_byte) {
+		llvm::IRBuilderBase::InsertPointGuard insert_point_guard(builder);
+		find_byte = is_rare_letter
+			? buildFindAnyByteFunction(context, builder, module, std::vector<uint8_t> { static_cast<uint8_t>(rare_byte & ~0x20), rare_byte })
+			: buildFindByteFunction(context, builder, module);
+	}
+
+	llvm::Function* prefiltered_scan_function = llvm::Function::Create(scan_function->getFunctionType(), llvm::Function::PrivateLinkage, "rx_scan_prefiltered", &module);
+	llvm::Value* buf = prefiltered_scan_function->args().begin();
+	llvm::Value* len = (prefiltered_scan_function->args().begin() + 1);
+	llvm::Value* state = (prefiltered_scan_function->args().begin() + 2);
+	llvm::Value* is_final = (prefiltered_scan_function->args().begin() + 3);
+	std::vector<llvm::Value*> scan_args;
+	for (llvm::Argument& arg : prefiltered_scan_function->args()) {
+		scan_args.push_back(&arg);
+	}
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", prefiltered_scan_function);
+	llvm::BasicBlock* resume = llvm::BasicBlock::Create(context, "resume", prefiltered_scan_function);
+	llvm::BasicBlock* whole_input = llvm::BasicBlock::Create(context, "whole_input", prefiltered_scan_function);
+	llvm::BasicBlock* failed = llvm::BasicBlock::Create(context, "failed", prefiltered_scan_function);
+
+	// Like the end anchored scan (see buildEndAnchoredScanFunction), only a scan from the initial state with the rest of the input can be ruled
+	// out by looking at the whole of it
+	builder.SetInsertPoint(entry);
+	builder.CreateCondBr(builder.CreateAnd(is_final, builder.CreateICmpEQ(state, constant_provider.getInt64(scan_initial_state))), whole_input, resume);
+
+	builder.SetInsertPoint(resume);
+	llvm::CallInst* result = builder.CreateCall(scan_function->getFunctionType(), scan_function, scan_args);
+	result->setTailCall();
+	builder.CreateRet(result);
+
+	builder.SetInsertPoint(failed);
+	builder.CreateRet(constant_provider.getInt64(scan_failed, true));
+
+	builder.SetInsertPoint(whole_input);
+	if (summary.min_length > 0) {
+		llvm::BasicBlock* long_enough = llvm::BasicBlock::Create(context, "long_enough", prefiltered_scan_function);
+		builder.CreateCondBr(builder.CreateICmpULT(len, constant_provider.getInt64(summary.min_length)), failed, long_enough);
+		builder.SetInsertPoint(long_enough);
+	}
+
+	if (has_window) {
+		// A match has to start within the last max_length bytes, or max_length + 1 if it's followed by a newline. Without a ^ it doesn't matter
+		// that the scan takes that as the start of the input.
+		llvm::Value* window = builder.CreateBinaryIntrinsic(llvm::Intrinsic::umin, len, constant_provider.getInt64(addLengths(summary.max_length, 1)));
+		llvm::Value* window_start = builder.CreateSub(len, window);
+		llvm::CallInst* window_result = builder.CreateCall(scan_function->getFunctionType(), scan_function, std::vector<llvm::Value*> {
+			builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { window_start }), window, state, is_final
+		});
+		window_result->setTailCall();
+		builder.CreateRet(window_result);
+		return prefiltered_scan_function;
+	}
+
+	if (has_rare_byte) {
+		// The search is much faster than a scan, so ruling out the input with it is worth the time it takes to find the byte when it's there
+		llvm::BasicBlock* has_byte = llvm::BasicBlock::Create(context, "has_byte", prefiltered_scan_function);
+		std::vector<llvm::Value*> find_args { buf, constant_provider.getInt64(0), len };
+		if (!is_rare_letter) {
+			find_args.push_back(constant_provider.getByte(rare_byte));
+		}
+		llvm::Value* found = builder.CreateCall(find_byte->getFunctionType(), find_byte, find_args);
+		builder.CreateCondBr(builder.CreateICmpEQ(found, len), failed, has_byte);
+		builder.SetInsertPoint(has_byte);
+	}
+
+	llvm::CallInst* whole_result = builder.CreateCall(scan_function->getFunctionType(), scan_function, scan_args);
+	whole_result->setTailCall();
+	builder.CreateRet(whole_result);
+
+	return prefiltered_scan_function;
+}
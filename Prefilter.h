@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include "Atom.h"
+
+// Returns the byte of required_bytes that's likely to be the rarest in the input (going by how common bytes are in text and logs), so that a search
+// for it is most likely to rule the input out. It can also be one of required_letters (which are lowercase, and can be in the input in either case),
+// which sets is_letter_out and is ranked by its lowercase byte. Returns false if both are empty.
+bool chooseRareByte(const ByteSet& required_bytes, const ByteSet& required_letters, uint8_t& byte_out, bool& is_letter_out);
+
+// Builds a scan function (see scan_function_name) that rules out inputs that can't match using summary (of the whole regex), when it's given all of
+// the input at once, before passing them on to scan_function:
+// - Inputs shorter than the shortest match fail straight away
+// - If the regex ends with $, has no ^ and its matches are at most some length, only that many bytes at the end of the input (and a newline after
+//   them) are scanned
+// - Otherwise inputs without one of the required bytes or letters (chosen by chooseRareByte) fail after a vector search for it
+// Returns scan_function itself if none of these apply.
+llvm::Function* buildPrefilteredScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const AtomSummary& summary, bool is_end_anchored, llvm::Function* scan_function);
@@ -0,0 +1,264 @@
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Intrinsics.h>
+#include "Records.h"
+#include "Matcher.h"
+#include "TypeProvider.h"
+#include "ConstantProvider.h"
+
+const uint32_t record_prefetch_distance = 16;
+
+namespace {
+	// Prefetches the start of the record at index, or the end of data if there aren't that many records. Prefetches never fault, so the address
+	// doesn't have to be checked any further.
+	void buildPrefetchRecord(TypeProvider& type_provider, llvm::IRBuilder<>& builder, llvm::Value* data, llvm::Value* offsets, llvm::Value* n, llvm::Value* index) {
+		ConstantProvider constant_provider(type_provider);
+
+		llvm::Value* prefetch_index = builder.CreateBinaryIntrinsic(llvm::Intrinsic::umin, index, n);
+		llvm::Value* prefetch_offset = builder.CreateLoad(type_provider.getInt32(), builder.CreateGEP(type_provider.getInt32(), offsets, std::vector<llvm::Value*> { prefetch_index }));
+		llvm::Value* prefetch_start = builder.CreateGEP(type_provider.getByte(), data, std::vector<llvm::Value*> { builder.CreateZExt(prefetch_offset, type_provider.getInt64()) });
+		// A read, kept in all levels of the cache, of data rather than instructions
+		builder.CreateIntrinsic(
+			llvm::Intrinsic::prefetch,
+			std::vector<llvm::Type*> { type_provider.getBytePtr() },
+			std::vector<llvm::Value*> { prefetch_start, constant_provider.getInt32(0), constant_provider.getInt32(3), constant_provider.getInt32(1) }
+		);
+	}
+
+	// Joins vectors of the same type into one, in order
+	llvm::Value* buildConcatVectors(llvm::IRBuilder<>& builder, std::vector<llvm::Value*> vectors) {
+		while (vectors.size() > 1) {
+			std::vector<llvm::Value*> joined;
+			for (size_t i = 0; i < vectors.size(); i += 2) {
+				unsigned num_elements = llvm::cast<llvm::FixedVectorType>(vectors[i]->getType())->getNumElements();
+				std::vector<int> mask;
+				for (unsigned j = 0; j < 2 * num_elements; j++) {
+					mask.push_back(static_cast<int>(j));
+				}
+				joined.push_back(builder.CreateShuffleVector(vectors[i], vectors[i + 1], mask));
+			}
+			vectors = joined;
+		}
+
+		return vectors[0];
+	}
+}
+
+bool getRecordPositions(const std::vector<std::unique_ptr<Atom>>& atoms, std::vector<ByteSet>& positions_out, bool& is_end_anchored_out) {
+	size_t first = 0;
+	while (first < atoms.size() && atoms[first]->is_string_start()) {
+		first++;
+	}
+	size_t last = atoms.size();
+	while (last > first && atoms[last - 1]->is_string_end()) {
+		last--;
+	}
+	if (first == 0) {
+		return false;
+	}
+
+	std::vector<ByteSet> positions;
+	for (size_t i = first; i < last; i++) {
+		if (!atoms[i]->get_positions(positions) || positions.size() > record_vector_bytes) {
+			return false;
+		}
+	}
+	bool is_end_anchored = last < atoms.size();
+	if (positions.empty() || positions.size() + is_end_anchored > record_vector_bytes) {
+		return false;
+	}
+
+	for (const ByteSet& bytes : positions) {
+		std::vector<std::pair<uint8_t, uint8_t>> ranges;
+		uint8_t case_bits;
+		if (bytes.none() || !getRunRanges(bytes, ranges, case_bits)) {
+			return false;
+		}
+	}
+
+	positions_out = positions;
+	is_end_anchored_out = is_end_anchored;
+	return true;
+}
+
+llvm::Function* buildMatchBatchFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* match_function, const std::vector<ByteSet>& positions, bool is_end_anchored, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	// Offsets are 32 bits to halve the memory they take, which limits a batch to 4 GiB of data
+	llvm::FunctionType* match_batch_type = llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt32Ptr(), type_provider.getInt64(), type_provider.getBytePtr() }, // data, offsets, n and results
+		false
+	);
+	llvm::Function* match_batch_function = llvm::Function::Create(match_batch_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, match_batch_function_suffix), &module);
+	llvm::Value* data = match_batch_function->args().begin();
+	llvm::Value* offsets = (match_batch_function->args().begin() + 1);
+	llvm::Value* n = (match_batch_function->args().begin() + 2);
+	llvm::Value* results = (match_batch_function->args().begin() + 3);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", match_batch_function);
+	llvm::BasicBlock* loop = llvm::BasicBlock::Create(context, "loop", match_batch_function);
+	llvm::BasicBlock* loop_body = llvm::BasicBlock::Create(context, "loop_body", match_batch_function);
+	llvm::BasicBlock* done = llvm::BasicBlock::Create(context, "done", match_batch_function);
+
+	builder.SetInsertPoint(entry);
+	llvm::BasicBlock* loop_entry = entry;
+	llvm::Value* loop_start_index = constant_provider.getInt64(0);
+	llvm::Value* loop_start_count = constant_provider.getInt64(0);
+	if (!positions.empty()) {
+		llvm::BasicBlock* vector_loop = llvm::BasicBlock::Create(context, "vector_loop", match_batch_function);
+		llvm::BasicBlock* vector_check_room = llvm::BasicBlock::Create(context, "vector_check_room", match_batch_function);
+		llvm::BasicBlock* vector_loop_body = llvm::BasicBlock::Create(context, "vector_loop_body", match_batch_function);
+		llvm::BasicBlock* vector_done = llvm::BasicBlock::Create(context, "vector_done", match_batch_function);
+
+		// Loading record_vector_bytes from the start of a record can read into the records after it, but not past the end of data. Offsets only go
+		// up, so once the last record of a group is too close to the end, so are all the others.
+		llvm::Value* data_len = builder.CreateZExt(
+			builder.CreateLoad(type_provider.getInt32(), builder.CreateGEP(type_provider.getInt32(), offsets, std::vector<llvm::Value*> { n })),
+			type_provider.getInt64()
+		);
+		builder.CreateBr(vector_loop);
+
+		builder.SetInsertPoint(vector_loop);
+		llvm::PHINode* vector_index = builder.CreatePHI(type_provider.getInt64(), 2);
+		llvm::PHINode* vector_count = builder.CreatePHI(type_provider.getInt64(), 2);
+		vector_index->addIncoming(constant_provider.getInt64(0), entry);
+		vector_count->addIncoming(constant_provider.getInt64(0), entry);
+		llvm::Value* next_vector_index = builder.CreateAdd(vector_index, constant_provider.getInt64(records_per_vector));
+		builder.CreateCondBr(builder.CreateICmpULE(next_vector_index, n), vector_check_room, vector_done);
+
+		builder.SetInsertPoint(vector_check_room);
+		llvm::Value* last_offset = builder.CreateLoad(
+			type_provider.getInt32(),
+			builder.CreateGEP(type_provider.getInt32(), offsets, std::vector<llvm::Value*> { builder.CreateSub(next_vector_index, constant_provider.getInt64(1)) })
+		);
+		llvm::Value* last_load_end = builder.CreateAdd(builder.CreateZExt(last_offset, type_provider.getInt64()), constant_provider.getInt64(record_vector_bytes));
+		builder.CreateCondBr(builder.CreateICmpULE(last_load_end, data_len), vector_loop_body, vector_done);
+
+		builder.SetInsertPoint(vector_loop_body);
+		buildPrefetchRecord(type_provider, builder, data, offsets, n, builder.CreateAdd(vector_index, constant_provider.getInt64(record_prefetch_distance)));
+
+		// The lengths come from the group's offsets and those one after them
+		llvm::FixedVectorType* offsets_type = llvm::FixedVectorType::get(type_provider.getInt32(), records_per_vector);
+		llvm::Value* group_offsets = builder.CreateGEP(type_provider.getInt32(), offsets, std::vector<llvm::Value*> { vector_index });
+		llvm::Value* starts = builder.CreateAlignedLoad(offsets_type, builder.CreateBitCast(group_offsets, offsets_type->getPointerTo()), llvm::MaybeAlign(4));
+		llvm::Value* ends = builder.CreateAlignedLoad(
+			offsets_type,
+			builder.CreateBitCast(builder.CreateGEP(type_provider.getInt32(), group_offsets, std::vector<llvm::Value*> { constant_provider.getInt64(1) }), offsets_type->getPointerTo()),
+			llvm::MaybeAlign(4)
+		);
+		llvm::Value* lens = builder.CreateSub(ends, starts);
+
+		// Each record's bytes take record_vector_bytes lanes of one vector, and are compared against positions in a single run compare. Lanes past
+		// the last position match any byte, so that a record matches positions when all of its lanes match.
+		llvm::FixedVectorType* record_type = llvm::FixedVectorType::get(type_provider.getByte(), record_vector_bytes);
+		std::vector<llvm::Value*> record_bytes;
+		for (uint32_t i = 0; i < records_per_vector; i++) {
+			llvm::Value* start = builder.CreateZExt(builder.CreateExtractElement(starts, constant_provider.getInt32(i)), type_provider.getInt64());
+			llvm::Value* record = builder.CreateGEP(type_provider.getByte(), data, std::vector<llvm::Value*> { start });
+			record_bytes.push_back(builder.CreateAlignedLoad(record_type, builder.CreateBitCast(record, record_type->getPointerTo()), llvm::MaybeAlign(1)));
+		}
+		llvm::Value* group_bytes = buildConcatVectors(builder, record_bytes);
+
+		std::vector<std::vector<std::pair<uint8_t, uint8_t>>> group_ranges;
+		std::vector<uint8_t> group_case_bits;
+		for (uint32_t i = 0; i < records_per_vector; i++) {
+			for (uint32_t j = 0; j < record_vector_bytes; j++) {
+				std::vector<std::pair<uint8_t, uint8_t>> ranges { { 0, 255 } };
+				uint8_t case_bits = 0;
+				if (j < positions.size()) {
+					getRunRanges(positions[j], ranges, case_bits);
+				}
+				group_ranges.push_back(ranges);
+				group_case_bits.push_back(case_bits);
+			}
+		}
+
+		llvm::IntegerType* record_mask_type = llvm::IntegerType::get(context, record_vector_bytes);
+		llvm::FixedVectorType* group_masks_type = llvm::FixedVectorType::get(record_mask_type, records_per_vector);
+		llvm::Value* group_masks = builder.CreateBitCast(buildRunCompare(context, builder, group_bytes, group_ranges, group_case_bits), group_masks_type);
+		llvm::Value* is_matched = builder.CreateICmpEQ(group_masks, llvm::ConstantInt::getAllOnesValue(group_masks_type));
+
+		// Like $, the positions can end at the end of the record or before a newline that ends it, which is the byte after the last position
+		llvm::Value* num_positions = builder.CreateVectorSplat(records_per_vector, constant_provider.getInt32(static_cast<uint32_t>(positions.size())));
+		if (is_end_anchored) {
+			llvm::Value* newline_masks = builder.CreateBitCast(
+				builder.CreateICmpEQ(group_bytes, builder.CreateVectorSplat(records_per_vector * record_vector_bytes, constant_provider.getByte('\n'))),
+				group_masks_type
+			);
+			llvm::Value* has_newline = builder.CreateICmpNE(
+				builder.CreateAnd(newline_masks, llvm::ConstantInt::get(group_masks_type, uint64_t(1) << positions.size())),
+				llvm::ConstantInt::get(group_masks_type, 0)
+			);
+			llvm::Value* is_len_matched = builder.CreateOr(
+				builder.CreateICmpEQ(lens, num_positions),
+				builder.CreateAnd(builder.CreateICmpEQ(lens, builder.CreateAdd(num_positions, builder.CreateVectorSplat(records_per_vector, constant_provider.getInt32(1)))), has_newline)
+			);
+			is_matched = builder.CreateAnd(is_matched, is_len_matched);
+		} else {
+			is_matched = builder.CreateAnd(is_matched, builder.CreateICmpUGE(lens, num_positions));
+		}
+
+		llvm::FixedVectorType* group_results_type = llvm::FixedVectorType::get(type_provider.getByte(), records_per_vector);
+		llvm::Value* group_results = builder.CreateGEP(type_provider.getByte(), results, std::vector<llvm::Value*> { vector_index });
+		builder.CreateAlignedStore(builder.CreateZExt(is_matched, group_results_type), builder.CreateBitCast(group_results, group_results_type->getPointerTo()), llvm::MaybeAlign(1));
+		llvm::Value* num_matched = builder.CreateUnaryIntrinsic(llvm::Intrinsic::ctpop, builder.CreateBitCast(is_matched, llvm::IntegerType::get(context, records_per_vector)));
+		vector_index->addIncoming(next_vector_index, vector_loop_body);
+		vector_count->addIncoming(builder.CreateAdd(vector_count, builder.CreateZExt(num_matched, type_provider.getInt64())), vector_loop_body);
+		builder.CreateBr(vector_loop);
+
+		// The records that are left are matched one at a time
+		builder.SetInsertPoint(vector_done);
+		llvm::PHINode* remaining_index = builder.CreatePHI(type_provider.getInt64(), 2);
+		llvm::PHINode* remaining_count = builder.CreatePHI(type_provider.getInt64(), 2);
+		remaining_index->addIncoming(vector_index, vector_loop);
+		remaining_index->addIncoming(vector_index, vector_check_room);
+		remaining_count->addIncoming(vector_count, vector_loop);
+		remaining_count->addIncoming(vector_count, vector_check_room);
+		loop_entry = vector_done;
+		loop_start_index = remaining_index;
+		loop_start_count = remaining_count;
+	}
+	builder.CreateBr(loop);
+
+	builder.SetInsertPoint(loop);
+	llvm::PHINode* index = builder.CreatePHI(type_provider.getInt64(), 2);
+	llvm::PHINode* count = builder.CreatePHI(type_provider.getInt64(), 2);
+	index->addIncoming(loop_start_index, loop_entry);
+	count->addIncoming(loop_start_count, loop_entry);
+	builder.CreateCondBr(builder.CreateICmpULT(index, n), loop_body, done);
+
+	// The matcher is in the same module, so it can be inlined here and whatever it sets up before scanning hoisted out of the loop
+	builder.SetInsertPoint(loop_body);
+	buildPrefetchRecord(type_provider, builder, data, offsets, n, builder.CreateAdd(index, constant_provider.getInt64(record_prefetch_distance)));
+	llvm::Value* record_offset = builder.CreateGEP(type_provider.getInt32(), offsets, std::vector<llvm::Value*> { index });
+	llvm::Value* start = builder.CreateZExt(builder.CreateLoad(type_provider.getInt32(), record_offset), type_provider.getInt64());
+	llvm::Value* end = builder.CreateZExt(
+		builder.CreateLoad(type_provider.getInt32(), builder.CreateGEP(type_provider.getInt32(), record_offset, std::vector<llvm::Value*> { constant_provider.getInt64(1) })),
+		type_provider.getInt64()
+	);
+	llvm::Value* is_matched = builder.CreateCall(
+		match_function->getFunctionType(),
+		match_function,
+		std::vector<llvm::Value*> { builder.CreateGEP(type_provider.getByte(), data, std::vector<llvm::Value*> { start }), builder.CreateSub(end, start) }
+	);
+	builder.CreateStore(builder.CreateTrunc(is_matched, type_provider.getByte()), builder.CreateGEP(type_provider.getByte(), results, std::vector<llvm::Value*> { index }));
+	index->addIncoming(builder.CreateAdd(index, constant_provider.getInt64(1)), loop_body);
+	count->addIncoming(builder.CreateAdd(count, builder.CreateZExt(is_matched, type_provider.getInt64())), loop_body);
+	builder.CreateBr(loop);
+
+	builder.SetInsertPoint(done);
+	builder.CreateRet(count);
+
+	return match_batch_function;
+}
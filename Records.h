@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include "Atom.h"
+
+// Batches of short records (like log fields or keys) are usually stored back to back in one buffer, with an array of n + 1 offsets where record i is
+// data[offsets[i], offsets[i + 1]). The batch matcher loops over them in the generated code rather than being called for each of them, so the setup
+// of each match is hoisted out of the loop and the records ahead of it can be prefetched.
+
+// How many records ahead of the one being matched the batch matcher prefetches
+extern const uint32_t record_prefetch_distance;
+// Regexes that only look at the start of each record (see getRecordPositions) load its first record_vector_bytes bytes at once, and compare the
+// bytes of records_per_vector records with one vector compare
+const uint32_t record_vector_bytes = 16;
+const uint32_t records_per_vector = 4;
+
+// Returns whether atoms are ^ followed by a fixed sequence of classes (see getShiftOrPositions), with or without $ after them, that fit in
+// record_vector_bytes (along with the newline $ can match before) and can each be compared against a few ranges (see getRunRanges). If so, sets
+// positions_out to the classes and is_end_anchored_out to whether there's a $.
+bool getRecordPositions(const std::vector<std::unique_ptr<Atom>>& atoms, std::vector<ByteSet>& positions_out, bool& is_end_anchored_out);
+
+// Builds the batch matcher (see match_batch_function_suffix), which calls match_function for each record. If positions isn't empty (see
+// getRecordPositions), records are compared against them records_per_vector at a time instead, except for those near the end of data that
+// record_vector_bytes can't be loaded from.
+llvm::Function* buildMatchBatchFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* match_function, const std::vector<ByteSet>& positions, bool is_end_anchored, const std::string& symbol_prefix);
@@ -0,0 +1,79 @@
+#include <utility>
+#include "Repeat.h"
+#include "Nfa.h"
+#include "Summary.h"
+
+const uint32_t Repeat::no_max_count = UINT32_MAX;
+
+Repeat::Repeat(std::unique_ptr<Atom> atom, uint32_t min_count, uint32_t max_count)
+: atom{std::move(atom)}, min_count{min_count}, max_count{max_count}
+{ }
+
+void Repeat::add_to_nfa(Nfa& nfa, int32_t from, int32_t to) const {
+	// The required copies come first, one after another
+	int32_t current = from;
+	for (uint32_t i = 0; i < min_count; i++) {
+		int32_t next = nfa.addState();
+		atom->add_to_nfa(nfa, current, next);
+		current = next;
+	}
+
+	if (max_count == no_max_count) {
+		// The rest loop back on a state of their own, so that the DFA state for a run like \d+ leads back to itself
+		int32_t loop = nfa.addState();
+		nfa.addEpsilonTransition(current, loop, Assertion::None);
+		atom->add_to_nfa(nfa, loop, loop);
+		nfa.addEpsilonTransition(loop, to, Assertion::None);
+		return;
+	}
+
+	// Each optional copy can be skipped straight to the end. The state after each one is followed by the states of the copy that leads to it, and
+	// every copy is built the same way, so the states of one are at the same offsets as the states of the next.
+	int32_t first_optional = static_cast<int32_t>(nfa.getStates().size());
+	for (uint32_t i = min_count; i < max_count; i++) {
+		int32_t next = nfa.addState();
+		nfa.addEpsilonTransition(current, to, Assertion::None);
+		atom->add_to_nfa(nfa, current, next);
+		current = next;
+	}
+	nfa.addEpsilonTransition(current, to, Assertion::None);
+	if (max_count - min_count > 1) {
+		nfa.addOptionalCopies(first_optional, max_count - min_count);
+	}
+}
+
+uint64_t Repeat::get_nfa_size(bool expand_repeats) const {
+	// Each copy of the atom adds its own states and the one after it, and an unbounded repeat adds one more copy for its loop
+	uint64_t copy_size = addLengths(atom->get_nfa_size(expand_repeats), 1);
+	if (!expand_repeats) {
+		return copy_size;
+	} else if (max_count == no_max_count) {
+		return addLengths(multiplyLength(copy_size, min_count), copy_size);
+	}
+	return multiplyLength(copy_size, max_count);
+}
+
+bool Repeat::get_positions(std::vector<ByteSet>& positions_out) const {
+	// Only a fixed count like {4} matches a fixed number of bytes
+	std::vector<ByteSet> atom_positions;
+	if (min_count != max_count || !atom->get_positions(atom_positions)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < min_count; i++) {
+		positions_out.insert(positions_out.end(), atom_positions.begin(), atom_positions.end());
+	}
+	return true;
+}
+
+AtomSummary Repeat::get_summary() const {
+	AtomSummary atom_summary = atom->get_summary();
+	return AtomSummary {
+		multiplyLength(atom_summary.min_length, min_count),
+		max_count == no_max_count && atom_summary.max_length > 0 ? unbounded_length : multiplyLength(atom_summary.max_length, max_count),
+		min_count > 0 ? atom_summary.required_bytes : ByteSet(),
+		min_count > 0 ? atom_summary.required_letters : ByteSet(),
+		atom_summary.has_string_start,
+		atom_summary.has_string_end
+	};
+}
\ No newline at end of file
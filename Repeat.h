@@ -0,0 +1,23 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include "Atom.h"
+
+// Matches another atom between min_count and max_count times, e.g. a*, \d+, x? or [a-f]{2,4}
+class Repeat : public Atom {
+public:
+	// max_count is no_max_count for repeats without an upper bound, like * and +
+	Repeat(std::unique_ptr<Atom> atom, uint32_t min_count, uint32_t max_count);
+	void add_to_nfa(Nfa& nfa, int32_t from, int32_t to) const override;
+	AtomSummary get_summary() const override;
+	uint64_t get_nfa_size(bool expand_repeats) const override;
+	bool get_positions(std::vector<ByteSet>& positions_out) const override;
+
+	static const uint32_t no_max_count;
+
+private:
+	std::unique_ptr<Atom> atom;
+	uint32_t min_count;
+	uint32_t max_count;
+};
\ No newline at end of file
@@ -0,0 +1,539 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/ADT/Triple.h>
+#include <llvm/Support/Host.h>
+#include "Runtime.h"
+#include "Matcher.h"
+#include "TypeProvider.h"
+#include "ConstantProvider.h"
+
+llvm::Function* buildPanic(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	std::vector<llvm::Type*> puts_args_type(1, type_provider.getBytePtr());
+	llvm::FunctionType* puts_type = llvm::FunctionType::get(type_provider.getInt32(), llvm::ArrayRef(puts_args_type), false);
+	llvm::Function* existing_puts = module.getFunction("puts");
+	llvm::Function* puts_function = existing_puts
+		? existing_puts
+		: llvm::Function::Create(puts_type, llvm::Function::ExternalLinkage, "puts", &module);
+
+	llvm::FunctionType* exit_type = llvm::FunctionType::get(type_provider.getVoid(), std::vector<llvm::Type*> { type_provider.getInt32() }, false);
+	llvm::Function* existing_exit = module.getFunction("exit");
+	llvm::Function* exit_function = existing_exit
+		? existing_exit
+		: llvm::Function::Create(exit_type, llvm::Function::ExternalLinkage, "exit", &module);
+
+	llvm::FunctionType* panic_type = llvm::FunctionType::get(type_provider.getVoid(), llvm::ArrayRef(puts_args_type), false);
+	llvm::Function* existing_panic = module.getFunction("panic");
+	if (existing_panic) {
+		return existing_panic;
+	}
+
+	llvm::Function* panic = llvm::Function::Create(panic_type, llvm::Function::PrivateLinkage, "panic", &module);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", panic);
+	builder.SetInsertPoint(entry);
+	builder.CreateCall(puts_type, puts_function, std::vector<llvm::Value*> { (panic->args().begin()) });
+	builder.CreateCall(exit_type, exit_function, std::vector<llvm::Value*> { constant_provider.getInt32(127) });
+	builder.CreateUnreachable();
+
+	return panic;
+}
+
+llvm::Function* getExternalFunction(llvm::Module& module, const char* name, llvm::FunctionType* type) {
+	llvm::Function* existing = module.getFunction(name);
+	return existing
+		? existing
+		: llvm::Function::Create(type, llvm::Function::ExternalLinkage, name, module);
+}
+
+llvm::Function* getReadFunction(llvm::LLVMContext& context, llvm::Module& module) {
+	TypeProvider type_provider(context);
+
+	// ssize_t read(int fd, void* buf, size_t count), assuming a 64-bit target
+	return getExternalFunction(module, "read", llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> { type_provider.getInt32(), type_provider.getBytePtr(), type_provider.getInt64() },
+		false
+	));
+}
+
+llvm::Function* getPrintfFunction(llvm::LLVMContext& context, llvm::Module& module) {
+	TypeProvider type_provider(context);
+
+	return getExternalFunction(module, "printf", llvm::FunctionType::get(
+		type_provider.getInt32(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr() }, // format
+		true
+	));
+}
+
+void buildWriteStdout(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Value* buf, llvm::Value* len) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	// size_t fwrite(const void* buf, size_t size, size_t count, FILE* stream), with FILE* as an i8* since its contents are never used
+	llvm::Function* fwrite_function = getExternalFunction(module, "fwrite", llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getInt64(), type_provider.getBytePtr() },
+		false
+	));
+
+	// stdout is a variable in libc, which Darwin's names differently. The module's triple is only set when it's emitted, so this goes by the host's.
+	std::string triple = module.getTargetTriple().empty() ? llvm::sys::getDefaultTargetTriple() : module.getTargetTriple();
+	const char* stdout_name = llvm::Triple(triple).isOSDarwin() ? "__stdoutp" : "stdout";
+	llvm::Constant* stdout_variable = module.getOrInsertGlobal(stdout_name, type_provider.getBytePtr());
+	llvm::Value* stdout_stream = builder.CreateLoad(type_provider.getBytePtr(), stdout_variable);
+
+	builder.CreateCall(fwrite_function->getFunctionType(), fwrite_function, std::vector<llvm::Value*> { buf, constant_provider.getInt64(1), len, stdout_stream });
+}
+
+llvm::BasicBlock* buildStreamScan(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* function, llvm::Value* fd, llvm::Function* scan_function, const std::vector<llvm::Value*>& extra_scan_args, llvm::BasicBlock* matched_block, llvm::BasicBlock* not_matched_block, llvm::BasicBlock* failed_block) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::Function* read_function = getReadFunction(context, module);
+
+	// Allocate in the entry block so that scanning several streams from one function doesn't grow the stack
+	llvm::BasicBlock* function_entry = &function->getEntryBlock();
+	builder.SetInsertPoint(function_entry, function_entry->begin());
+	llvm::AllocaInst* buf = builder.CreateAlloca(type_provider.getByte(), constant_provider.getInt32(stream_block_size), "stream_buf");
+
+	llvm::BasicBlock* stream_entry = llvm::BasicBlock::Create(context, "stream_entry", function);
+	llvm::BasicBlock* read_loop = llvm::BasicBlock::Create(context, "read_loop", function);
+	llvm::BasicBlock* read_succeeded = llvm::BasicBlock::Create(context, "read_succeeded", function);
+	llvm::BasicBlock* scan_block = llvm::BasicBlock::Create(context, "scan_block", function);
+	llvm::BasicBlock* at_eof = llvm::BasicBlock::Create(context, "at_eof", function);
+
+	builder.SetInsertPoint(stream_entry);
+	builder.CreateBr(read_loop);
+
+	// The DFA's state is carried from one block to the next, so no input has to be kept around
+	builder.SetInsertPoint(read_loop);
+	llvm::PHINode* state = builder.CreatePHI(type_provider.getInt64(), 2);
+	state->addIncoming(constant_provider.getInt64(scan_initial_state), stream_entry);
+
+	llvm::Value* num_read = builder.CreateCall(
+		read_function->getFunctionType(),
+		read_function,
+		std::vector<llvm::Value*> { fd, buf, constant_provider.getInt64(stream_block_size) }
+	);
+	builder.CreateCondBr(builder.CreateICmpSLT(num_read, constant_provider.getInt64(0)), failed_block, read_succeeded);
+
+	builder.SetInsertPoint(read_succeeded);
+	builder.CreateCondBr(builder.CreateICmpEQ(num_read, constant_provider.getInt64(0)), at_eof, scan_block);
+
+	builder.SetInsertPoint(scan_block);
+	std::vector<llvm::Value*> scan_args { buf, num_read, state, constant_provider.getBit(0) };
+	scan_args.insert(scan_args.end(), extra_scan_args.begin(), extra_scan_args.end());
+	llvm::Value* next_state = builder.CreateCall(scan_function->getFunctionType(), scan_function, scan_args);
+	state->addIncoming(next_state, scan_block);
+	llvm::SwitchInst* scan_result = builder.CreateSwitch(next_state, read_loop, 2);
+	scan_result->addCase(constant_provider.getInt64(scan_matched, true), matched_block);
+	// e.g. an anchored pattern that has already failed, so there's no point reading the rest of the input
+	scan_result->addCase(constant_provider.getInt64(scan_failed, true), not_matched_block);
+
+	builder.SetInsertPoint(at_eof);
+	std::vector<llvm::Value*> final_scan_args { buf, constant_provider.getInt64(0), state, constant_provider.getBit(1) };
+	final_scan_args.insert(final_scan_args.end(), extra_scan_args.begin(), extra_scan_args.end());
+	llvm::Value* result = builder.CreateCall(scan_function->getFunctionType(), scan_function, final_scan_args);
+	builder.CreateCondBr(builder.CreateICmpEQ(result, constant_provider.getInt64(scan_matched, true)), matched_block, not_matched_block);
+
+	return stream_entry;
+}
+
+llvm::BasicBlock* buildMapFd(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* function, llvm::Value* fd, llvm::BasicBlock* fallback_block, llvm::BasicBlock*& mapped_out, llvm::Value*& mapping_out, llvm::Value*& mapping_size_out, llvm::Value*& buf_out, llvm::Value*& len_out) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	// The libc declarations below assume a 64-bit target, where off_t and size_t are both 64 bits
+	llvm::Function* lseek_function = getExternalFunction(module, "lseek", llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> { type_provider.getInt32(), type_provider.getInt64(), type_provider.getInt32() }, // fd, offset, and whence
+		false
+	));
+	llvm::Function* mmap_function = getExternalFunction(module, "mmap", llvm::FunctionType::get(
+		type_provider.getBytePtr(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getInt32(), type_provider.getInt32(), type_provider.getInt32(), type_provider.getInt64() }, // addr, len, prot, flags, fd, and offset
+		false
+	));
+	llvm::Function* madvise_function = getExternalFunction(module, "madvise", llvm::FunctionType::get(
+		type_provider.getInt32(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getInt32() }, // addr, len, and advice
+		false
+	));
+
+	const uint32_t seek_set = 0;
+	const uint32_t seek_cur = 1;
+	const uint32_t seek_end = 2;
+	const uint32_t prot_read = 1;
+	const uint32_t map_private = 2;
+	const uint32_t madv_sequential = 2;
+
+	llvm::BasicBlock* map_entry = llvm::BasicBlock::Create(context, "map_entry", function);
+	llvm::BasicBlock* check_size = llvm::BasicBlock::Create(context, "check_size", function);
+	llvm::BasicBlock* try_map = llvm::BasicBlock::Create(context, "try_map", function);
+	llvm::BasicBlock* map_failed = llvm::BasicBlock::Create(context, "map_failed", function);
+	mapped_out = llvm::BasicBlock::Create(context, "mapped", function);
+
+	// Anything we can't map (pipes, which can't seek, or empty or procfs files that report a size of 0) goes to the fallback instead. Whatever was
+	// read from fd before (e.g. by a shell builtin) is left out, so the whole file is mapped but only the part after the current offset is used.
+	builder.SetInsertPoint(map_entry);
+	llvm::Value* start = builder.CreateCall(lseek_function->getFunctionType(), lseek_function, std::vector<llvm::Value*> { fd, constant_provider.getInt64(0), constant_provider.getInt32(seek_cur) });
+	builder.CreateCondBr(builder.CreateICmpSGE(start, constant_provider.getInt64(0)), check_size, fallback_block);
+
+	builder.SetInsertPoint(check_size);
+	mapping_size_out = builder.CreateCall(lseek_function->getFunctionType(), lseek_function, std::vector<llvm::Value*> { fd, constant_provider.getInt64(0), constant_provider.getInt32(seek_end) });
+	builder.CreateCondBr(builder.CreateICmpSGT(mapping_size_out, start), try_map, map_failed);
+
+	builder.SetInsertPoint(try_map);
+	mapping_out = builder.CreateCall(
+		mmap_function->getFunctionType(),
+		mmap_function,
+		std::vector<llvm::Value*> {
+			llvm::ConstantPointerNull::get(type_provider.getBytePtr()),
+			mapping_size_out,
+			constant_provider.getInt32(prot_read),
+			constant_provider.getInt32(map_private),
+			fd,
+			constant_provider.getInt64(0)
+		}
+	);
+	llvm::Value* is_map_failed = builder.CreateICmpEQ(builder.CreatePtrToInt(mapping_out, type_provider.getInt64()), constant_provider.getInt64(-1, true));
+	builder.CreateCondBr(is_map_failed, map_failed, mapped_out);
+
+	builder.SetInsertPoint(map_failed);
+	builder.CreateCall(lseek_function->getFunctionType(), lseek_function, std::vector<llvm::Value*> { fd, start, constant_provider.getInt32(seek_set) });
+	builder.CreateBr(fallback_block);
+
+	builder.SetInsertPoint(mapped_out);
+	buf_out = builder.CreateGEP(type_provider.getByte(), mapping_out, std::vector<llvm::Value*> { start });
+	len_out = builder.CreateSub(mapping_size_out, start);
+	builder.CreateCall(madvise_function->getFunctionType(), madvise_function, std::vector<llvm::Value*> { mapping_out, mapping_size_out, constant_provider.getInt32(madv_sequential) });
+
+	return map_entry;
+}
+
+void buildUnmap(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Value* buf, llvm::Value* size) {
+	TypeProvider type_provider(context);
+
+	llvm::Function* munmap_function = getExternalFunction(module, "munmap", llvm::FunctionType::get(
+		type_provider.getInt32(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64() }, // addr and len
+		false
+	));
+	builder.CreateCall(munmap_function->getFunctionType(), munmap_function, std::vector<llvm::Value*> { buf, size });
+}
+
+llvm::BasicBlock* buildReadAll(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* function, llvm::Value* fd, llvm::BasicBlock* failed_block, llvm::BasicBlock*& read_out, llvm::Value*& buf_out, llvm::Value*& size_out) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::Function* read_function = getReadFunction(context, module);
+	llvm::Function* malloc_function = getExternalFunction(module, "malloc", llvm::FunctionType::get(
+		type_provider.getBytePtr(),
+		std::vector<llvm::Type*> { type_provider.getInt64() }, // size
+		false
+	));
+	llvm::Function* realloc_function = getExternalFunction(module, "realloc", llvm::FunctionType::get(
+		type_provider.getBytePtr(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64() }, // ptr and size
+		false
+	));
+
+	llvm::BasicBlock* read_entry = llvm::BasicBlock::Create(context, "read_entry", function);
+	llvm::BasicBlock* read_loop = llvm::BasicBlock::Create(context, "read_loop", function);
+	llvm::BasicBlock* read_block = llvm::BasicBlock::Create(context, "read_block", function);
+	llvm::BasicBlock* read_succeeded = llvm::BasicBlock::Create(context, "read_succeeded", function);
+	llvm::BasicBlock* read_more = llvm::BasicBlock::Create(context, "read_more", function);
+	llvm::BasicBlock* grow_buffer = llvm::BasicBlock::Create(context, "grow_buffer", function);
+	llvm::BasicBlock* buffer_grown = llvm::BasicBlock::Create(context, "buffer_grown", function);
+	llvm::BasicBlock* read_failed = llvm::BasicBlock::Create(context, "read_failed", function);
+	read_out = llvm::BasicBlock::Create(context, "read_all", function);
+
+	builder.SetInsertPoint(read_entry);
+	llvm::Value* initial_buf = builder.CreateCall(malloc_function->getFunctionType(), malloc_function, std::vector<llvm::Value*> { constant_provider.getInt64(stream_block_size) });
+	builder.CreateCondBr(builder.CreateIsNull(initial_buf), failed_block, read_loop);
+
+	builder.SetInsertPoint(read_loop);
+	llvm::PHINode* buf = builder.CreatePHI(type_provider.getBytePtr(), 3);
+	llvm::PHINode* capacity = builder.CreatePHI(type_provider.getInt64(), 3);
+	llvm::PHINode* fill = builder.CreatePHI(type_provider.getInt64(), 3);
+	buf->addIncoming(initial_buf, read_entry);
+	capacity->addIncoming(constant_provider.getInt64(stream_block_size), read_entry);
+	fill->addIncoming(constant_provider.getInt64(0), read_entry);
+	builder.CreateCondBr(builder.CreateICmpEQ(fill, capacity), grow_buffer, read_block);
+
+	builder.SetInsertPoint(read_block);
+	llvm::Value* num_read = builder.CreateCall(
+		read_function->getFunctionType(),
+		read_function,
+		std::vector<llvm::Value*> {
+			fd,
+			builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { fill }),
+			builder.CreateSub(capacity, fill)
+		}
+	);
+	builder.CreateCondBr(builder.CreateICmpSLT(num_read, constant_provider.getInt64(0)), read_failed, read_succeeded);
+
+	builder.SetInsertPoint(read_succeeded);
+	builder.CreateCondBr(builder.CreateICmpEQ(num_read, constant_provider.getInt64(0)), read_out, read_more);
+
+	builder.SetInsertPoint(read_more);
+	buf->addIncoming(buf, read_more);
+	capacity->addIncoming(capacity, read_more);
+	fill->addIncoming(builder.CreateAdd(fill, num_read), read_more);
+	builder.CreateBr(read_loop);
+
+	builder.SetInsertPoint(grow_buffer);
+	builder.CreateCondBr(builder.CreateICmpSGE(capacity, constant_provider.getInt64(max_read_size)), read_failed, buffer_grown);
+
+	builder.SetInsertPoint(buffer_grown);
+	llvm::Value* grown_capacity = builder.CreateMul(capacity, constant_provider.getInt64(2));
+	llvm::Value* grown_buf = builder.CreateCall(
+		realloc_function->getFunctionType(),
+		realloc_function,
+		std::vector<llvm::Value*> { buf, grown_capacity }
+	);
+	buf->addIncoming(grown_buf, buffer_grown);
+	capacity->addIncoming(grown_capacity, buffer_grown);
+	fill->addIncoming(fill, buffer_grown);
+	builder.CreateCondBr(builder.CreateIsNull(grown_buf), read_failed, read_loop);
+
+	// realloc leaves the old buffer alone when it fails
+	builder.SetInsertPoint(read_failed);
+	buildFree(context, builder, module, buf);
+	builder.CreateBr(failed_block);
+
+	builder.SetInsertPoint(read_out);
+	buf_out = buf;
+	size_out = fill;
+
+	return read_entry;
+}
+
+void buildFree(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Value* buf) {
+	TypeProvider type_provider(context);
+
+	llvm::Function* free_function = getExternalFunction(module, "free", llvm::FunctionType::get(
+		type_provider.getVoid(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr() }, // ptr
+		false
+	));
+	builder.CreateCall(free_function->getFunctionType(), free_function, std::vector<llvm::Value*> { buf });
+}
+
+llvm::Function* buildMatchFdFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* scan_function, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::FunctionType* match_fd_type = llvm::FunctionType::get(
+		type_provider.getInt32(),
+		std::vector<llvm::Type*> { type_provider.getInt32() }, // fd
+		false
+	);
+	llvm::Function* match_fd_function = llvm::Function::Create(match_fd_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, match_fd_function_suffix), &module);
+	llvm::Value* fd = match_fd_function->args().begin();
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", match_fd_function);
+	llvm::BasicBlock* matched = llvm::BasicBlock::Create(context, "matched", match_fd_function);
+	llvm::BasicBlock* not_matched = llvm::BasicBlock::Create(context, "not_matched", match_fd_function);
+	llvm::BasicBlock* read_failed = llvm::BasicBlock::Create(context, "read_failed", match_fd_function);
+
+	llvm::BasicBlock* scan_stream = buildStreamScan(context, builder, module, match_fd_function, fd, scan_function, std::vector<llvm::Value*> {}, matched, not_matched, read_failed);
+
+	llvm::BasicBlock* mapped;
+	llvm::Value* mapping;
+	llvm::Value* mapping_size;
+	llvm::Value* mapped_buf;
+	llvm::Value* mapped_len;
+	llvm::BasicBlock* map_fd = buildMapFd(context, builder, module, match_fd_function, fd, scan_stream, mapped, mapping, mapping_size, mapped_buf, mapped_len);
+
+	builder.SetInsertPoint(mapped);
+	llvm::Value* result = builder.CreateCall(
+		scan_function->getFunctionType(),
+		scan_function,
+		std::vector<llvm::Value*> { mapped_buf, mapped_len, constant_provider.getInt64(scan_initial_state), constant_provider.getBit(1) }
+	);
+	buildUnmap(context, builder, module, mapping, mapping_size);
+	builder.CreateCondBr(builder.CreateICmpEQ(result, constant_provider.getInt64(scan_matched, true)), matched, not_matched);
+
+	builder.SetInsertPoint(entry);
+	builder.CreateBr(map_fd);
+
+	builder.SetInsertPoint(matched);
+	builder.CreateRet(constant_provider.getInt32(1));
+
+	builder.SetInsertPoint(not_matched);
+	builder.CreateRet(constant_provider.getInt32(0));
+
+	builder.SetInsertPoint(read_failed);
+	builder.CreateRet(constant_provider.getInt32(-1, true));
+
+	return match_fd_function;
+}
+
+llvm::Value* buildOpen(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Value* path) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::Function* open_function = getExternalFunction(module, "open", llvm::FunctionType::get(
+		type_provider.getInt32(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt32() }, // path and flags
+		true
+	));
+
+	const uint32_t o_rdonly = 0;
+	return builder.CreateCall(open_function->getFunctionType(), open_function, std::vector<llvm::Value*> { path, constant_provider.getInt32(o_rdonly) });
+}
+
+void buildClose(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Value* fd) {
+	TypeProvider type_provider(context);
+
+	llvm::Function* close_function = getExternalFunction(module, "close", llvm::FunctionType::get(
+		type_provider.getInt32(),
+		std::vector<llvm::Type*> { type_provider.getInt32() }, // fd
+		false
+	));
+	builder.CreateCall(close_function->getFunctionType(), close_function, std::vector<llvm::Value*> { fd });
+}
+
+llvm::Function* buildMatchFileFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* match_fd_function, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::FunctionType* match_file_type = llvm::FunctionType::get(
+		type_provider.getInt32(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr() }, // path
+		false
+	);
+	llvm::Function* match_file_function = llvm::Function::Create(match_file_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, match_file_function_suffix), &module);
+	llvm::Value* path = match_file_function->args().begin();
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", match_file_function);
+	llvm::BasicBlock* opened = llvm::BasicBlock::Create(context, "opened", match_file_function);
+	llvm::BasicBlock* open_failed = llvm::BasicBlock::Create(context, "open_failed", match_file_function);
+
+	builder.SetInsertPoint(entry);
+	llvm::Value* fd = buildOpen(context, builder, module, path);
+	builder.CreateCondBr(builder.CreateICmpSLT(fd, constant_provider.getInt32(0)), open_failed, opened);
+
+	builder.SetInsertPoint(open_failed);
+	builder.CreateRet(constant_provider.getInt32(-1, true));
+
+	builder.SetInsertPoint(opened);
+	llvm::Value* result = builder.CreateCall(match_fd_function->getFunctionType(), match_fd_function, std::vector<llvm::Value*> { fd });
+	buildClose(context, builder, module, fd);
+	builder.CreateRet(result);
+
+	return match_file_function;
+}
+
+llvm::Function* buildMain(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* match_fd_function, llvm::Function* match_file_function) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::Function* puts_function = getExternalFunction(module, "puts", llvm::FunctionType::get(
+		type_provider.getInt32(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr() },
+		false
+	));
+
+	llvm::Function* main_function = createMainFunction(context, module);
+	llvm::Value* argc = main_function->args().begin();
+	llvm::Value* argv = (main_function->args().begin() + 1);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", main_function);
+	llvm::BasicBlock* scan_stdin = llvm::BasicBlock::Create(context, "scan_stdin", main_function);
+	llvm::BasicBlock* stdin_failed = llvm::BasicBlock::Create(context, "stdin_failed", main_function);
+	llvm::BasicBlock* matched = llvm::BasicBlock::Create(context, "matched", main_function);
+	llvm::BasicBlock* not_matched = llvm::BasicBlock::Create(context, "not_matched", main_function);
+	llvm::BasicBlock* file_loop = llvm::BasicBlock::Create(context, "file_loop", main_function);
+	llvm::BasicBlock* file_body = llvm::BasicBlock::Create(context, "file_body", main_function);
+	llvm::BasicBlock* file_failed = llvm::BasicBlock::Create(context, "file_failed", main_function);
+	llvm::BasicBlock* file_matched = llvm::BasicBlock::Create(context, "file_matched", main_function);
+	llvm::BasicBlock* print_file = llvm::BasicBlock::Create(context, "print_file", main_function);
+	llvm::BasicBlock* next_file = llvm::BasicBlock::Create(context, "next_file", main_function);
+	llvm::BasicBlock* files_done = llvm::BasicBlock::Create(context, "files_done", main_function);
+
+	builder.SetInsertPoint(entry);
+	builder.CreateCondBr(builder.CreateICmpSLT(argc, constant_provider.getInt32(2)), scan_stdin, file_loop);
+
+	builder.SetInsertPoint(scan_stdin);
+	llvm::Value* stdin_result = builder.CreateCall(match_fd_function->getFunctionType(), match_fd_function, std::vector<llvm::Value*> { constant_provider.getInt32(0) });
+	llvm::BasicBlock* stdin_read = llvm::BasicBlock::Create(context, "stdin_read", main_function);
+	builder.CreateCondBr(builder.CreateICmpSLT(stdin_result, constant_provider.getInt32(0)), stdin_failed, stdin_read);
+
+	builder.SetInsertPoint(stdin_read);
+	builder.CreateCondBr(builder.CreateICmpNE(stdin_result, constant_provider.getInt32(0)), matched, not_matched);
+
+	// Each argument is a file to match, like grep -l we print the ones that match if there's more than one
+	builder.SetInsertPoint(file_loop);
+	llvm::PHINode* arg_index = builder.CreatePHI(type_provider.getInt32(), 2);
+	llvm::PHINode* any_matched = builder.CreatePHI(type_provider.getBit(), 2);
+	arg_index->addIncoming(constant_provider.getInt32(1), entry);
+	any_matched->addIncoming(constant_provider.getBit(0), entry);
+	builder.CreateCondBr(builder.CreateICmpSLT(arg_index, argc), file_body, files_done);
+
+	builder.SetInsertPoint(file_body);
+	llvm::Value* path = builder.CreateLoad(type_provider.getBytePtr(), builder.CreateGEP(type_provider.getBytePtr(), argv, std::vector<llvm::Value*> { arg_index }));
+	llvm::Value* file_result = builder.CreateCall(match_file_function->getFunctionType(), match_file_function, std::vector<llvm::Value*> { path });
+	llvm::BasicBlock* file_read = llvm::BasicBlock::Create(context, "file_read", main_function);
+	builder.CreateCondBr(builder.CreateICmpSLT(file_result, constant_provider.getInt32(0)), file_failed, file_read);
+
+	builder.SetInsertPoint(file_read);
+	llvm::Value* file_is_match = builder.CreateICmpNE(file_result, constant_provider.getInt32(0));
+	builder.CreateCondBr(file_is_match, file_matched, next_file);
+
+	builder.SetInsertPoint(file_matched);
+	builder.CreateCondBr(builder.CreateICmpSGT(argc, constant_provider.getInt32(2)), print_file, next_file);
+
+	builder.SetInsertPoint(print_file);
+	builder.CreateCall(puts_function->getFunctionType(), puts_function, std::vector<llvm::Value*> { path });
+	builder.CreateBr(next_file);
+
+	builder.SetInsertPoint(next_file);
+	llvm::PHINode* next_any_matched = builder.CreatePHI(type_provider.getBit(), 3);
+	next_any_matched->addIncoming(constant_provider.getBit(0), file_read);
+	next_any_matched->addIncoming(constant_provider.getBit(1), file_matched);
+	next_any_matched->addIncoming(constant_provider.getBit(1), print_file);
+	arg_index->addIncoming(builder.CreateAdd(arg_index, constant_provider.getInt32(1)), next_file);
+	any_matched->addIncoming(builder.CreateOr(any_matched, next_any_matched), next_file);
+	builder.CreateBr(file_loop);
+
+	builder.SetInsertPoint(files_done);
+	builder.CreateCondBr(any_matched, matched, not_matched);
+
+	llvm::Function* panic = buildPanic(context, builder, module);
+	builder.SetInsertPoint(stdin_failed);
+	builder.CreateCall(panic->getFunctionType(), panic, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("Error: Could not read input.") });
+	builder.CreateUnreachable();
+
+	builder.SetInsertPoint(file_failed);
+	builder.CreateCall(panic->getFunctionType(), panic, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("Error: Could not read input file.") });
+	builder.CreateUnreachable();
+
+	builder.SetInsertPoint(matched);
+	builder.CreateRet(constant_provider.getInt32(0));
+
+	builder.SetInsertPoint(not_matched);
+	builder.CreateRet(constant_provider.getInt32(1));
+
+	return main_function;
+}
+
+llvm::Function* createMainFunction(llvm::LLVMContext& context, llvm::Module& module) {
+	TypeProvider type_provider(context);
+
+	llvm::PointerType* argv_type = type_provider.getBytePtr()->getPointerTo();
+	llvm::FunctionType* main_type = llvm::FunctionType::get(type_provider.getInt32(), std::vector<llvm::Type*> { type_provider.getInt32(), argv_type }, false);
+	return llvm::Function::Create(main_type, llvm::Function::ExternalLinkage, "main", &module);
+}
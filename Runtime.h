@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Instructions.h>
+
+// How many bytes the generated code asks read() for at a time
+const int32_t stream_block_size = 1 << 16;
+
+llvm::Function* buildPanic(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module);
+
+// Returns the declaration of an external (e.g. libc) function, declaring it if it isn't already
+llvm::Function* getExternalFunction(llvm::Module& module, const char* name, llvm::FunctionType* type);
+llvm::Function* getReadFunction(llvm::LLVMContext& context, llvm::Module& module);
+llvm::Function* getPrintfFunction(llvm::LLVMContext& context, llvm::Module& module);
+// Writes len bytes of buf to stdout, through the same buffer as printf so that the two can be mixed. Unlike printing with %.*s, this writes NUL
+// bytes too.
+void buildWriteStdout(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Value* buf, llvm::Value* len);
+
+// Builds a loop into function that reads fd in blocks of stream_block_size and branches to matched_block or not_matched_block, or failed_block if
+// reading fails. extra_scan_args are passed to scan_function after its usual arguments.
+// The DFA's state is carried from one block to the next, so memory use is bounded by the block size regardless of how large the input is.
+// Returns the block to branch to in order to start scanning.
+llvm::BasicBlock* buildStreamScan(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* function, llvm::Value* fd, llvm::Function* scan_function, const std::vector<llvm::Value*>& extra_scan_args, llvm::BasicBlock* matched_block, llvm::BasicBlock* not_matched_block, llvm::BasicBlock* failed_block);
+
+// Builds code into function that memory maps the whole of fd, and returns the block to branch to in order to start.
+// On success it continues in mapped_out (which the caller must terminate) with buf_out and len_out set to the rest of fd from its current offset (like
+// reading it would give), and the caller must then call buildUnmap with mapping_out and mapping_size_out.
+// If fd can't be mapped or has nothing left to read, it seeks back to where it was and branches to fallback_block, so that the caller can read it instead.
+llvm::BasicBlock* buildMapFd(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* function, llvm::Value* fd, llvm::BasicBlock* fallback_block, llvm::BasicBlock*& mapped_out, llvm::Value*& mapping_out, llvm::Value*& mapping_size_out, llvm::Value*& buf_out, llvm::Value*& len_out);
+void buildUnmap(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Value* buf, llvm::Value* size);
+
+// Builds code into function that reads the whole of fd into a buffer from malloc, for input that can't be mapped, and returns the block to branch to
+// in order to start. On success it continues in read_out (which the caller must terminate) with buf_out and size_out (an i64) set, and the caller
+// must then call buildFree. It branches to failed_block if reading fails or the input is larger than max_read_size.
+llvm::BasicBlock* buildReadAll(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* function, llvm::Value* fd, llvm::BasicBlock* failed_block, llvm::BasicBlock*& read_out, llvm::Value*& buf_out, llvm::Value*& size_out);
+void buildFree(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Value* buf);
+// The buffer that buildReadAll reads into doubles in size from stream_block_size up to this
+const int64_t max_read_size = int64_t(1) << 40;
+
+// Returns the fd, or a negative number if path couldn't be opened
+llvm::Value* buildOpen(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Value* path);
+void buildClose(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Value* fd);
+
+// Builds the function named by match_fd_function_suffix, which maps fd and matches it in place, or reads it in blocks if it can't be mapped
+llvm::Function* buildMatchFdFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* scan_function, const std::string& symbol_prefix);
+// Builds the function named by match_file_function_suffix, which opens the file at path and passes it to match_fd_function
+llvm::Function* buildMatchFileFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* match_fd_function, const std::string& symbol_prefix);
+
+// Builds a main function that matches each file given as an argument, or stdin if there are none, and returns 0 if any of them match or 1 otherwise
+llvm::Function* buildMain(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* match_fd_function, llvm::Function* match_file_function);
+// Declares an empty i32 main(i32 argc, i8** argv)
+llvm::Function* createMainFunction(llvm::LLVMContext& context, llvm::Module& module);
@@ -0,0 +1,397 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Intrinsics.h>
+#include "Sets.h"
+#include "Matcher.h"
+#include "Runtime.h"
+#include "TypeProvider.h"
+#include "ConstantProvider.h"
+
+namespace {
+	// The state the grouped scan returns while any group still needs more input
+	const int64_t grouped_scan_resume_state = 1;
+
+	uint32_t getNumWords(uint32_t num_patterns) {
+		return (num_patterns + 63) / 64;
+	}
+
+	void buildClearMatched(TypeProvider& type_provider, llvm::IRBuilder<>& builder, llvm::Value* matched, uint32_t num_patterns) {
+		ConstantProvider constant_provider(type_provider);
+
+		for (uint32_t word = 0; word < getNumWords(num_patterns); word++) {
+			builder.CreateStore(constant_provider.getInt64(0), builder.CreateGEP(type_provider.getInt64(), matched, std::vector<llvm::Value*> { constant_provider.getInt32(word) }));
+		}
+	}
+
+	llvm::Value* buildCountMatched(TypeProvider& type_provider, llvm::IRBuilder<>& builder, llvm::Value* matched, uint32_t num_patterns) {
+		ConstantProvider constant_provider(type_provider);
+
+		llvm::Value* count = constant_provider.getInt64(0);
+		for (uint32_t word = 0; word < getNumWords(num_patterns); word++) {
+			llvm::Value* bits = builder.CreateLoad(type_provider.getInt64(), builder.CreateGEP(type_provider.getInt64(), matched, std::vector<llvm::Value*> { constant_provider.getInt32(word) }));
+			count = builder.CreateAdd(count, builder.CreateUnaryIntrinsic(llvm::Intrinsic::ctpop, bits));
+		}
+
+		return builder.CreateTrunc(count, type_provider.getInt32());
+	}
+
+	// Builds a private function with the signature void (i64* matched, i8* name), which prints the number of each pattern set in matched, prefixed
+	// with name if it isn't null
+	llvm::Function* buildPrintMatchedFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, uint32_t num_patterns) {
+		TypeProvider type_provider(context);
+		ConstantProvider constant_provider(type_provider);
+
+		llvm::Function* printf_function = getPrintfFunction(context, module);
+
+		llvm::FunctionType* print_type = llvm::FunctionType::get(
+			type_provider.getVoid(),
+			std::vector<llvm::Type*> { type_provider.getInt64Ptr(), type_provider.getBytePtr() }, // matched and name
+			false
+		);
+		llvm::Function* print_function = llvm::Function::Create(print_type, llvm::Function::PrivateLinkage, "rx_print_matched", &module);
+		llvm::Value* matched = print_function->args().begin();
+		llvm::Value* name = (print_function->args().begin() + 1);
+
+		llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", print_function);
+		llvm::BasicBlock* pattern_loop = llvm::BasicBlock::Create(context, "pattern_loop", print_function);
+		llvm::BasicBlock* pattern_body = llvm::BasicBlock::Create(context, "pattern_body", print_function);
+		llvm::BasicBlock* print_pattern = llvm::BasicBlock::Create(context, "print_pattern", print_function);
+		llvm::BasicBlock* print_unnamed = llvm::BasicBlock::Create(context, "print_unnamed", print_function);
+		llvm::BasicBlock* print_named = llvm::BasicBlock::Create(context, "print_named", print_function);
+		llvm::BasicBlock* next_pattern = llvm::BasicBlock::Create(context, "next_pattern", print_function);
+		llvm::BasicBlock* done = llvm::BasicBlock::Create(context, "done", print_function);
+
+		builder.SetInsertPoint(entry);
+		builder.CreateBr(pattern_loop);
+
+		builder.SetInsertPoint(pattern_loop);
+		llvm::PHINode* pattern = builder.CreatePHI(type_provider.getInt32(), 2);
+		pattern->addIncoming(constant_provider.getInt32(0), entry);
+		builder.CreateCondBr(builder.CreateICmpULT(pattern, constant_provider.getInt32(num_patterns)), pattern_body, done);
+
+		builder.SetInsertPoint(pattern_body);
+		llvm::Value* word = builder.CreateLoad(
+			type_provider.getInt64(),
+			builder.CreateGEP(type_provider.getInt64(), matched, std::vector<llvm::Value*> { builder.CreateLShr(pattern, constant_provider.getInt32(6)) })
+		);
+		llvm::Value* bit = builder.CreateAnd(builder.CreateLShr(word, builder.CreateZExt(builder.CreateAnd(pattern, constant_provider.getInt32(63)), type_provider.getInt64())), constant_provider.getInt64(1));
+		builder.CreateCondBr(builder.CreateICmpNE(bit, constant_provider.getInt64(0)), print_pattern, next_pattern);
+
+		builder.SetInsertPoint(print_pattern);
+		llvm::Value* pattern_number = builder.CreateAdd(pattern, constant_provider.getInt32(1));
+		builder.CreateCondBr(builder.CreateIsNull(name), print_unnamed, print_named);
+
+		builder.SetInsertPoint(print_unnamed);
+		builder.CreateCall(printf_function->getFunctionType(), printf_function, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("%u\n"), pattern_number });
+		builder.CreateBr(next_pattern);
+
+		builder.SetInsertPoint(print_named);
+		builder.CreateCall(printf_function->getFunctionType(), printf_function, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("%s:%u\n"), name, pattern_number });
+		builder.CreateBr(next_pattern);
+
+		builder.SetInsertPoint(next_pattern);
+		pattern->addIncoming(builder.CreateAdd(pattern, constant_provider.getInt32(1)), next_pattern);
+		builder.CreateBr(pattern_loop);
+
+		builder.SetInsertPoint(done);
+		builder.CreateRetVoid();
+
+		return print_function;
+	}
+}
+
+llvm::Function* buildGroupedScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const std::vector<llvm::Function*>& group_scan_functions) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::FunctionType* grouped_scan_type = llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> {
+			type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getInt64(), type_provider.getBit(), type_provider.getInt64Ptr(), type_provider.getInt64Ptr()
+		}, // buf, len, state, is final, group states, and matched
+		false
+	);
+	llvm::Function* grouped_scan_function = llvm::Function::Create(grouped_scan_type, llvm::Function::PrivateLinkage, "rx_scan_groups", &module);
+	llvm::Value* buf = grouped_scan_function->args().begin();
+	llvm::Value* len = (grouped_scan_function->args().begin() + 1);
+	llvm::Value* state = (grouped_scan_function->args().begin() + 2);
+	llvm::Value* is_final = (grouped_scan_function->args().begin() + 3);
+	llvm::Value* group_states = (grouped_scan_function->args().begin() + 4);
+	llvm::Value* matched = (grouped_scan_function->args().begin() + 5);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", grouped_scan_function);
+	llvm::BasicBlock* start = llvm::BasicBlock::Create(context, "start", grouped_scan_function);
+	std::vector<llvm::BasicBlock*> group_blocks;
+	for (size_t i = 0; i <= group_scan_functions.size(); i++) {
+		group_blocks.push_back(llvm::BasicBlock::Create(context, i < group_scan_functions.size() ? "group_" + std::to_string(i) : "groups_done", grouped_scan_function));
+	}
+
+	std::vector<llvm::Value*> group_state_ptrs;
+	builder.SetInsertPoint(entry);
+	for (size_t i = 0; i < group_scan_functions.size(); i++) {
+		group_state_ptrs.push_back(builder.CreateGEP(type_provider.getInt64(), group_states, std::vector<llvm::Value*> { constant_provider.getInt32(static_cast<uint32_t>(i)) }));
+	}
+	builder.CreateCondBr(builder.CreateICmpEQ(state, constant_provider.getInt64(scan_initial_state)), start, group_blocks[0]);
+
+	builder.SetInsertPoint(start);
+	for (llvm::Value* group_state_ptr : group_state_ptrs) {
+		builder.CreateStore(constant_provider.getInt64(scan_initial_state), group_state_ptr);
+	}
+	builder.CreateBr(group_blocks[0]);
+
+	// Groups that are already done (e.g. all of their patterns have matched) are skipped. Each group's function is only called here, so the inliner
+	// would otherwise put every group into this one function, and the optimizer takes far longer on one huge function than on many smaller ones.
+	// A call per group per block costs nothing next to scanning the block.
+	for (size_t i = 0; i < group_scan_functions.size(); i++) {
+		if (group_scan_functions.size() > 1) {
+			group_scan_functions[i]->addFnAttr(llvm::Attribute::NoInline);
+		}
+
+		llvm::BasicBlock* run_group = llvm::BasicBlock::Create(context, "run_group_" + std::to_string(i), grouped_scan_function);
+
+		builder.SetInsertPoint(group_blocks[i]);
+		llvm::Value* group_state = builder.CreateLoad(type_provider.getInt64(), group_state_ptrs[i]);
+		builder.CreateCondBr(builder.CreateICmpSGE(group_state, constant_provider.getInt64(0)), run_group, group_blocks[i + 1]);
+
+		builder.SetInsertPoint(run_group);
+		llvm::Value* next_state = builder.CreateCall(
+			group_scan_functions[i]->getFunctionType(),
+			group_scan_functions[i],
+			std::vector<llvm::Value*> { buf, len, group_state, is_final, matched }
+		);
+		builder.CreateStore(next_state, group_state_ptrs[i]);
+		builder.CreateBr(group_blocks[i + 1]);
+	}
+
+	builder.SetInsertPoint(group_blocks.back());
+	llvm::Value* any_running = constant_provider.getBit(0);
+	for (llvm::Value* group_state_ptr : group_state_ptrs) {
+		any_running = builder.CreateOr(any_running, builder.CreateICmpSGE(builder.CreateLoad(type_provider.getInt64(), group_state_ptr), constant_provider.getInt64(0)));
+	}
+	builder.CreateRet(builder.CreateSelect(any_running, constant_provider.getInt64(grouped_scan_resume_state), constant_provider.getInt64(scan_failed, true)));
+
+	return grouped_scan_function;
+}
+
+llvm::Function* buildMatchSetFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* grouped_scan_function, uint32_t num_groups, uint32_t num_patterns, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::FunctionType* match_set_type = llvm::FunctionType::get(
+		type_provider.getInt32(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getInt64Ptr() }, // buf, len, and matched
+		false
+	);
+	llvm::Function* match_set_function = llvm::Function::Create(match_set_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, match_set_function_suffix), &module);
+	llvm::Value* buf = match_set_function->args().begin();
+	llvm::Value* len = (match_set_function->args().begin() + 1);
+	llvm::Value* matched = (match_set_function->args().begin() + 2);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", match_set_function);
+	llvm::BasicBlock* block_loop = llvm::BasicBlock::Create(context, "block_loop", match_set_function);
+	llvm::BasicBlock* next_block = llvm::BasicBlock::Create(context, "next_block", match_set_function);
+	llvm::BasicBlock* done = llvm::BasicBlock::Create(context, "done", match_set_function);
+
+	builder.SetInsertPoint(entry);
+	llvm::AllocaInst* group_states = builder.CreateAlloca(type_provider.getInt64(), constant_provider.getInt32(num_groups), "group_states");
+	buildClearMatched(type_provider, builder, matched, num_patterns);
+	builder.CreateBr(block_loop);
+
+	// Even a buffer that's already in memory is scanned in blocks, so that each one stays in the cache while every group scans it
+	builder.SetInsertPoint(block_loop);
+	llvm::PHINode* offset = builder.CreatePHI(type_provider.getInt64(), 2);
+	llvm::PHINode* state = builder.CreatePHI(type_provider.getInt64(), 2);
+	offset->addIncoming(constant_provider.getInt64(0), entry);
+	state->addIncoming(constant_provider.getInt64(scan_initial_state), entry);
+	llvm::Value* remaining = builder.CreateSub(len, offset);
+	llvm::Value* is_last = builder.CreateICmpULE(remaining, constant_provider.getInt64(stream_block_size));
+	llvm::Value* block_len = builder.CreateSelect(is_last, remaining, constant_provider.getInt64(stream_block_size));
+	llvm::Value* next_state = builder.CreateCall(
+		grouped_scan_function->getFunctionType(),
+		grouped_scan_function,
+		std::vector<llvm::Value*> { builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { offset }), block_len, state, is_last, group_states, matched }
+	);
+	builder.CreateCondBr(builder.CreateICmpSLT(next_state, constant_provider.getInt64(0)), done, next_block);
+
+	builder.SetInsertPoint(next_block);
+	offset->addIncoming(builder.CreateAdd(offset, block_len), next_block);
+	state->addIncoming(next_state, next_block);
+	builder.CreateBr(block_loop);
+
+	builder.SetInsertPoint(done);
+	builder.CreateRet(buildCountMatched(type_provider, builder, matched, num_patterns));
+
+	return match_set_function;
+}
+
+llvm::Function* buildMatchSetFdFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* grouped_scan_function, llvm::Function* match_set_function, uint32_t num_groups, uint32_t num_patterns, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::FunctionType* match_set_fd_type = llvm::FunctionType::get(
+		type_provider.getInt32(),
+		std::vector<llvm::Type*> { type_provider.getInt32(), type_provider.getInt64Ptr() }, // fd and matched
+		false
+	);
+	llvm::Function* match_set_fd_function = llvm::Function::Create(match_set_fd_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, match_set_fd_function_suffix), &module);
+	llvm::Value* fd = match_set_fd_function->args().begin();
+	llvm::Value* matched = (match_set_fd_function->args().begin() + 1);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", match_set_fd_function);
+	llvm::BasicBlock* read_stream = llvm::BasicBlock::Create(context, "read_stream", match_set_fd_function);
+	llvm::BasicBlock* done = llvm::BasicBlock::Create(context, "done", match_set_fd_function);
+	llvm::BasicBlock* read_failed = llvm::BasicBlock::Create(context, "read_failed", match_set_fd_function);
+
+	builder.SetInsertPoint(entry);
+	llvm::AllocaInst* group_states = builder.CreateAlloca(type_provider.getInt64(), constant_provider.getInt32(num_groups), "group_states");
+
+	// Either way the scan ends, the results are in matched
+	llvm::BasicBlock* scan_stream = buildStreamScan(
+		context, builder, module, match_set_fd_function, fd, grouped_scan_function, std::vector<llvm::Value*> { group_states, matched }, done, done, read_failed
+	);
+
+	llvm::BasicBlock* mapped;
+	llvm::Value* mapping;
+	llvm::Value* mapping_size;
+	llvm::Value* mapped_buf;
+	llvm::Value* mapped_len;
+	llvm::BasicBlock* map_fd = buildMapFd(context, builder, module, match_set_fd_function, fd, read_stream, mapped, mapping, mapping_size, mapped_buf, mapped_len);
+
+	builder.SetInsertPoint(mapped);
+	llvm::Value* result = builder.CreateCall(match_set_function->getFunctionType(), match_set_function, std::vector<llvm::Value*> { mapped_buf, mapped_len, matched });
+	buildUnmap(context, builder, module, mapping, mapping_size);
+	builder.CreateRet(result);
+
+	builder.SetInsertPoint(read_stream);
+	buildClearMatched(type_provider, builder, matched, num_patterns);
+	builder.CreateBr(scan_stream);
+
+	builder.SetInsertPoint(entry);
+	builder.CreateBr(map_fd);
+
+	builder.SetInsertPoint(done);
+	builder.CreateRet(buildCountMatched(type_provider, builder, matched, num_patterns));
+
+	builder.SetInsertPoint(read_failed);
+	builder.CreateRet(constant_provider.getInt32(-1, true));
+
+	return match_set_fd_function;
+}
+
+llvm::Function* buildMatchSetFileFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* match_set_fd_function, const std::string& symbol_prefix) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::FunctionType* match_set_file_type = llvm::FunctionType::get(
+		type_provider.getInt32(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64Ptr() }, // path and matched
+		false
+	);
+	llvm::Function* match_set_file_function = llvm::Function::Create(match_set_file_type, llvm::Function::ExternalLinkage, getSymbolName(symbol_prefix, match_set_file_function_suffix), &module);
+	llvm::Value* path = match_set_file_function->args().begin();
+	llvm::Value* matched = (match_set_file_function->args().begin() + 1);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", match_set_file_function);
+	llvm::BasicBlock* opened = llvm::BasicBlock::Create(context, "opened", match_set_file_function);
+	llvm::BasicBlock* open_failed = llvm::BasicBlock::Create(context, "open_failed", match_set_file_function);
+
+	builder.SetInsertPoint(entry);
+	llvm::Value* fd = buildOpen(context, builder, module, path);
+	builder.CreateCondBr(builder.CreateICmpSLT(fd, constant_provider.getInt32(0)), open_failed, opened);
+
+	builder.SetInsertPoint(open_failed);
+	builder.CreateRet(constant_provider.getInt32(-1, true));
+
+	builder.SetInsertPoint(opened);
+	llvm::Value* result = builder.CreateCall(match_set_fd_function->getFunctionType(), match_set_fd_function, std::vector<llvm::Value*> { fd, matched });
+	buildClose(context, builder, module, fd);
+	builder.CreateRet(result);
+
+	return match_set_file_function;
+}
+
+llvm::Function* buildSetMain(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* match_set_fd_function, llvm::Function* match_set_file_function, uint32_t num_patterns) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::Function* print_matched = buildPrintMatchedFunction(context, builder, module, num_patterns);
+
+	llvm::Function* main_function = createMainFunction(context, module);
+	llvm::Value* argc = main_function->args().begin();
+	llvm::Value* argv = (main_function->args().begin() + 1);
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", main_function);
+	llvm::BasicBlock* scan_stdin = llvm::BasicBlock::Create(context, "scan_stdin", main_function);
+	llvm::BasicBlock* stdin_read = llvm::BasicBlock::Create(context, "stdin_read", main_function);
+	llvm::BasicBlock* stdin_failed = llvm::BasicBlock::Create(context, "stdin_failed", main_function);
+	llvm::BasicBlock* file_loop = llvm::BasicBlock::Create(context, "file_loop", main_function);
+	llvm::BasicBlock* file_body = llvm::BasicBlock::Create(context, "file_body", main_function);
+	llvm::BasicBlock* file_read = llvm::BasicBlock::Create(context, "file_read", main_function);
+	llvm::BasicBlock* file_failed = llvm::BasicBlock::Create(context, "file_failed", main_function);
+	llvm::BasicBlock* files_done = llvm::BasicBlock::Create(context, "files_done", main_function);
+	llvm::BasicBlock* matched_block = llvm::BasicBlock::Create(context, "matched", main_function);
+	llvm::BasicBlock* not_matched = llvm::BasicBlock::Create(context, "not_matched", main_function);
+
+	builder.SetInsertPoint(entry);
+	llvm::AllocaInst* matched = builder.CreateAlloca(type_provider.getInt64(), constant_provider.getInt32(getNumWords(num_patterns)), "matched");
+	builder.CreateCondBr(builder.CreateICmpSLT(argc, constant_provider.getInt32(2)), scan_stdin, file_loop);
+
+	builder.SetInsertPoint(scan_stdin);
+	llvm::Value* stdin_count = builder.CreateCall(match_set_fd_function->getFunctionType(), match_set_fd_function, std::vector<llvm::Value*> { constant_provider.getInt32(0), matched });
+	builder.CreateCondBr(builder.CreateICmpSLT(stdin_count, constant_provider.getInt32(0)), stdin_failed, stdin_read);
+
+	builder.SetInsertPoint(stdin_read);
+	builder.CreateCall(print_matched->getFunctionType(), print_matched, std::vector<llvm::Value*> { matched, llvm::ConstantPointerNull::get(type_provider.getBytePtr()) });
+	builder.CreateCondBr(builder.CreateICmpSGT(stdin_count, constant_provider.getInt32(0)), matched_block, not_matched);
+
+	builder.SetInsertPoint(file_loop);
+	llvm::PHINode* arg_index = builder.CreatePHI(type_provider.getInt32(), 2);
+	llvm::PHINode* any_matched = builder.CreatePHI(type_provider.getBit(), 2);
+	arg_index->addIncoming(constant_provider.getInt32(1), entry);
+	any_matched->addIncoming(constant_provider.getBit(0), entry);
+	builder.CreateCondBr(builder.CreateICmpSLT(arg_index, argc), file_body, files_done);
+
+	builder.SetInsertPoint(file_body);
+	llvm::Value* path = builder.CreateLoad(type_provider.getBytePtr(), builder.CreateGEP(type_provider.getBytePtr(), argv, std::vector<llvm::Value*> { arg_index }));
+	llvm::Value* file_count = builder.CreateCall(match_set_file_function->getFunctionType(), match_set_file_function, std::vector<llvm::Value*> { path, matched });
+	builder.CreateCondBr(builder.CreateICmpSLT(file_count, constant_provider.getInt32(0)), file_failed, file_read);
+
+	// Like grep, output is prefixed with the path if there's more than one file
+	builder.SetInsertPoint(file_read);
+	llvm::Value* name = builder.CreateSelect(
+		builder.CreateICmpSGT(argc, constant_provider.getInt32(2)),
+		path,
+		llvm::ConstantPointerNull::get(type_provider.getBytePtr())
+	);
+	builder.CreateCall(print_matched->getFunctionType(), print_matched, std::vector<llvm::Value*> { matched, name });
+	arg_index->addIncoming(builder.CreateAdd(arg_index, constant_provider.getInt32(1)), file_read);
+	any_matched->addIncoming(builder.CreateOr(any_matched, builder.CreateICmpSGT(file_count, constant_provider.getInt32(0))), file_read);
+	builder.CreateBr(file_loop);
+
+	builder.SetInsertPoint(files_done);
+	builder.CreateCondBr(any_matched, matched_block, not_matched);
+
+	llvm::Function* panic = buildPanic(context, builder, module);
+	builder.SetInsertPoint(stdin_failed);
+	builder.CreateCall(panic->getFunctionType(), panic, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("Error: Could not read input.") });
+	builder.CreateUnreachable();
+
+	builder.SetInsertPoint(file_failed);
+	builder.CreateCall(panic->getFunctionType(), panic, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("Error: Could not read input file.") });
+	builder.CreateUnreachable();
+
+	builder.SetInsertPoint(matched_block);
+	builder.CreateRet(constant_provider.getInt32(0));
+
+	builder.SetInsertPoint(not_matched);
+	builder.CreateRet(constant_provider.getInt32(1));
+
+	return main_function;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+
+// Sets of patterns whose combined DFA would be too large are split into groups, each with a DFA of its own
+
+// Builds a private function with the signature i64 (i8* buf, i64 len, i64 state, i1 is_final, i64* group_states, i64* matched), which works like the
+// scan function (see scan_function_name) but runs each of group_scan_functions (built by buildSetScanFunction) over buf in turn, so that each
+// block of input is read once for the whole set while it's in the cache. group_states holds each group's state between calls, and is set up when
+// state is scan_initial_state. Returns scan_failed once every group is done, and otherwise a state to resume from.
+llvm::Function* buildGroupedScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const std::vector<llvm::Function*>& group_scan_functions);
+
+// Builds the function named by match_set_function_suffix, which scans buf in blocks of stream_block_size
+llvm::Function* buildMatchSetFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* grouped_scan_function, uint32_t num_groups, uint32_t num_patterns, const std::string& symbol_prefix);
+// Builds the function named by match_set_fd_function_suffix, which maps fd and passes it to match_set_function, or reads it in blocks if it can't
+// be mapped
+llvm::Function* buildMatchSetFdFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* grouped_scan_function, llvm::Function* match_set_function, uint32_t num_groups, uint32_t num_patterns, const std::string& symbol_prefix);
+// Builds the function named by match_set_file_function_suffix, which opens the file at path and passes it to match_set_fd_function
+llvm::Function* buildMatchSetFileFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* match_set_fd_function, const std::string& symbol_prefix);
+
+// Builds a main function that matches each file given as an argument (or stdin if there are none) against the set, and prints the number of each
+// pattern that matched (counting from 1, like the lines of a patterns file), prefixed with the path if there's more than one file. Returns 0 if any
+// pattern matched or 1 otherwise.
+llvm::Function* buildSetMain(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* match_set_fd_function, llvm::Function* match_set_file_function, uint32_t num_patterns);
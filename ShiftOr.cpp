@@ -0,0 +1,165 @@
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/GlobalVariable.h>
+#include "ShiftOr.h"
+#include "Matcher.h"
+#include "TypeProvider.h"
+#include "ConstantProvider.h"
+
+const size_t max_shift_or_positions = 64;
+const uint32_t shift_or_block_size = 16;
+
+bool getShiftOrPositions(const std::vector<std::unique_ptr<Atom>>& atoms, std::vector<ByteSet>& positions_out) {
+	std::vector<ByteSet> positions;
+	for (const std::unique_ptr<Atom>& atom : atoms) {
+		if (!atom->get_positions(positions) || positions.size() > max_shift_or_positions) {
+			return false;
+		}
+	}
+	if (positions.empty()) {
+		return false;
+	}
+
+	positions_out = positions;
+	return true;
+}
+
+llvm::GlobalVariable* buildShiftOrMasks(llvm::LLVMContext& context, llvm::Module& module, const std::vector<ByteSet>& positions) {
+	std::vector<uint64_t> masks(256, ~uint64_t(0));
+	for (size_t i = 0; i < positions.size(); i++) {
+		for (int byte = 0; byte < 256; byte++) {
+			if (positions[i].test(byte)) {
+				masks[byte] &= ~(uint64_t(1) << i);
+			}
+		}
+	}
+
+	llvm::Constant* masks_constant = llvm::ConstantDataArray::get(context, masks);
+	return new llvm::GlobalVariable(module, masks_constant->getType(), true, llvm::GlobalValue::PrivateLinkage, masks_constant, "rx_shift_or_masks");
+}
+
+llvm::Value* buildShiftOrStep(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::GlobalVariable* masks, llvm::Value* buf, llvm::Value* index, llvm::Value* word) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::Value* input = builder.CreateLoad(type_provider.getByte(), builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { index }));
+	llvm::Value* mask = builder.CreateLoad(
+		type_provider.getInt64(),
+		builder.CreateGEP(masks->getValueType(), masks, std::vector<llvm::Value*> { constant_provider.getInt32(0), builder.CreateZExt(input, type_provider.getInt32()) })
+	);
+	return builder.CreateOr(builder.CreateShl(word, constant_provider.getInt64(1)), mask);
+}
+
+llvm::Function* buildShiftOrScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const std::vector<ByteSet>& positions, bool has_byte_shuffle) {
+	TypeProvider type_provider(context);
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::FunctionType* scan_type = llvm::FunctionType::get(
+		type_provider.getInt64(),
+		std::vector<llvm::Type*> { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getInt64(), type_provider.getBit() }, // buf, len, state, and is final
+		false
+	);
+	llvm::Function* scan_function = llvm::Function::Create(scan_type, llvm::Function::PrivateLinkage, scan_function_name, &module);
+	llvm::Value* buf = scan_function->args().begin();
+	llvm::Value* input_len = (scan_function->args().begin() + 1);
+	llvm::Value* initial_state = (scan_function->args().begin() + 2);
+	llvm::Value* is_final = (scan_function->args().begin() + 3);
+
+	// The bits past the last position are always set, so that only the positions show up in the state
+	llvm::GlobalVariable* masks = buildShiftOrMasks(context, module, positions);
+	llvm::Value* last_position_bit = constant_provider.getInt64(uint64_t(1) << (positions.size() - 1));
+	llvm::Value* no_positions = constant_provider.getInt64(~uint64_t(0));
+
+	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", scan_function);
+	llvm::BasicBlock* loop = llvm::BasicBlock::Create(context, "loop", scan_function);
+	llvm::BasicBlock* check_end = llvm::BasicBlock::Create(context, "check_end", scan_function);
+	llvm::BasicBlock* check_block = llvm::BasicBlock::Create(context, "check_block", scan_function);
+	llvm::BasicBlock* block = llvm::BasicBlock::Create(context, "block", scan_function);
+	llvm::BasicBlock* step = llvm::BasicBlock::Create(context, "step", scan_function);
+	llvm::BasicBlock* matched = llvm::BasicBlock::Create(context, "matched", scan_function);
+	llvm::BasicBlock* input_end = llvm::BasicBlock::Create(context, "input_end", scan_function);
+
+	llvm::Function* find_first = buildFindExitFunction(context, builder, module, positions[0], has_byte_shuffle);
+
+	builder.SetInsertPoint(entry);
+	llvm::AllocaInst* search_credit = nullptr;
+	if (find_first) {
+		search_credit = builder.CreateAlloca(type_provider.getInt32(), nullptr, "search_credit");
+		builder.CreateStore(constant_provider.getInt32(max_search_credit), search_credit);
+	}
+	llvm::Value* entry_word = builder.CreateNot(initial_state);
+	builder.CreateBr(loop);
+
+	builder.SetInsertPoint(loop);
+	llvm::PHINode* index = builder.CreatePHI(type_provider.getInt64(), 3);
+	llvm::PHINode* word = builder.CreatePHI(type_provider.getInt64(), 3);
+	index->addIncoming(constant_provider.getInt64(0), entry);
+	word->addIncoming(entry_word, entry);
+
+	llvm::Value* input_index = index;
+	if (find_first) {
+		// With no positions clear, nothing can change until a byte of the first class, so that's searched for like the first byte of a DFA
+		llvm::BasicBlock* idle = llvm::BasicBlock::Create(context, "idle", scan_function);
+		llvm::BasicBlock* search = llvm::BasicBlock::Create(context, "search", scan_function);
+		builder.CreateCondBr(builder.CreateICmpEQ(word, no_positions), idle, check_end);
+
+		builder.SetInsertPoint(idle);
+		llvm::Value* credit = builder.CreateLoad(type_provider.getInt32(), search_credit);
+		builder.CreateCondBr(builder.CreateICmpSGT(credit, constant_provider.getInt32(0)), search, check_end);
+
+		builder.SetInsertPoint(search);
+		llvm::Value* found = builder.CreateCall(find_first->getFunctionType(), find_first, std::vector<llvm::Value*> { buf, index, input_len });
+		builder.CreateStore(buildNextSearchCredit(context, builder, credit, index, found), search_credit);
+		builder.CreateBr(check_end);
+
+		builder.SetInsertPoint(check_end);
+		llvm::PHINode* check_index = builder.CreatePHI(type_provider.getInt64(), 3);
+		check_index->addIncoming(index, loop);
+		check_index->addIncoming(index, idle);
+		check_index->addIncoming(found, search);
+		input_index = check_index;
+	} else {
+		builder.CreateBr(check_end);
+		builder.SetInsertPoint(check_end);
+	}
+	builder.CreateCondBr(builder.CreateICmpULT(input_index, input_len), check_block, input_end);
+
+	// Each byte is a shift, a table lookup and an OR, and there's a match once the last position's bit is clear after any of them. While there's
+	// room, blocks of bytes are read without branching and their words ANDed together, so that the match is checked once per block
+	builder.SetInsertPoint(check_block);
+	llvm::Value* block_end = builder.CreateAdd(input_index, constant_provider.getInt64(shift_or_block_size));
+	builder.CreateCondBr(builder.CreateICmpULE(block_end, input_len), block, step);
+
+	builder.SetInsertPoint(block);
+	llvm::Value* block_word = word;
+	llvm::Value* all_words = nullptr;
+	for (uint32_t i = 0; i < shift_or_block_size; i++) {
+		block_word = buildShiftOrStep(context, builder, masks, buf, builder.CreateAdd(input_index, constant_provider.getInt64(i)), block_word);
+		all_words = all_words ? builder.CreateAnd(all_words, block_word) : block_word;
+	}
+	index->addIncoming(block_end, block);
+	word->addIncoming(block_word, block);
+	builder.CreateCondBr(builder.CreateICmpEQ(builder.CreateAnd(all_words, last_position_bit), constant_provider.getInt64(0)), matched, loop);
+
+	builder.SetInsertPoint(step);
+	llvm::Value* next_word = buildShiftOrStep(context, builder, masks, buf, input_index, word);
+	index->addIncoming(builder.CreateAdd(input_index, constant_provider.getInt64(1)), step);
+	word->addIncoming(next_word, step);
+	builder.CreateCondBr(builder.CreateICmpEQ(builder.CreateAnd(next_word, last_position_bit), constant_provider.getInt64(0)), matched, loop);
+
+	builder.SetInsertPoint(matched);
+	builder.CreateRet(constant_provider.getInt64(scan_matched, true));
+
+	// The last position's bit is never clear here, so the complement fits in the non-negative states
+	builder.SetInsertPoint(input_end);
+	builder.CreateRet(builder.CreateSelect(is_final, constant_provider.getInt64(scan_failed, true), builder.CreateNot(word)));
+
+	return scan_function;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/GlobalVariable.h>
+#include "Atom.h"
+
+// Regexes that are a fixed sequence of classes (like abc or [0-9a-f]{8}) can be matched by Shift-Or instead of a DFA, as long as they're at most
+// this many bytes long, one for each bit of its state
+extern const size_t max_shift_or_positions;
+
+// Returns whether atoms are a fixed sequence of classes (see Atom::get_positions) that fits in max_shift_or_positions, and sets positions_out to
+// them if so
+bool getShiftOrPositions(const std::vector<std::unique_ptr<Atom>>& atoms, std::vector<ByteSet>& positions_out);
+
+// Builds a constant table of each byte's mask for positions, in which bit i is set if the byte isn't in the class at position i. The bits past the
+// last position are always set.
+llvm::GlobalVariable* buildShiftOrMasks(llvm::LLVMContext& context, llvm::Module& module, const std::vector<ByteSet>& positions);
+// Returns word after reading the byte at buf[index]: shifted along by one position and ORed with that byte's mask
+llvm::Value* buildShiftOrStep(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::GlobalVariable* masks, llvm::Value* buf, llvm::Value* index, llvm::Value* word);
+
+// Builds a scan function (see scan_function_name) that finds positions anywhere in its input with Shift-Or. Its state is a 64-bit word with a bit
+// for each position, which is clear while the input read so far ends with the classes up to that position. Each byte shifts the word along and ORs
+// in that byte's mask of the positions whose class doesn't hold it (from a table in the module), so every byte takes the same few instructions
+// whatever the input. While no position is clear it searches for the first class like a DFA state would (has_byte_shuffle enables PSHUFB for it).
+// The state it resumes from is the word's complement, so that it's scan_initial_state with no positions clear.
+llvm::Function* buildShiftOrScanFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const std::vector<ByteSet>& positions, bool has_byte_shuffle);
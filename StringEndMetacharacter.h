@@ -1,24 +1,10 @@
 #pragma once
 
-#include <string>
-#include <llvm/IR/Function.h>
-#include <llvm/IR/LLVMContext.h>
-#include <llvm/IR/IRBuilder.h>
-#include <llvm/IR/Module.h>
-#include <llvm/IR/Type.h>
-#include <llvm/IR/DerivedTypes.h>
 #include "Atom.h"
 
 class StringEndMetacharacter : public Atom {
 public:
-	StringEndMetacharacter(llvm::LLVMContext* context, llvm::Module* module, llvm::IRBuilder<>* builder);
-	llvm::Function* codegen() override;
-	llvm::FunctionType* get_generated_function_type() const;
-	std::string get_generated_function_name() const;
-
-private:
-	llvm::LLVMContext* context;
-	llvm::Module* module;
-	llvm::IRBuilder<>* builder;
-	llvm::FunctionType* generated_function_type;
+	void add_to_nfa(Nfa& nfa, int32_t from, int32_t to) const override;
+	AtomSummary get_summary() const override;
+	bool is_string_end() const override;
 };
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include "Summary.h"
+
+uint64_t addLengths(uint64_t a, uint64_t b) {
+	return a > unbounded_length - b ? unbounded_length : a + b;
+}
+
+uint64_t multiplyLength(uint64_t length, uint64_t count) {
+	if (length == 0 || count == 0) {
+		return 0;
+	}
+	return length > unbounded_length / count ? unbounded_length : length * count;
+}
+
+AtomSummary summarizeSequence(const std::vector<std::unique_ptr<Atom>>& atoms) {
+	AtomSummary summary { 0, 0, ByteSet(), ByteSet(), false, false };
+	for (const std::unique_ptr<Atom>& atom : atoms) {
+		AtomSummary atom_summary = atom->get_summary();
+		summary.min_length = addLengths(summary.min_length, atom_summary.min_length);
+		summary.max_length = addLengths(summary.max_length, atom_summary.max_length);
+		summary.required_bytes |= atom_summary.required_bytes;
+		summary.required_letters |= atom_summary.required_letters;
+		summary.has_string_start |= atom_summary.has_string_start;
+		summary.has_string_end |= atom_summary.has_string_end;
+	}
+	return summary;
+}
+
+ByteSet getRequiredLetters(const AtomSummary& summary) {
+	ByteSet letters = summary.required_letters;
+	for (int byte = 'A'; byte <= 'Z'; byte++) {
+		if (summary.required_bytes[byte] || summary.required_bytes[byte | 0x20]) {
+			letters.set(static_cast<uint8_t>(byte | 0x20));
+		}
+	}
+	return letters;
+}
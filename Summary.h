@@ -0,0 +1,16 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include "Atom.h"
+
+// Returns a + b and length * count, or unbounded_length if that's too long to track
+uint64_t addLengths(uint64_t a, uint64_t b);
+uint64_t multiplyLength(uint64_t length, uint64_t count);
+
+// Summarizes atoms matched one after another (see Atom::get_summary)
+AtomSummary summarizeSequence(const std::vector<std::unique_ptr<Atom>>& atoms);
+
+// Returns the letters that every match of summary has in either case, including the ones it has in a given case
+ByteSet getRequiredLetters(const AtomSummary& summary);
@@ -0,0 +1,70 @@
+#include <string>
+#include <memory>
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/Triple.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
+#include <llvm/MC/MCSubtargetInfo.h>
+#include <llvm/MC/SubtargetFeature.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Target/TargetOptions.h>
+#include "Target.h"
+#include "Optimizer.h"
+
+const char* const native_cpu_name = "native";
+
+std::unique_ptr<llvm::TargetMachine> createTargetMachine(const TargetSelection& selection, std::string& error_out) {
+	llvm::InitializeNativeTarget();
+	llvm::InitializeNativeTargetAsmPrinter();
+
+	llvm::Triple triple(llvm::sys::getDefaultTargetTriple());
+	const llvm::Target* target = llvm::TargetRegistry::lookupTarget(selection.arch, triple, error_out);
+	if (!target) {
+		return nullptr;
+	}
+
+	std::string cpu = selection.cpu.empty() ? "generic" : selection.cpu;
+	std::string features;
+	if (cpu == native_cpu_name) {
+		cpu = llvm::sys::getHostCPUName().str();
+
+		llvm::StringMap<bool> host_features;
+		llvm::SubtargetFeatures subtarget_features;
+		if (llvm::sys::getHostCPUFeatures(host_features)) {
+			for (auto& feature : host_features) {
+				subtarget_features.AddFeature(feature.first(), feature.second);
+			}
+		}
+		features = subtarget_features.getString();
+	}
+
+	llvm::TargetOptions target_options;
+	llvm::TargetMachine* target_machine = target->createTargetMachine(triple.str(), cpu, features, target_options, llvm::Reloc::PIC_, llvm::None, getCodeGenOptLevel(selection.opt_level));
+	if (!target_machine) {
+		error_out = "Could not create a target machine for " + triple.str();
+		return nullptr;
+	}
+
+	return std::unique_ptr<llvm::TargetMachine>(target_machine);
+}
+
+void setTargetAttributes(llvm::Module& module, llvm::TargetMachine& target_machine) {
+	for (llvm::Function& function : module) {
+		if (function.isDeclaration()) {
+			continue;
+		}
+
+		function.addFnAttr("target-cpu", target_machine.getTargetCPU());
+		if (!target_machine.getTargetFeatureString().empty()) {
+			function.addFnAttr("target-features", target_machine.getTargetFeatureString());
+		}
+	}
+}
+
+bool hasByteShuffle(const llvm::TargetMachine& target_machine) {
+	return target_machine.getTargetTriple().isX86() && target_machine.getMCSubtargetInfo()->checkFeatures("+ssse3");
+}
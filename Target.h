@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+
+// Which machine to generate code for
+struct TargetSelection {
+	// Architecture to look up the target by (like llc's -march), or empty for the host's
+	std::string arch;
+	// CPU to tune for and whose instructions may be used (like llc's -mcpu), "native" for the host CPU, or empty for a generic CPU
+	std::string cpu;
+	// See Optimizer.h
+	unsigned opt_level;
+};
+
+// Name of the CPU that's detected at compile time
+extern const char* const native_cpu_name;
+
+// Creates a target machine for the host triple that emits position independent code, so that objects built with it can be linked into any program on
+// this platform. Returns null and sets error_out on failure.
+std::unique_ptr<llvm::TargetMachine> createTargetMachine(const TargetSelection& selection, std::string& error_out);
+
+// Records target_machine's CPU and features on each function in module, so they're kept when the IR is compiled elsewhere (e.g. by clang)
+void setTargetAttributes(llvm::Module& module, llvm::TargetMachine& target_machine);
+
+// Whether target_machine can look up 16 bytes in a table at once (i.e. x86's PSHUFB), which character classes use to search for their bytes
+bool hasByteShuffle(const llvm::TargetMachine& target_machine);
@@ -0,0 +1,134 @@
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include "ThreadPool.h"
+
+namespace {
+	thread_local size_t current_worker = 0;
+}
+
+ThreadPool::ThreadPool(unsigned num_threads, llvm::Optional<unsigned> stack_size)
+: next_worker{0}, num_queued{0}, num_unfinished{0}, is_stopping{false}
+{
+	num_threads = std::max(num_threads, 1u);
+	for (unsigned i = 0; i < num_threads; i++) {
+		workers.push_back(std::make_unique<Worker>());
+	}
+
+	threads.reserve(num_threads);
+	for (unsigned i = 0; i < num_threads; i++) {
+		threads.emplace_back(stack_size, [this, i]() {
+			runWorker(i);
+		});
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(state_mutex);
+		is_stopping = true;
+	}
+	work_available.notify_all();
+
+	for (llvm::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+void ThreadPool::submit(Task task) {
+	// The task is queued while the counts are held, so a worker never sees it counted before it can be taken
+	{
+		std::lock_guard<std::mutex> lock(state_mutex);
+		Worker& worker = *workers[next_worker];
+		next_worker = (next_worker + 1) % workers.size();
+		{
+			std::lock_guard<std::mutex> worker_lock(worker.mutex);
+			worker.tasks.push_back(std::move(task));
+		}
+		num_queued++;
+		num_unfinished++;
+	}
+	// Whichever worker wakes up takes the task, stealing it if it isn't its own
+	work_available.notify_one();
+}
+
+void ThreadPool::wait() {
+	std::unique_lock<std::mutex> lock(state_mutex);
+	work_finished.wait(lock, [this]() {
+		return num_unfinished == 0;
+	});
+}
+
+unsigned ThreadPool::getNumThreads() const {
+	return static_cast<unsigned>(threads.size());
+}
+
+size_t ThreadPool::getCurrentWorker() {
+	return current_worker;
+}
+
+bool ThreadPool::takeTask(size_t worker, Task& task_out) {
+	bool is_taken = false;
+	{
+		std::lock_guard<std::mutex> lock(workers[worker]->mutex);
+		std::deque<Task>& tasks = workers[worker]->tasks;
+		if (!tasks.empty()) {
+			task_out = std::move(tasks.back());
+			tasks.pop_back();
+			is_taken = true;
+		}
+	}
+
+	// Start looking at the next worker along, so that thieves spread out instead of all emptying the first queue
+	for (size_t i = 1; !is_taken && i < workers.size(); i++) {
+		Worker& victim = *workers[(worker + i) % workers.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty()) {
+			task_out = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			is_taken = true;
+		}
+	}
+
+	if (is_taken) {
+		std::lock_guard<std::mutex> lock(state_mutex);
+		num_queued--;
+	}
+	return is_taken;
+}
+
+void ThreadPool::runWorker(size_t worker) {
+	current_worker = worker;
+	while (true) {
+		Task task;
+		if (takeTask(worker, task)) {
+			task();
+
+			std::lock_guard<std::mutex> lock(state_mutex);
+			if (--num_unfinished == 0) {
+				work_finished.notify_all();
+			}
+			continue;
+		}
+
+		// Another worker can take the last task between the queues being looked at and the count being checked, in which case this looks again
+		std::unique_lock<std::mutex> lock(state_mutex);
+		work_available.wait(lock, [this]() {
+			return num_queued > 0 || is_stopping;
+		});
+		if (num_queued == 0 && is_stopping) {
+			return;
+		}
+	}
+}
+
+unsigned resolveThreadCount(unsigned requested) {
+	if (requested > 0) {
+		return requested;
+	}
+
+	// hardware_concurrency is allowed to return 0 if it can't tell
+	return std::max(std::thread::hardware_concurrency(), 1u);
+}
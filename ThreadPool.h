@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <llvm/ADT/Optional.h>
+#include <llvm/Support/thread.h>
+
+// A fixed set of worker threads, each with its own queue of tasks. A worker runs the newest task in its own queue, and once that's empty it steals
+// the oldest one from another worker's, so uneven tasks (e.g. chunks of input with and without matches) still keep every thread busy.
+class ThreadPool {
+public:
+	using Task = std::function<void()>;
+
+	// Starts num_threads workers (at least one), with stacks of stack_size bytes if it's given
+	explicit ThreadPool(unsigned num_threads, llvm::Optional<unsigned> stack_size = llvm::None);
+	// Runs whatever is still queued, then stops the workers
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Queues task on the next worker in turn
+	void submit(Task task);
+	// Blocks until every task that has been submitted has finished
+	void wait();
+
+	unsigned getNumThreads() const;
+	// The index of the worker running the calling task, from 0 to getNumThreads() - 1, so that tasks can keep state per worker. Only valid within a
+	// task.
+	static size_t getCurrentWorker();
+
+private:
+	struct Worker {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	// Takes the newest task from worker's own queue, or else the oldest from another's. Returns false if they're all empty.
+	bool takeTask(size_t worker, Task& task_out);
+	void runWorker(size_t worker);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<llvm::thread> threads;
+
+	// Guards the counts below, which the workers sleep on while there's nothing to take
+	std::mutex state_mutex;
+	std::condition_variable work_available;
+	std::condition_variable work_finished;
+	size_t next_worker;
+	// Tasks that are still in a queue, and tasks that haven't finished running
+	size_t num_queued;
+	size_t num_unfinished;
+	bool is_stopping;
+};
+
+// Returns the number of threads to use for a requested count, where 0 means one per core
+unsigned resolveThreadCount(unsigned requested);
@@ -16,10 +16,18 @@ llvm::IntegerType* TypeProvider::getBit() {
 	return llvm::Type::getInt1Ty(context);
 }
 
+llvm::IntegerType* TypeProvider::getInt16() {
+	return llvm::Type::getInt16Ty(context);
+}
+
 llvm::IntegerType* TypeProvider::getInt32() {
 	return llvm::Type::getInt32Ty(context);
 }
 
+llvm::IntegerType* TypeProvider::getInt64() {
+	return llvm::Type::getInt64Ty(context);
+}
+
 llvm::PointerType* TypeProvider::getVoidPtr() {
 	return getVoid()->getPointerTo();
 }
@@ -34,4 +42,8 @@ llvm::PointerType* TypeProvider::getBitPtr() {
 
 llvm::PointerType* TypeProvider::getInt32Ptr() {
 	return getInt32()->getPointerTo();
+}
+
+llvm::PointerType* TypeProvider::getInt64Ptr() {
+	return getInt64()->getPointerTo();
 }
\ No newline at end of file
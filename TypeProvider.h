@@ -10,11 +10,14 @@ public:
 	llvm::Type* getVoid();
 	llvm::IntegerType* getByte();
 	llvm::IntegerType* getBit();
+	llvm::IntegerType* getInt16();
 	llvm::IntegerType* getInt32();
+	llvm::IntegerType* getInt64();
 	llvm::PointerType* getVoidPtr();
 	llvm::PointerType* getBytePtr();
 	llvm::PointerType* getBitPtr();
 	llvm::PointerType* getInt32Ptr();
+	llvm::PointerType* getInt64Ptr();
 private:
 	llvm::LLVMContext& context;
 };
\ No newline at end of file
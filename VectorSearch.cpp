@@ -0,0 +1,337 @@
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <array>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/IntrinsicsX86.h>
+#include "VectorSearch.h"
+#include "TypeProvider.h"
+#include "ConstantProvider.h"
+
+namespace {
+	// Returns whether each byte of input (a byte or a vector of them) is one that the search is looking for
+	using ByteMatcher = std::function<llvm::Value*(llvm::IRBuilder<>& builder, llvm::Function* search_function, llvm::Value* input)>;
+
+	// Builds a private function with the signature i64 (i8* buf, i64 from, i64 len, extra_args...) that returns the index of the first byte in
+	// buf[from, len) that matches, or len if there isn't one
+	llvm::Function* buildSearchFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const std::string& name, const std::vector<llvm::Type*>& extra_args, const ByteMatcher& matches) {
+		TypeProvider type_provider(context);
+		ConstantProvider constant_provider(type_provider);
+
+		std::vector<llvm::Type*> args { type_provider.getBytePtr(), type_provider.getInt64(), type_provider.getInt64() }; // buf, from, and len
+		args.insert(args.end(), extra_args.begin(), extra_args.end());
+		llvm::FunctionType* search_type = llvm::FunctionType::get(type_provider.getInt64(), args, false);
+		llvm::Function* search_function = llvm::Function::Create(search_type, llvm::Function::PrivateLinkage, name, &module);
+		llvm::Value* buf = search_function->args().begin();
+		llvm::Value* from = (search_function->args().begin() + 1);
+		llvm::Value* len = (search_function->args().begin() + 2);
+
+		llvm::IntegerType* mask_type = llvm::IntegerType::get(context, search_vector_width);
+		llvm::FixedVectorType* vector_type = llvm::FixedVectorType::get(type_provider.getByte(), search_vector_width);
+
+		llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", search_function);
+		llvm::BasicBlock* vector_loop = llvm::BasicBlock::Create(context, "vector_loop", search_function);
+		llvm::BasicBlock* vector_body = llvm::BasicBlock::Create(context, "vector_body", search_function);
+		llvm::BasicBlock* vector_found = llvm::BasicBlock::Create(context, "vector_found", search_function);
+		llvm::BasicBlock* scalar_loop = llvm::BasicBlock::Create(context, "scalar_loop", search_function);
+		llvm::BasicBlock* scalar_body = llvm::BasicBlock::Create(context, "scalar_body", search_function);
+		llvm::BasicBlock* scalar_found = llvm::BasicBlock::Create(context, "scalar_found", search_function);
+		llvm::BasicBlock* not_found = llvm::BasicBlock::Create(context, "not_found", search_function);
+
+		builder.SetInsertPoint(entry);
+		// Signed so that inputs shorter than a vector don't wrap around
+		llvm::Value* last_vector_start = builder.CreateSub(len, constant_provider.getInt64(search_vector_width));
+		builder.CreateBr(vector_loop);
+
+		builder.SetInsertPoint(vector_loop);
+		llvm::PHINode* vector_index = builder.CreatePHI(type_provider.getInt64(), 2);
+		vector_index->addIncoming(from, entry);
+		builder.CreateCondBr(builder.CreateICmpSLE(vector_index, last_vector_start), vector_body, scalar_loop);
+
+		builder.SetInsertPoint(vector_body);
+		llvm::Value* chunk = builder.CreateAlignedLoad(
+			vector_type,
+			builder.CreateBitCast(builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { vector_index }), vector_type->getPointerTo()),
+			llvm::MaybeAlign(1)
+		);
+		llvm::Value* mask = builder.CreateBitCast(matches(builder, search_function, chunk), mask_type);
+		vector_index->addIncoming(builder.CreateAdd(vector_index, constant_provider.getInt64(search_vector_width)), vector_body);
+		builder.CreateCondBr(builder.CreateICmpNE(mask, llvm::ConstantInt::get(mask_type, 0)), vector_found, vector_loop);
+
+		builder.SetInsertPoint(vector_found);
+		llvm::Value* offset_in_vector = builder.CreateBinaryIntrinsic(llvm::Intrinsic::cttz, mask, constant_provider.getBit(1));
+		builder.CreateRet(builder.CreateAdd(vector_index, builder.CreateZExtOrTrunc(offset_in_vector, type_provider.getInt64())));
+
+		builder.SetInsertPoint(scalar_loop);
+		llvm::PHINode* scalar_index = builder.CreatePHI(type_provider.getInt64(), 2);
+		scalar_index->addIncoming(vector_index, vector_loop);
+		builder.CreateCondBr(builder.CreateICmpSLT(scalar_index, len), scalar_body, not_found);
+
+		builder.SetInsertPoint(scalar_body);
+		llvm::Value* input = builder.CreateLoad(type_provider.getByte(), builder.CreateGEP(type_provider.getByte(), buf, std::vector<llvm::Value*> { scalar_index }));
+		scalar_index->addIncoming(builder.CreateAdd(scalar_index, constant_provider.getInt64(1)), scalar_body);
+		builder.CreateCondBr(matches(builder, search_function, input), scalar_found, scalar_loop);
+
+		builder.SetInsertPoint(scalar_found);
+		builder.CreateRet(scalar_index);
+
+		builder.SetInsertPoint(not_found);
+		builder.CreateRet(len);
+
+		return search_function;
+	}
+
+	// Compares input (a byte or a vector of them) to needle, which is splatted to match
+	llvm::Value* buildCompareBytes(llvm::IRBuilder<>& builder, llvm::Value* input, llvm::Value* needle) {
+		if (llvm::FixedVectorType* vector_type = llvm::dyn_cast<llvm::FixedVectorType>(input->getType())) {
+			needle = builder.CreateVectorSplat(vector_type->getNumElements(), needle);
+		}
+
+		return builder.CreateICmpEQ(input, needle);
+	}
+
+	// Names the functions that have a set of bytes baked into them, using the bitmap of the set in hex
+	std::string getByteSetName(const char* prefix, const ByteSet& bytes) {
+		std::string name = prefix;
+		const char* hex_digits = "0123456789abcdef";
+		for (size_t i = 0; i < 256; i += 4) {
+			name += hex_digits[bytes[i] | bytes[i + 1] << 1 | bytes[i + 2] << 2 | bytes[i + 3] << 3];
+		}
+
+		return name;
+	}
+}
+
+llvm::Function* buildFindByteFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module) {
+	TypeProvider type_provider(context);
+
+	llvm::Function* existing = module.getFunction("rx_find_byte");
+	if (existing) {
+		return existing;
+	}
+
+	return buildSearchFunction(context, builder, module, "rx_find_byte", std::vector<llvm::Type*> { type_provider.getByte() }, // byte
+		[](llvm::IRBuilder<>& builder, llvm::Function* search_function, llvm::Value* input) {
+			return buildCompareBytes(builder, input, search_function->args().begin() + 3);
+		}
+	);
+}
+
+llvm::Function* buildFindAnyByteFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const std::vector<uint8_t>& bytes) {
+	TypeProvider type_provider(context);
+
+	// The bytes are baked into the function, so each set of them gets its own
+	std::string name = "rx_find_any";
+	for (uint8_t byte : bytes) {
+		name += "_" + std::to_string(byte);
+	}
+
+	llvm::Function* existing = module.getFunction(name);
+	if (existing) {
+		return existing;
+	}
+
+	return buildSearchFunction(context, builder, module, name, std::vector<llvm::Type*> {},
+		[&type_provider, &bytes](llvm::IRBuilder<>& builder, llvm::Function*, llvm::Value* input) {
+			ConstantProvider constant_provider(type_provider);
+			llvm::Value* any_match = nullptr;
+			for (uint8_t byte : bytes) {
+				bool is_other_case_included = std::isalpha(byte) && std::find(bytes.begin(), bytes.end(), byte ^ 0x20) != bytes.end();
+				if (is_other_case_included && std::isupper(byte)) {
+					continue;
+				}
+
+				llvm::Value* byte_match = is_other_case_included ? buildCompareFoldedLetter(builder, input, byte) : buildCompareBytes(builder, input, constant_provider.getByte(byte));
+				any_match = any_match ? builder.CreateOr(any_match, byte_match) : byte_match;
+			}
+
+			return any_match;
+		}
+	);
+}
+
+bool getFoldedLetter(const ByteSet& bytes, uint8_t& letter_out) {
+	for (int letter = 'a'; letter <= 'z'; letter++) {
+		if (bytes.count() == 2 && bytes[letter] && bytes[letter & ~0x20]) {
+			letter_out = static_cast<uint8_t>(letter);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+llvm::Value* buildCompareFoldedLetter(llvm::IRBuilder<>& builder, llvm::Value* input, uint8_t letter) {
+	TypeProvider type_provider(builder.getContext());
+	ConstantProvider constant_provider(type_provider);
+
+	llvm::Value* case_bit = constant_provider.getByte(0x20);
+	if (llvm::FixedVectorType* vector_type = llvm::dyn_cast<llvm::FixedVectorType>(input->getType())) {
+		case_bit = builder.CreateVectorSplat(vector_type->getNumElements(), case_bit);
+	}
+
+	return buildCompareBytes(builder, builder.CreateOr(input, case_bit), constant_provider.getByte(letter));
+}
+
+std::vector<std::pair<uint8_t, uint8_t>> getByteRanges(const ByteSet& bytes) {
+	std::vector<std::pair<uint8_t, uint8_t>> ranges;
+	for (int byte = 0; byte < 256; byte++) {
+		if (!bytes[byte]) {
+			continue;
+		}
+
+		if (byte > 0 && bytes[byte - 1]) {
+			ranges.back().second = static_cast<uint8_t>(byte);
+		} else {
+			ranges.emplace_back(static_cast<uint8_t>(byte), static_cast<uint8_t>(byte));
+		}
+	}
+
+	return ranges;
+}
+
+llvm::Function* buildFindRangesFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const ByteSet& bytes) {
+	TypeProvider type_provider(context);
+
+	// Like with PSHUFB, the end of a run of a class is found by negating the class
+	std::vector<std::pair<uint8_t, uint8_t>> ranges = getByteRanges(bytes);
+	bool is_negated = ranges.size() > max_search_ranges;
+	if (is_negated) {
+		ranges = getByteRanges(~bytes);
+		if (ranges.size() > max_search_ranges) {
+			return nullptr;
+		}
+	}
+
+	std::string name = getByteSetName("rx_find_ranges_", bytes);
+	llvm::Function* existing = module.getFunction(name);
+	if (existing) {
+		return existing;
+	}
+
+	return buildSearchFunction(context, builder, module, name, std::vector<llvm::Type*> {},
+		[&type_provider, &ranges, is_negated](llvm::IRBuilder<>& builder, llvm::Function*, llvm::Value* input) {
+			ConstantProvider constant_provider(type_provider);
+			llvm::Value* any_match = nullptr;
+			for (const std::pair<uint8_t, uint8_t>& range : ranges) {
+				// Bytes below the range wrap around to above its width, so each range takes one subtraction and one unsigned compare
+				llvm::Value* first = constant_provider.getByte(range.first);
+				llvm::Value* width = constant_provider.getByte(static_cast<uint8_t>(range.second - range.first));
+				if (llvm::FixedVectorType* vector_type = llvm::dyn_cast<llvm::FixedVectorType>(input->getType())) {
+					first = builder.CreateVectorSplat(vector_type->getNumElements(), first);
+					width = builder.CreateVectorSplat(vector_type->getNumElements(), width);
+				}
+
+				llvm::Value* range_match = builder.CreateICmpULE(builder.CreateSub(input, first), width);
+				any_match = any_match ? builder.CreateOr(any_match, range_match) : range_match;
+			}
+
+			return is_negated ? builder.CreateNot(any_match) : any_match;
+		}
+	);
+}
+
+bool getNibbleTables(const ByteSet& bytes, std::array<uint8_t, 16>& low_table_out, std::array<uint8_t, 16>& high_table_out) {
+	// Bytes with the same high nibble share a mask of the low nibbles that complete them, and each distinct mask gets one of the 8 bits
+	std::vector<uint16_t> masks;
+	low_table_out.fill(0);
+	high_table_out.fill(0);
+	for (int high = 0; high < 16; high++) {
+		uint16_t mask = 0;
+		for (int low = 0; low < 16; low++) {
+			if (bytes[high << 4 | low]) {
+				mask |= static_cast<uint16_t>(1 << low);
+			}
+		}
+		if (mask == 0) {
+			continue;
+		}
+
+		auto existing = std::find(masks.begin(), masks.end(), mask);
+		if (existing == masks.end()) {
+			if (masks.size() == 8) {
+				return false;
+			}
+			existing = masks.insert(masks.end(), mask);
+		}
+		uint8_t bit = static_cast<uint8_t>(1 << (existing - masks.begin()));
+
+		high_table_out[high] |= bit;
+		for (int low = 0; low < 16; low++) {
+			if (mask & (1 << low)) {
+				low_table_out[low] |= bit;
+			}
+		}
+	}
+
+	return true;
+}
+
+llvm::Function* buildFindClassFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const ByteSet& bytes) {
+	TypeProvider type_provider(context);
+
+	// The end of a run of a class is found by looking up the class and negating the result
+	std::array<uint8_t, 16> low_table;
+	std::array<uint8_t, 16> high_table;
+	bool is_negated = !getNibbleTables(bytes, low_table, high_table);
+	if (is_negated && !getNibbleTables(~bytes, low_table, high_table)) {
+		return nullptr;
+	}
+
+	std::string name = getByteSetName("rx_find_class_", bytes);
+	llvm::Function* existing = module.getFunction(name);
+	if (existing) {
+		return existing;
+	}
+
+	return buildSearchFunction(context, builder, module, name, std::vector<llvm::Type*> {},
+		[&context, &type_provider, &module, &low_table, &high_table, is_negated](llvm::IRBuilder<>& builder, llvm::Function*, llvm::Value* input) -> llvm::Value* {
+			ConstantProvider constant_provider(type_provider);
+			llvm::Constant* low_lookup = llvm::ConstantDataVector::get(context, llvm::ArrayRef<uint8_t>(low_table.data(), low_table.size()));
+			llvm::Constant* high_lookup = llvm::ConstantDataVector::get(context, llvm::ArrayRef<uint8_t>(high_table.data(), high_table.size()));
+
+			// The tail of the input is looked up one byte at a time
+			if (!input->getType()->isVectorTy()) {
+				llvm::Value* low_bits = builder.CreateExtractElement(low_lookup, builder.CreateAnd(input, constant_provider.getByte(0x0F)));
+				llvm::Value* high_bits = builder.CreateExtractElement(high_lookup, builder.CreateLShr(input, constant_provider.getByte(4)));
+				llvm::Value* is_in_table = builder.CreateICmpNE(builder.CreateAnd(low_bits, high_bits), constant_provider.getByte(0));
+				return is_negated ? builder.CreateNot(is_in_table) : is_in_table;
+			}
+
+			// PSHUFB looks up 16 bytes at once, so the vector is classified in halves
+			llvm::Function* shuffle = llvm::Intrinsic::getDeclaration(&module, llvm::Intrinsic::x86_ssse3_pshuf_b_128);
+			llvm::FixedVectorType* half_type = llvm::FixedVectorType::get(type_provider.getByte(), 16);
+			std::vector<llvm::Value*> halves;
+			for (int half = 0; half < static_cast<int>(search_vector_width / 16); half++) {
+				std::vector<int> half_mask;
+				for (int i = 0; i < 16; i++) {
+					half_mask.push_back(half * 16 + i);
+				}
+
+				llvm::Value* chunk = builder.CreateShuffleVector(input, half_mask);
+				llvm::Value* low_nibbles = builder.CreateAnd(chunk, llvm::ConstantVector::getSplat(llvm::ElementCount::getFixed(16), constant_provider.getByte(0x0F)));
+				llvm::Value* high_nibbles = builder.CreateLShr(chunk, llvm::ConstantVector::getSplat(llvm::ElementCount::getFixed(16), constant_provider.getByte(4)));
+				llvm::Value* low_bits = builder.CreateCall(shuffle->getFunctionType(), shuffle, std::vector<llvm::Value*> { low_lookup, low_nibbles });
+				llvm::Value* high_bits = builder.CreateCall(shuffle->getFunctionType(), shuffle, std::vector<llvm::Value*> { high_lookup, high_nibbles });
+				halves.push_back(builder.CreateICmpNE(builder.CreateAnd(low_bits, high_bits), llvm::Constant::getNullValue(half_type)));
+			}
+
+			std::vector<int> concat_mask;
+			for (int i = 0; i < static_cast<int>(search_vector_width); i++) {
+				concat_mask.push_back(i);
+			}
+			llvm::Value* is_in_table = builder.CreateShuffleVector(halves[0], halves[1], concat_mask);
+			return is_negated ? builder.CreateNot(is_in_table) : is_in_table;
+		}
+	);
+}
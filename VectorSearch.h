@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include "Nfa.h"
+
+// How many bytes the generated searches compare at once
+const uint32_t search_vector_width = 32;
+
+// Builds (or returns the existing) private function with the signature i64 (i8* buf, i64 from, i64 len, i8 byte), which returns the index of the first
+// occurrence of byte in buf[from, len), or len if there isn't one. It compares search_vector_width bytes at a time, which lowers to compare and
+// movemask instructions on targets that have them.
+llvm::Function* buildFindByteFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module);
+
+// Builds (or returns the existing) private function with the signature i64 (i8* buf, i64 from, i64 len), which works like the above but finds the
+// first occurrence of any of bytes (which can't be empty). Letters that are there in both cases take one compare (see buildCompareFoldedLetter).
+llvm::Function* buildFindAnyByteFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const std::vector<uint8_t>& bytes);
+
+// Returns whether bytes is an ASCII letter in both cases and nothing else (as in a case-insensitive literal), and sets letter_out to the lowercase one
+bool getFoldedLetter(const ByteSet& bytes, uint8_t& letter_out);
+// Returns whether input (a byte or a vector of them) is letter in either case, by setting the bit that makes uppercase letters lowercase and then
+// comparing, rather than comparing against each case
+llvm::Value* buildCompareFoldedLetter(llvm::IRBuilder<>& builder, llvm::Value* input, uint8_t letter);
+
+// Returns the ranges of consecutive bytes in bytes, as pairs of their first and last byte
+std::vector<std::pair<uint8_t, uint8_t>> getByteRanges(const ByteSet& bytes);
+
+// Searches for classes that are a few ranges (or the bytes outside a few ranges, like the end of a run of \w) compare against each of them
+const size_t max_search_ranges = 3;
+
+// Builds (or returns the existing) private function with the signature i64 (i8* buf, i64 from, i64 len), which works like buildFindAnyByteFunction
+// but finds the first byte in bytes by comparing against its ranges. Returns null if neither bytes nor its complement fit in max_search_ranges.
+llvm::Function* buildFindRangesFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const ByteSet& bytes);
+
+// Splits bytes into a table for each nibble, so that a byte is in bytes if the entries for its low and high nibbles share a bit. This works for sets
+// where the bytes with each high nibble have one of at most 8 sets of low nibbles, which covers most classes, and returns false otherwise.
+bool getNibbleTables(const ByteSet& bytes, std::array<uint8_t, 16>& low_table_out, std::array<uint8_t, 16>& high_table_out);
+
+// Like buildFindAnyByteFunction, but finds the first byte in bytes using a pair of PSHUFB nibble lookups per 16 bytes, so it can only be used on x86
+// targets with SSSE3. Returns null if getNibbleTables can't handle bytes or their complement.
+llvm::Function* buildFindClassFunction(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, const ByteSet& bytes);
@@ -0,0 +1,21 @@
+# Writes OUTPUT, a source file that defines compiler_version (see Cache.h) as a SHA-1 hash of the sources in SOURCE_DIR, so that any change to
+# the code generator changes every cache key without anyone having to remember to bump it. CMakeLists.txt runs it whenever a source changes.
+file(GLOB sources "${SOURCE_DIR}/*.cpp" "${SOURCE_DIR}/*.h")
+list(SORT sources)
+set(hashes "")
+foreach(source ${sources})
+	get_filename_component(name "${source}" NAME)
+	file(SHA1 "${source}" hash)
+	string(APPEND hashes "${name} ${hash}\n")
+endforeach()
+string(SHA1 version "${hashes}")
+
+set(contents "// Generated by cmake/CompilerVersion.cmake from the hashes of the compiler's sources, don't edit it\n#include \"Cache.h\"\n\nconst char* const compiler_version = \"${version}\";\n")
+# It's only written when the version changes, since rewriting it would rebuild the library for edits that don't change any source (like a touch)
+set(old_contents "")
+if(EXISTS "${OUTPUT}")
+	file(READ "${OUTPUT}" old_contents)
+endif()
+if(NOT old_contents STREQUAL contents)
+	file(WRITE "${OUTPUT}" "${contents}")
+endif()
@@ -1,250 +1,586 @@
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <memory>
 #include <vector>
-#include <cstdio>
 #include <cstdint>
 #include <llvm/IR/LLVMContext.h>
-#include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Module.h>
-#include <llvm/IR/Type.h>
-#include <llvm/IR/DerivedTypes.h>
-#include <llvm/IR/Constants.h>
-#include "Atom.h"
-#include "Literal.h"
-#include "StringStartMetacharacter.h"
-#include "StringEndMetacharacter.h"
-#include "Digit.h"
-#include "AcceptDecision.h"
-#include "TypeProvider.h"
-#include "ConstantProvider.h"
-
-llvm::Function* buildPanic(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module) {
-	TypeProvider type_provider(context);
-	ConstantProvider constant_provider(type_provider);
-
-	std::vector<llvm::Type*> puts_args_type(1, type_provider.getBytePtr());
-	llvm::FunctionType* puts_type = llvm::FunctionType::get(type_provider.getInt32(), llvm::ArrayRef(puts_args_type), false);
-	llvm::Function* existing_puts = module.getFunction("puts");
-	llvm::Function* puts_function = existing_puts
-		? existing_puts
-		: llvm::Function::Create(puts_type, llvm::Function::ExternalLinkage, "puts", &module);
-
-	llvm::FunctionType* exit_type = llvm::FunctionType::get(type_provider.getVoid(), std::vector<llvm::Type*> { type_provider.getInt32() }, false);
-	llvm::Function* existing_exit = module.getFunction("exit");
-	llvm::Function* exit_function = existing_exit
-		? existing_exit
-		: llvm::Function::Create(exit_type, llvm::Function::ExternalLinkage, "exit", &module);
-
-	llvm::FunctionType* panic_type = llvm::FunctionType::get(type_provider.getVoid(), llvm::ArrayRef(puts_args_type), false);
-	llvm::Function* existing_panic = module.getFunction("panic");
-	if (existing_panic) {
-		return existing_panic;
-	}
-
-	llvm::Function* panic = llvm::Function::Create(panic_type, llvm::Function::PrivateLinkage, "panic", &module);
-
-	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", panic);
-	builder.SetInsertPoint(entry);
-	builder.CreateCall(puts_type, puts_function, std::vector<llvm::Value*> { (panic->args().begin()) });
-	builder.CreateCall(exit_type, exit_function, std::vector<llvm::Value*> { constant_provider.getInt32(127) });
-	builder.CreateUnreachable();
-
-	return panic;
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/thread.h>
+#include "Compiler.h"
+#include "Matcher.h"
+#include "Jit.h"
+#include "Target.h"
+#include "Emitter.h"
+#include "Optimizer.h"
+#include "ThreadPool.h"
+#include "ParallelScan.h"
+#include "Batch.h"
+#include "Cache.h"
+
+void printUsage() {
+	std::cout << "Usage: RegexCompiler [options] [--] regex [file...]\n";
+	std::cout << "       RegexCompiler [options] --patterns <path> [--] [file...]\n";
+	std::cout << "  By default the regex is compiled to out.ll, which can be compiled with clang.\n";
+	std::cout << "  --patterns <path> Compile the set of patterns in the file, one per line, and print the number of each one that matches.\n";
+	std::cout << "  --jit          Compile the regex in-process and match it against stdin, or each file if any are given.\n";
+	std::cout << "  --emit <kind>  Emit ir (the default, a program as LLVM IR), obj (an object file) or lib (a static library).\n";
+	std::cout << "                 Objects and libraries have no main function and come with a C header declaring the matchers.\n";
+	std::cout << "  --output <path> Where to write the output, by default out.ll, out.o or lib<prefix>.a.\n";
+	std::cout << "  --prefix <name> Prefix for the names of the generated functions, by default rx (e.g. rx_match).\n";
+	std::cout << "  --opt-level <n> Optimize like clang's -O<n>, from 0 to 3 (the default).\n";
+	std::cout << "  --mcpu <cpu>   Generate code for the given CPU (e.g. skylake), or native for this one. The default is a generic CPU,\n";
+	std::cout << "                 except with --jit where it's this one.\n";
+	std::cout << "  --march <arch> Generate code for the given architecture (e.g. x86-64) instead of this machine's.\n";
+	std::cout << "  --ignore-case  Match letters in either case, like starting the regex (or each pattern) with (?i).\n";
+	std::cout << "  --lines        Match each line separately and print the ones that match, like grep.\n";
+	std::cout << "  --count        Like --lines, but print how many lines matched instead.\n";
+	std::cout << "  --line-number  Like --lines, but prefix each matching line with its line number.\n";
+	std::cout << "  --matches      Print the start and end offsets of each match (leftmost-longest, not overlapping).\n";
+	std::cout << "  --count-matches Like --matches, but print how many matches there are instead.\n";
+	std::cout << "  --threads <n>  With --jit, split each large file into chunks that n threads (0 for one per core) scan in parallel. Used when\n";
+	std::cout << "                 matching without ^ or $ and a longest match, and in line mode, but not for sets or --matches. With --batch, compile\n";
+	std::cout << "                 on n threads.\n";
+	std::cout << "  --batch <path> With --emit lib, compile each regex in the file (one per line) separately into one library, with the functions\n";
+	std::cout << "                 for the nth regex named <prefix>_<n> (e.g. rx_1_match).\n";
+	std::cout << "  --cache <dir>  With --jit or --batch, reuse the objects compiled for the same regexes, options, CPU and versions by earlier runs\n";
+	std::cout << "                 from dir, and add the ones compiled now.\n";
+	std::cout << "  --cache-size <n> Evict the least recently used objects once the cache is larger than n MiB, by default 1024.\n";
 }
 
-llvm::BasicBlock* buildReadToBuf(llvm::LLVMContext& context, llvm::IRBuilder<>& builder, llvm::Module& module, llvm::Function* function, llvm::BasicBlock* after_block, llvm::AllocaInst*& buf_out, llvm::Value*& len_out) {
-	TypeProvider type_provider(context);
-	ConstantProvider constant_provider(type_provider);
-
-	std::vector<llvm::Type*> getchar_args_type;
-	llvm::FunctionType* getchar_type = llvm::FunctionType::get(type_provider.getInt32(), getchar_args_type, false);
-	llvm::Function* existing_getchar = module.getFunction("getchar");
-	llvm::Function* getchar_function = existing_getchar
-		? existing_getchar
-		: llvm::Function::Create(getchar_type, llvm::Function::ExternalLinkage, "getchar", module);
-
-	llvm::BasicBlock* pre_init_loop = llvm::BasicBlock::Create(context, "pre_init_loop", function);
-	builder.SetInsertPoint(pre_init_loop);
-
-	const int buf_size = 1024;
-	buf_out = builder.CreateAlloca(type_provider.getByte(), constant_provider.getInt32(buf_size), "buf");
-	llvm::Value* start_index =  constant_provider.getInt32(0);
-
-	llvm::BasicBlock* init_array_loop = llvm::BasicBlock::Create(context, "init_array_loop", function);
-	llvm::BasicBlock* after_init_loop = llvm::BasicBlock::Create(context, "after_init_loop", function);
-	builder.CreateBr(init_array_loop);
-
-	builder.SetInsertPoint(init_array_loop);
-
-	llvm::PHINode* loop_index = builder.CreatePHI(type_provider.getInt32(), 2);
-	llvm::Value* next_index = builder.CreateAdd(loop_index, constant_provider.getInt32(1));
-	loop_index->addIncoming(start_index, pre_init_loop);
-	loop_index->addIncoming(next_index, init_array_loop);
-
-	llvm::Value* input = builder.CreateCall(getchar_type, getchar_function);
-	llvm::Value* was_eof = builder.CreateICmpEQ(input, constant_provider.getInt32(-1, true));
-	builder.CreateStore(
-		builder.CreateIntCast(input, type_provider.getByte(), true),
-		builder.CreateGEP(type_provider.getByte(), buf_out, std::vector<llvm::Value*> { loop_index })
-	);
-
-	llvm::Value* next_iter_out_of_bounds = builder.CreateICmpEQ(next_index, constant_provider.getInt32(buf_size + 2));
-	llvm::Value* should_exit = builder.CreateOr(was_eof, next_iter_out_of_bounds);
-	builder.CreateCondBr(should_exit, after_init_loop, init_array_loop);
-
-	builder.SetInsertPoint(after_init_loop);
-	builder.CreateStore(
-		constant_provider.getByte(0),
-		builder.CreateGEP(type_provider.getByte(), buf_out, std::vector<llvm::Value*> { loop_index })
-	);
-
-	llvm::BasicBlock* panic_block = llvm::BasicBlock::Create(context, "panic_block", function);
-	builder.CreateCondBr(next_iter_out_of_bounds, panic_block, after_block);
-
-	llvm::Function* panic = buildPanic(context, builder, module);
-	builder.SetInsertPoint(panic_block);
-	builder.CreateCall(panic->getFunctionType(), panic, std::vector<llvm::Value*> { builder.CreateGlobalStringPtr("Error: Could not read string, buffer was too small.") });
-	builder.CreateUnreachable();
-
-	len_out = loop_index;
-	return pre_init_loop;
+// What to compile: a single regex, or a set of them read with --patterns
+struct PatternInput {
+	std::vector<std::string> regexes;
+	bool is_set;
+};
+
+bool compilePatterns(const PatternInput& input, llvm::LLVMContext& context, llvm::Module& module, const CompileOptions& options, std::string& error_out) {
+	return input.is_set
+		? compileRegexSet(input.regexes, context, module, options, error_out)
+		: compileRegex(input.regexes[0], context, module, options, error_out);
 }
 
-int main(int argc, char* argv[]) {
-	if(argc < 2) {
-		std::cout << "Specify a regex\n";
-		return 1;
+// Reads one pattern per line, ignoring a trailing carriage return so that files written on Windows work
+bool readPatterns(const std::string& path, std::vector<std::string>& patterns_out) {
+	std::ifstream input(path, std::ios::binary);
+	if (!input) {
+		return false;
 	}
-	std::string regex = argv[1];
 
-	llvm::LLVMContext context;
-	llvm::IRBuilder Builder(context);
-	llvm::Module module("RegexCompiler", context);
+	std::string line;
+	while (std::getline(input, line)) {
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		patterns_out.push_back(line);
+	}
 
-	TypeProvider type_provider(context);
-	ConstantProvider constant_provider(type_provider);
+	return !input.bad();
+}
 
-	std::vector<std::unique_ptr<Atom>> atoms;
-	bool prev_was_escape = false;
-	for(char c : regex) {
-		if (c == '^' && !prev_was_escape) { // TODO: Escape characters
-			std::unique_ptr<StringStartMetacharacter> metachar = std::make_unique<StringStartMetacharacter>(&context, &module, &Builder);
-			atoms.push_back(std::move(metachar));
-		} else if (c == '$' && !prev_was_escape) {
-			std::unique_ptr<StringEndMetacharacter> metachar = std::make_unique<StringEndMetacharacter>(&context, &module, &Builder);
-			atoms.push_back(std::move(metachar));
-		} else if (c == 'd' && prev_was_escape) {
-			std::unique_ptr<Digit> digit = std::make_unique<Digit>(&context, &module, &Builder);
-			atoms.push_back(std::move(digit));
-		} else if (c != '\\' || (c == '\\' && prev_was_escape)) {
-			std::unique_ptr<Literal> literal = std::make_unique<Literal>(c, &context, &module, &Builder);
-			atoms.push_back(std::move(literal));
+// Prints the number of each pattern set in matched, prefixed with name if it isn't empty, like the generated main does
+void printMatchedPatterns(const std::vector<uint64_t>& matched, size_t num_patterns, const std::string& name) {
+	for (size_t i = 0; i < num_patterns; i++) {
+		if ((matched[i / 64] >> (i % 64)) & 1) {
+			if (!name.empty()) {
+				std::cout << name << ":";
+			}
+			std::cout << (i + 1) << "\n";
 		}
+	}
+}
 
-		prev_was_escape = c == '\\' && !prev_was_escape;
+int runJitSet(Jit& jit, const PatternInput& input, const CompileOptions& options, const std::vector<std::string>& files) {
+	std::string error;
+	MatchSetFdFunction match_set_fd = jit.lookupFunction<MatchSetFdFunction>(getSymbolName(options.symbol_prefix, match_set_fd_function_suffix).c_str(), error);
+	MatchSetFileFunction match_set_file = match_set_fd ? jit.lookupFunction<MatchSetFileFunction>(getSymbolName(options.symbol_prefix, match_set_file_function_suffix).c_str(), error) : nullptr;
+	if (!match_set_file) {
+		std::cout << "Could not JIT patterns: " << error << "\n";
+		return 2;
 	}
 
-	if (prev_was_escape) {
-		std::cout << "Invalid regex: Trailing unescaped \\\n";
-		return 1;
+	size_t num_patterns = input.regexes.size();
+	std::vector<uint64_t> matched((num_patterns + 63) / 64);
+	if (files.empty()) {
+		int32_t result = match_set_fd(0, matched.data());
+		if (result < 0) {
+			std::cout << "Could not read stdin\n";
+			return 2;
+		}
+
+		printMatchedPatterns(matched, num_patterns, "");
+		return result ? 0 : 1;
 	}
 
-	std::vector<llvm::Type*> main_args_type;
-	llvm::FunctionType* main_type = llvm::FunctionType::get(type_provider.getInt32(), main_args_type, false);
-	llvm::Function* main_function = llvm::Function::Create(main_type, llvm::Function::ExternalLinkage, "main", &module);
+	bool any_matched = false;
+	for (const std::string& file : files) {
+		int32_t result = match_set_file(file.c_str(), matched.data());
+		if (result < 0) {
+			std::cout << "Could not read " << file << "\n";
+			return 2;
+		}
+
+		printMatchedPatterns(matched, num_patterns, files.size() > 1 ? file : "");
+		any_matched |= result > 0;
+	}
 
-	llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", main_function);
-	Builder.SetInsertPoint(entry);
+	return any_matched ? 0 : 1;
+}
 
-	llvm::AllocaInst* buf;
-	llvm::Value* input_len;
-	llvm::BasicBlock* post_loop = llvm::BasicBlock::Create(context, "post_loop", main_function);
-	llvm::BasicBlock* readToBuf = buildReadToBuf(context, Builder, module, main_function, post_loop, buf, input_len);
+int runJit(const PatternInput& input, const CompileOptions& options, const TargetSelection& target, const std::vector<std::string>& files, unsigned num_threads, const ObjectCache* cache) {
+	std::string error;
+	std::unique_ptr<Jit> jit = Jit::create(target, error);
+	if (!jit) {
+		std::cout << "Could not create JIT: " << error << "\n";
+		return 2;
+	}
+
+	CompileOptions jit_options = options;
+	jit_options.has_byte_shuffle = hasByteShuffle(jit->getTargetMachine());
+
+	// With a cache, the JIT is given the object from an earlier run if there is one, or else the one compiled now, which is cached for the next
+	if (cache) {
+		std::string key = getCacheKey(CachedObjectKind::Jit, input.regexes, input.is_set, jit_options, jit->getTargetMachine(), target.opt_level);
+		std::unique_ptr<llvm::MemoryBuffer> object = cache->load(key);
+		if (!object) {
+			llvm::LLVMContext context;
+			llvm::Module module("RegexCompiler", context);
+			if (!compilePatterns(input, context, module, jit_options, error)) {
+				std::cout << "Invalid regex: " << error << "\n";
+				return 1;
+			}
+
+			llvm::SmallVector<char, 0> object_code;
+			if (!jit->emitObject(module, object_code, error)) {
+				std::cout << "Could not JIT regex: " << error << "\n";
+				return 2;
+			}
+
+			// A cache that can't be written to only means that the next run compiles the regex again
+			if (cache->store(key, object_code, error)) {
+				cache->prune();
+			}
+			object = llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef(object_code.data(), object_code.size()), key);
+		}
 
-	Builder.SetInsertPoint(entry);
-	Builder.CreateBr(readToBuf);
+		if (!jit->addObject(std::move(object), error)) {
+			std::cout << "Could not JIT regex: " << error << "\n";
+			return 2;
+		}
+	} else {
+		std::unique_ptr<llvm::LLVMContext> context = std::make_unique<llvm::LLVMContext>();
+		std::unique_ptr<llvm::Module> module = std::make_unique<llvm::Module>("RegexCompiler", *context);
+		if (!compilePatterns(input, *context, *module, jit_options, error)) {
+			std::cout << "Invalid regex: " << error << "\n";
+			return 1;
+		}
+
+		if (!jit->addModule(std::move(module), std::move(context), error)) {
+			std::cout << "Could not JIT regex: " << error << "\n";
+			return 2;
+		}
+	}
 
-	llvm::BasicBlock* eval_loop = llvm::BasicBlock::Create(context, "eval_loop", main_function);
-	llvm::BasicBlock* eval_consume_and_retry = llvm::BasicBlock::Create(context, "eval_consume_and_retry", main_function);
-	llvm::BasicBlock* eval_reject_char = llvm::BasicBlock::Create(context, "eval_reject_char", main_function);
+	if (input.is_set) {
+		return runJitSet(*jit, input, options, files);
+	}
 
-	llvm::BasicBlock* end = llvm::BasicBlock::Create(context, "end", main_function);
-	Builder.SetInsertPoint(end);
-	llvm::PHINode* resolved_is_accept = Builder.CreatePHI(type_provider.getBit(), regex.size() + 1);
-	resolved_is_accept->addIncoming(constant_provider.getBit(0), eval_reject_char);
+	// Large files are split between the threads if there's more than one, see ParallelScan.h
+	std::unique_ptr<ThreadPool> pool = num_threads > 1 ? std::make_unique<ThreadPool>(num_threads) : nullptr;
+
+	// Finding matches works like grepping: both print what they find and return how many there were
+	if (options.line_mode || options.find_mode) {
+		const char* fd_suffix = options.find_mode ? find_fd_function_suffix : grep_fd_function_suffix;
+		const char* file_suffix = options.find_mode ? find_file_function_suffix : grep_file_function_suffix;
+		GrepFdFunction grep_fd = jit->lookupFunction<GrepFdFunction>(getSymbolName(options.symbol_prefix, fd_suffix).c_str(), error);
+		GrepFileFunction grep_file = grep_fd ? jit->lookupFunction<GrepFileFunction>(getSymbolName(options.symbol_prefix, file_suffix).c_str(), error) : nullptr;
+		if (!grep_file) {
+			std::cout << "Could not JIT regex: " << error << "\n";
+			return 2;
+		}
 
-	Builder.SetInsertPoint(post_loop);
-	Builder.CreateBr(eval_loop);
+		GrepLinesFunction grep_lines = nullptr;
+		CountLinesFunction count_lines = nullptr;
+		if (pool && options.line_mode) {
+			grep_lines = jit->lookupFunction<GrepLinesFunction>(getSymbolName(options.symbol_prefix, grep_lines_function_suffix).c_str(), error);
+			count_lines = grep_lines ? jit->lookupFunction<CountLinesFunction>(getSymbolName(options.symbol_prefix, count_lines_function_suffix).c_str(), error) : nullptr;
+			if (!count_lines) {
+				std::cout << "Could not JIT regex: " << error << "\n";
+				return 2;
+			}
+		}
 
-	Builder.SetInsertPoint(eval_loop);
-	llvm::PHINode* string_start_index = Builder.CreatePHI(type_provider.getInt32(), 0);
-	string_start_index->addIncoming(constant_provider.getInt32(0), post_loop);
-	string_start_index->addIncoming(Builder.CreateAdd(string_start_index, constant_provider.getInt32(1)), eval_consume_and_retry);
+		if (files.empty()) {
+			int64_t result = grep_fd(0, nullptr);
+			if (result < 0) {
+				std::cout << "Could not read stdin\n";
+				return 2;
+			}
 
-	llvm::BasicBlock* first_atom_iter = llvm::BasicBlock::Create(context, "first_atom_iter", main_function);
+			return result ? 0 : 1;
+		}
 
-	Builder.CreateBr(first_atom_iter);
+		bool any_matched = false;
+		for (const std::string& file : files) {
+			const char* name = files.size() > 1 ? file.c_str() : nullptr;
+			std::unique_ptr<llvm::MemoryBuffer> mapping = count_lines ? mapForParallelScan(file) : nullptr;
+			int64_t result = mapping
+				? grepInParallel(*pool, grep_lines, count_lines, mapping->getBufferStart(), mapping->getBufferSize(), name, options.line_options.count_only)
+				: grep_file(file.c_str(), name);
+			if (result < 0) {
+				std::cout << "Could not read " << file << "\n";
+				return 2;
+			}
+
+			any_matched |= result > 0;
+		}
 
-	Builder.SetInsertPoint(eval_consume_and_retry);
-	Builder.CreateBr(eval_loop);
+		return any_matched ? 0 : 1;
+	}
 
-	Builder.SetInsertPoint(first_atom_iter);
-	llvm::Value* num_chars_consumed = constant_provider.getInt32(0);
+	MatchFdFunction match_fd = jit->lookupFunction<MatchFdFunction>(getSymbolName(options.symbol_prefix, match_fd_function_suffix).c_str(), error);
+	MatchFileFunction match_file = match_fd ? jit->lookupFunction<MatchFileFunction>(getSymbolName(options.symbol_prefix, match_file_function_suffix).c_str(), error) : nullptr;
+	if (!match_file) {
+		std::cout << "Could not JIT regex: " << error << "\n";
+		return 2;
+	}
 
-	for(size_t i = 0; i < atoms.size(); i++) {
-		std::unique_ptr<Atom>& atom = atoms[i];
-		llvm::Value* input_index = Builder.CreateAdd(num_chars_consumed, string_start_index);
+	MatchFunction match = nullptr;
+	uint64_t overlap;
+	if (pool && getChunkOverlap(input.regexes[0], options, overlap)) {
+		match = jit->lookupFunction<MatchFunction>(getSymbolName(options.symbol_prefix, match_function_suffix).c_str(), error);
+		if (!match) {
+			std::cout << "Could not JIT regex: " << error << "\n";
+			return 2;
+		}
+	}
 
-		llvm::BasicBlock* atom_iter_body = llvm::BasicBlock::Create(context, "atom_iter_body", main_function);
+	if (files.empty()) {
+		int32_t result = match_fd(0);
+		if (result < 0) {
+			std::cout << "Could not read stdin\n";
+			return 2;
+		}
 
-		Builder.CreateCondBr(Builder.CreateICmpULT(input_index, input_len), atom_iter_body, eval_reject_char);
-		Builder.SetInsertPoint(atom_iter_body);
+		return result ? 0 : 1;
+	}
 
-		auto insert_block = Builder.GetInsertBlock();
-		auto insert_point = Builder.GetInsertPoint();
-		llvm::Function* atom_function = atom->codegen();
-		Builder.SetInsertPoint(insert_block, insert_point);
+	// Files are mapped and matched in place by the generated code, or in chunks on the pool if they're large enough
+	bool any_matched = false;
+	for (const std::string& file : files) {
+		std::unique_ptr<llvm::MemoryBuffer> mapping = match ? mapForParallelScan(file) : nullptr;
+		int32_t result = mapping
+			? matchInParallel(*pool, match, mapping->getBufferStart(), mapping->getBufferSize(), overlap)
+			: match_file(file.c_str());
+		if (result < 0) {
+			std::cout << "Could not read " << file << "\n";
+			return 2;
+		}
 
-		llvm::Value* decision = Builder.CreateCall(
-			atom_function->getFunctionType(),
-			atom_function,
-			std::vector<llvm::Value*> { buf, input_index, input_len }
-		);
-		llvm::Value* is_accept = Builder.CreateICmpNE(
-			Builder.CreateAnd(decision, constant_provider.getInt32(static_cast<int32_t>(AcceptDecision::Accept))),
-			constant_provider.getInt32(0)
-		);
-		llvm::Value* num_chars_to_consume = Builder.CreateAnd(decision, constant_provider.getInt32(static_cast<int32_t>(AcceptDecision::ConsumeMask)));
-		num_chars_consumed = Builder.CreateAdd(num_chars_consumed, num_chars_to_consume);
+		if (result) {
+			any_matched = true;
+			if (files.size() > 1) {
+				std::cout << file << "\n";
+			}
+		}
+	}
 
-		llvm::BasicBlock* next_atom_iter = llvm::BasicBlock::Create(context, "next_atom_iter", main_function);
-		Builder.CreateCondBr(is_accept, next_atom_iter, eval_consume_and_retry);
+	return any_matched ? 0 : 1;
+}
 
-		Builder.SetInsertPoint(next_atom_iter);
+enum class EmitKind {
+	Ir,
+	Object,
+	Library
+};
+
+// Compiles the input and writes it out as the given kind, along with a header unless it's IR
+int runEmit(const PatternInput& input, const CompileOptions& options, const TargetSelection& target, EmitKind emit_kind, std::string output_path) {
+	std::string error;
+	std::unique_ptr<llvm::TargetMachine> target_machine = createTargetMachine(target, error);
+	if (!target_machine) {
+		std::cout << "Could not create target: " << error << "\n";
+		return 2;
 	}
 
-	llvm::BasicBlock* completed = llvm::BasicBlock::Create(context, "completed", main_function);
-	Builder.CreateBr(completed);
+	CompileOptions target_options = options;
+	target_options.has_byte_shuffle = hasByteShuffle(*target_machine);
 
-	Builder.SetInsertPoint(completed);
-	Builder.CreateBr(end);
+	llvm::LLVMContext context;
+	llvm::Module module("RegexCompiler", context);
+	if (!compilePatterns(input, context, module, target_options, error)) {
+		std::cout << "Invalid regex: " << error << "\n";
+		return 1;
+	}
 
-	resolved_is_accept->addIncoming(constant_provider.getBit(1), completed);
+	if (emit_kind == EmitKind::Ir) {
+		if (output_path.empty()) {
+			output_path = "out.ll";
+		}
 
-	Builder.SetInsertPoint(eval_reject_char);
-	Builder.CreateBr(end);
+		if (!emitIrFile(module, *target_machine, target.opt_level, output_path, error)) {
+			std::cout << "Could not write " << output_path << ": " << error << "\n";
+			return 2;
+		}
+
+		return 0;
+	}
 
-	Builder.SetInsertPoint(end);
-	if (regex.size()) {
-		Builder.CreateRet(Builder.CreateIntCast(Builder.CreateNot(resolved_is_accept), type_provider.getInt32(), false));
+	bool emitted;
+	if (emit_kind == EmitKind::Object) {
+		if (output_path.empty()) {
+			output_path = "out.o";
+		}
+		emitted = emitObjectFile(module, *target_machine, target.opt_level, output_path, error);
 	} else {
-		Builder.CreateRet(constant_provider.getInt32(0));
+		if (output_path.empty()) {
+			output_path = "lib" + options.symbol_prefix + ".a";
+		}
+		emitted = emitStaticLibrary(module, *target_machine, target.opt_level, output_path, error);
+	}
+
+	llvm::SmallString<128> header_path(output_path);
+	llvm::sys::path::replace_extension(header_path, "h");
+	if (!emitted) {
+		std::cout << "Could not write " << output_path << ": " << error << "\n";
+		return 2;
+	}
+
+	bool header_emitted = input.is_set
+		? emitSetHeader(input.regexes, options, header_path.str().str(), error)
+		: emitHeader(input.regexes[0], options, header_path.str().str(), error);
+	if (!header_emitted) {
+		std::cout << "Could not write " << output_path << ": " << error << "\n";
+		return 2;
+	}
+
+	return 0;
+}
+
+// Parses a count given as an option, which has to be a decimal number small enough to fit in an unsigned
+bool parseCount(const std::string& text, unsigned& count_out) {
+	if (text.empty() || text.size() > 9) {
+		return false;
+	}
+
+	unsigned count = 0;
+	for (char c : text) {
+		if (c < '0' || c > '9') {
+			return false;
+		}
+		count = count * 10 + static_cast<unsigned>(c - '0');
+	}
+
+	count_out = count;
+	return true;
+}
+
+// LLVM's analyses recurse along chains of DFA states (each of which is a block of code), which for the largest DFAs and pattern set groups takes far
+// more stack than the main thread has, so everything runs on a thread with this much
+const unsigned compile_stack_size = 512 << 20;
+
+// Compiles each regex in a batch separately on a pool of threads, and writes them all to one library with a header
+int runBatch(const std::vector<std::string>& regexes, const CompileOptions& options, const TargetSelection& target, std::string output_path, unsigned num_threads, const ObjectCache* cache) {
+	std::string error;
+	BatchObjects objects;
+	{
+		ThreadPool pool(num_threads, compile_stack_size);
+		if (!compileBatch(pool, regexes, options, target, cache, objects, error)) {
+			std::cout << error << "\n";
+			return 1;
+		}
+	}
+	if (cache) {
+		cache->prune();
 	}
 
-	std::error_code ec;
-	llvm::raw_fd_ostream output("out.ll", ec);
-	module.print(output, nullptr);
+	if (output_path.empty()) {
+		output_path = "lib" + options.symbol_prefix + ".a";
+	}
+	if (!emitBatchLibrary(objects, options.symbol_prefix, output_path, error)) {
+		std::cout << "Could not write " << output_path << ": " << error << "\n";
+		return 2;
+	}
+
+	llvm::SmallString<128> header_path(output_path);
+	llvm::sys::path::replace_extension(header_path, "h");
+	if (!emitBatchHeader(regexes, options, header_path.str().str(), error)) {
+		std::cout << "Could not write " << header_path.str().str() << ": " << error << "\n";
+		return 2;
+	}
 
 	return 0;
 }
+
+int run(int argc, char* argv[]) {
+	bool use_jit = false;
+	EmitKind emit_kind = EmitKind::Ir;
+	std::string output_path;
+	CompileOptions options { default_symbol_prefix, true, false, false, { false, false }, false, { false }, false };
+	TargetSelection target { "", "", default_opt_level };
+	unsigned num_threads = 1;
+	bool options_ended = false;
+	std::vector<std::string> positional;
+	std::string patterns_path;
+	std::string batch_path;
+	std::string cache_path;
+	uint64_t cache_max_size = default_cache_max_size;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (options_ended || arg.rfind("--", 0) != 0) {
+			positional.push_back(arg);
+		} else if (arg == "--") {
+			options_ended = true;
+		} else if (arg == "--jit") {
+			use_jit = true;
+		} else if (arg == "--ignore-case") {
+			options.is_case_insensitive = true;
+		} else if (arg == "--lines") {
+			options.line_mode = true;
+		} else if (arg == "--count") {
+			options.line_mode = true;
+			options.line_options.count_only = true;
+		} else if (arg == "--line-number") {
+			options.line_mode = true;
+			options.line_options.print_line_numbers = true;
+		} else if (arg == "--matches") {
+			options.find_mode = true;
+		} else if (arg == "--count-matches") {
+			options.find_mode = true;
+			options.find_options.count_only = true;
+		} else if ((arg == "--emit" || arg == "--patterns" || arg == "--output" || arg == "--prefix" || arg == "--opt-level" || arg == "--mcpu" || arg == "--march" || arg == "--threads" || arg == "--batch" || arg == "--cache" || arg == "--cache-size") && i + 1 >= argc) {
+			std::cout << "Missing value for " << arg << "\n";
+			return 1;
+		} else if (arg == "--emit") {
+			std::string kind = argv[++i];
+			if (kind == "ir") {
+				emit_kind = EmitKind::Ir;
+			} else if (kind == "obj") {
+				emit_kind = EmitKind::Object;
+			} else if (kind == "lib") {
+				emit_kind = EmitKind::Library;
+			} else {
+				std::cout << "Unknown output kind " << kind << "\n";
+				return 1;
+			}
+		} else if (arg == "--patterns") {
+			patterns_path = argv[++i];
+		} else if (arg == "--batch") {
+			batch_path = argv[++i];
+		} else if (arg == "--cache") {
+			cache_path = argv[++i];
+		} else if (arg == "--cache-size") {
+			std::string size = argv[++i];
+			unsigned mebibytes;
+			if (!parseCount(size, mebibytes)) {
+				std::cout << "Invalid cache size " << size << "\n";
+				return 1;
+			}
+			cache_max_size = uint64_t(mebibytes) << 20;
+		} else if (arg == "--output") {
+			output_path = argv[++i];
+		} else if (arg == "--prefix") {
+			options.symbol_prefix = argv[++i];
+		} else if (arg == "--opt-level") {
+			std::string level = argv[++i];
+			if (level.size() != 1 || level[0] < '0' || level[0] > static_cast<char>('0' + max_opt_level)) {
+				std::cout << "Invalid optimization level " << level << "\n";
+				return 1;
+			}
+			target.opt_level = static_cast<unsigned>(level[0] - '0');
+		} else if (arg == "--mcpu") {
+			target.cpu = argv[++i];
+		} else if (arg == "--march") {
+			target.arch = argv[++i];
+		} else if (arg == "--threads") {
+			std::string count = argv[++i];
+			if (!parseCount(count, num_threads)) {
+				std::cout << "Invalid thread count " << count << "\n";
+				return 1;
+			}
+		} else if (arg == "--help") {
+			printUsage();
+			return 0;
+		} else {
+			std::cout << "Unknown option " << arg << "\n";
+			return 1;
+		}
+	}
+
+	std::unique_ptr<ObjectCache> cache = cache_path.empty() ? nullptr : std::make_unique<ObjectCache>(cache_path, cache_max_size);
+	if (cache && !use_jit && batch_path.empty()) {
+		std::cout << "A cache can only be used with --jit or --batch\n";
+		return 1;
+	}
+
+	if (!batch_path.empty()) {
+		if (use_jit || !patterns_path.empty() || !positional.empty()) {
+			std::cout << "A batch can't be given with --jit, --patterns, a regex or input files\n";
+			return 1;
+		}
+		if (emit_kind != EmitKind::Library) {
+			std::cout << "A batch can only be emitted as a library, with --emit lib\n";
+			return 1;
+		}
+
+		std::vector<std::string> regexes;
+		if (!readPatterns(batch_path, regexes)) {
+			std::cout << "Could not read " << batch_path << "\n";
+			return 1;
+		}
+		options.emit_main = false;
+		return runBatch(regexes, options, target, output_path, resolveThreadCount(num_threads), cache.get());
+	}
+
+	// With a patterns file, all of the positional arguments are input files
+	PatternInput input { {}, !patterns_path.empty() };
+	std::vector<std::string> files;
+	if (input.is_set) {
+		if (!readPatterns(patterns_path, input.regexes)) {
+			std::cout << "Could not read " << patterns_path << "\n";
+			return 1;
+		}
+		files = positional;
+	} else {
+		if(positional.empty()) {
+			std::cout << "Specify a regex\n";
+			return 1;
+		}
+		input.regexes.push_back(positional[0]);
+		files.assign(positional.begin() + 1, positional.end());
+	}
+
+	if (use_jit) {
+		options.emit_main = false;
+		if (target.cpu.empty()) {
+			target.cpu = native_cpu_name;
+		}
+		return runJit(input, options, target, files, resolveThreadCount(num_threads), cache.get());
+	}
+
+	if (!files.empty()) {
+		std::cout << "Input files can only be given with --jit\n";
+		return 1;
+	}
+	if (num_threads != 1) {
+		std::cout << "Threads can only be given with --jit\n";
+		return 1;
+	}
+
+	// Objects and libraries are meant to be linked into other programs, which have their own main
+	options.emit_main = emit_kind == EmitKind::Ir;
+	return runEmit(input, options, target, emit_kind, output_path);
+}
+
+int main(int argc, char* argv[]) {
+	int result = 0;
+	llvm::thread compile_thread(llvm::Optional<unsigned>(compile_stack_size), [&]() {
+		result = run(argc, argv);
+	});
+	compile_thread.join();
+
+	return result;
+}